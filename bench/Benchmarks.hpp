@@ -0,0 +1,6 @@
+#pragma once
+
+void runCpuBenchmark();
+void runMapperBenchmark();
+void runCompositorBenchmark();
+void runPpuDotBenchmark();
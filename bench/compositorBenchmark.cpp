@@ -0,0 +1,81 @@
+#include "Benchmarks.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "NES/PixelCompositor.hpp"
+
+constexpr u32 BENCHMARK_LINE_WIDTH = 256;
+constexpr u32 BENCHMARK_LINES = 240 * 60 * 20;
+
+// Composite 20 s of frames, line by line (as the PPU does on whole scanlines)
+static double runCompositorWorkload(const PixelCompositor& compositor, 
+                                    const std::vector<u8>& bgPixels, 
+                                    const std::vector<u8>& spritePixels, 
+                                    const paletteRgb_t& paletteRgb, 
+                                    std::vector<u8>& rgbOutput)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (u32 line = 0; line < BENCHMARK_LINES; line++)
+	{
+		// Odd lines start unaligned, like the PPU with fine X scrolling
+		u32 offset = line % 8;
+		compositor.composePixels(&bgPixels[offset], &spritePixels[offset], BENCHMARK_LINE_WIDTH - offset, paletteRgb, &rgbOutput[offset * 3]);
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double>(end - start).count();
+}
+
+void runCompositorBenchmark()
+{
+	std::cout << "******** Pixel compositor ********\n";
+
+	// Random pixels & palette (same seed for every implementation)
+	std::default_random_engine generator(0x4E45'5346);
+	std::uniform_int_distribution<u16> distribution(0, 255);
+	std::vector<u8> bgPixels(BENCHMARK_LINE_WIDTH);
+	std::vector<u8> spritePixels(BENCHMARK_LINE_WIDTH);
+	for (u32 i = 0; i < BENCHMARK_LINE_WIDTH; i++)
+	{
+		bgPixels[i] = distribution(generator) & 0x0F;
+		spritePixels[i] = distribution(generator) & 0x7F;
+		if ((spritePixels[i] & 0x03) == 0)
+			spritePixels[i] = 0;
+	}
+
+	paletteRgb_t paletteRgb;
+	for (auto& channel : paletteRgb)
+		for (u8& value : channel)
+			value = (u8)distribution(generator);
+
+	// Scalar implementation is the reference
+	PixelCompositor compositor;
+	compositor.setImplementation(PixelCompositor::Implementation::SCALAR);
+	std::vector<u8> referenceOutput(BENCHMARK_LINE_WIDTH * 3);
+	double scalarSeconds = runCompositorWorkload(compositor, bgPixels, spritePixels, paletteRgb, referenceOutput);
+	std::cout << "SCALAR: " << scalarSeconds * 1e3 << " ms\n";
+
+	const std::pair<PixelCompositor::Implementation, const char*> simdImplementations[] =
+	{
+		{ PixelCompositor::Implementation::SSE2, "SSE2" },
+		{ PixelCompositor::Implementation::AVX2, "AVX2" }
+	};
+	for (const auto& [implementation, name] : simdImplementations)
+	{
+		if (!compositor.setImplementation(implementation))
+		{
+			std::cout << name << ": not supported\n";
+			continue;
+		}
+
+		std::vector<u8> output(BENCHMARK_LINE_WIDTH * 3);
+		double seconds = runCompositorWorkload(compositor, bgPixels, spritePixels, paletteRgb, output);
+		std::cout << name << ": " << seconds * 1e3 << " ms "
+		          << "(x" << scalarSeconds / seconds << ")"
+		          << (output == referenceOutput ? "" : " OUTPUT MISMATCH") << '\n';
+	}
+	std::cout << std::endl;
+}
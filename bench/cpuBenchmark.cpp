@@ -0,0 +1,72 @@
+#include "Benchmarks.hpp"
+
+#include <iostream>
+#include <chrono>
+
+#include "NES/CPU.hpp"
+#include "NES/Memory.hpp"
+
+// Loop over various addressing modes & operations (copy/transform a 256 bytes page)
+//   loop: LDA $0200,X
+//         ADC #$01
+//         STA $0300,X
+//         LDA ($10),Y
+//         EOR $20
+//         STA $20
+//         ASL A
+//         ROR $21
+//         INC $22
+//         INY
+//         INX
+//         BNE loop
+//         JMP loop
+constexpr u8 BENCHMARK_PROGRAM[] =
+{
+	0xBD, 0x00, 0x02,
+	0x69, 0x01,
+	0x9D, 0x00, 0x03,
+	0xB1, 0x10,
+	0x45, 0x20,
+	0x85, 0x20,
+	0x0A,
+	0x66, 0x21,
+	0xE6, 0x22,
+	0xC8,
+	0xE8,
+	0xD0, 0xE9,
+	0x4C, 0x00, 0x80
+};
+
+constexpr s32 BENCHMARK_INSTRUCTIONS = 50'000'000;
+
+void runCpuBenchmark()
+{
+	// Load program
+	static Memory memory;
+	memory.reset();
+	for (u16 i = 0; i < sizeof(BENCHMARK_PROGRAM); i++)
+		memory[TEST_MAIN_ADDRESS + i] = BENCHMARK_PROGRAM[i];
+	memory[0x0010] = 0x00;
+	memory[0x0011] = 0x04;
+	memory[RESET_VECTOR_LSB] = TEST_MAIN_ADDRESS & 0x00FF;
+	memory[RESET_VECTOR_MSB] = (TEST_MAIN_ADDRESS & 0xFF00) >> 8;
+
+	CPU cpu;
+	cpu.reset(memory);
+
+	// Run instructions one by one (as the NES does)
+	s64 elapsedCycles = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (s32 i = 0; i < BENCHMARK_INSTRUCTIONS; i++)
+		elapsedCycles += cpu.execute(1, memory);
+	auto end = std::chrono::steady_clock::now();
+
+	// Results
+	std::cout << "******** CPU ********\n";
+	double seconds = std::chrono::duration<double>(end - start).count();
+	std::cout << "Instructions: " << BENCHMARK_INSTRUCTIONS << '\n'
+	          << "Cycles: " << elapsedCycles << '\n'
+	          << "Time: " << seconds << " s\n"
+	          << "Instructions per second: " << BENCHMARK_INSTRUCTIONS / seconds / 1e6 << " M\n"
+	          << "Emulated CPU speed: " << elapsedCycles / seconds / 1e6 << " MHz (A: " << +cpu.getA() << ')' << std::endl;
+}
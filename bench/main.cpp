@@ -0,0 +1,10 @@
+#include "Benchmarks.hpp"
+
+int main()
+{
+	runCpuBenchmark();
+	runMapperBenchmark();
+	runCompositorBenchmark();
+	runPpuDotBenchmark();
+	return 0;
+}
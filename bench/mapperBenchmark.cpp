@@ -0,0 +1,187 @@
+#include "Benchmarks.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <variant>
+
+#include "NES/Mapper000.hpp"
+#include "NES/Mapper001.hpp"
+#include "NES/Mapper002.hpp"
+#include "NES/Mapper003.hpp"
+#include "NES/Mapper004.hpp"
+
+// Virtual dispatch, as the cartridge used to call its mapper
+class VirtualMapper
+{
+public:
+	virtual ~VirtualMapper() {}
+
+	virtual void reset() = 0;
+	virtual bool mapCpuRead(u16 address, u32& mappedAddress) const = 0;
+	virtual bool mapPpuAddress(u16 address, u32& mappedAddress) const = 0;
+	virtual void processPpuAccess(u16 address, u16 ppuCycleCount) = 0;
+	virtual bool isMonitoringPpuBus() const = 0;
+};
+
+template<typename M>
+class VirtualMapperAdapter : public VirtualMapper
+{
+public:
+	VirtualMapperAdapter(const M& mapper) : mMapper(mapper) {}
+
+	void reset() override { mMapper.reset(); }
+	bool mapCpuRead(u16 address, u32& mappedAddress) const override { return mMapper.mapCpuRead(address, mappedAddress); }
+	bool mapPpuAddress(u16 address, u32& mappedAddress) const override { return mMapper.mapPpuAddress(address, mappedAddress); }
+	void processPpuAccess(u16 address, u16 ppuCycleCount) override { mMapper.processPpuAccess(address, ppuCycleCount); }
+	bool isMonitoringPpuBus() const override { return mMapper.isMonitoringPpuBus(); }
+
+private:
+	M mMapper;
+};
+
+// Bus paths of the virtual dispatch: the same ones for every mapper, which call it through its vtable
+struct virtualCartridge_t
+{
+	VirtualMapper* mapper;
+	bool isMonitoringPpuBus; // Cached, as the cartridge did
+};
+
+static u32 accessVirtualMapperFromCpu(virtualCartridge_t& cartridge, u16 address)
+{
+	u32 mappedAddress = 0;
+	cartridge.mapper->mapCpuRead(address, mappedAddress);
+	return mappedAddress;
+}
+
+static u32 accessVirtualMapperFromPpu(virtualCartridge_t& cartridge, u16 address)
+{
+	u32 mappedAddress = 0;
+	if (cartridge.isMonitoringPpuBus)
+		cartridge.mapper->processPpuAccess(address, (u16)(address % 341));
+	cartridge.mapper->mapPpuAddress(address, mappedAddress);
+	return mappedAddress;
+}
+
+// Static dispatch, as the memory does now: the access is compiled for each mapper
+// and the one of the ROM mapper is chosen once (see MemoryNES)
+using mapperVariant_t = std::variant<Mapper000, Mapper001, Mapper002, Mapper003, Mapper004>;
+
+struct mappingAccesses_t
+{
+	u32 (*cpuAccess)(mapperVariant_t& mappers, u16 address);
+	u32 (*ppuAccess)(mapperVariant_t& mappers, u16 address);
+};
+
+template<typename MapperType>
+static u32 accessMapperFromCpu(mapperVariant_t& mappers, u16 address)
+{
+	u32 mappedAddress = 0;
+	std::get_if<MapperType>(&mappers)->mapCpuRead(address, mappedAddress);
+	return mappedAddress;
+}
+
+template<typename MapperType>
+static u32 accessMapperFromPpu(mapperVariant_t& mappers, u16 address)
+{
+	MapperType& mapper = *std::get_if<MapperType>(&mappers);
+	u32 mappedAddress = 0;
+	mapper.processPpuAccess(address, (u16)(address % 341));
+	mapper.mapPpuAddress(address, mappedAddress);
+	return mappedAddress;
+}
+
+constexpr u8 BENCHMARK_PRG_NUM_BANKS = 16;
+constexpr u8 BENCHMARK_CHR_NUM_BANKS = 16;
+constexpr s32 BENCHMARK_ITERATIONS = 500;
+constexpr s32 BENCHMARK_RUNS = 4; // Fastest run of each dispatch (they alternate)
+
+static mapperVariant_t makeMapper(u8 mapperNum)
+{
+	switch (mapperNum)
+	{
+		case 0:  return Mapper000(BENCHMARK_PRG_NUM_BANKS, BENCHMARK_CHR_NUM_BANKS, NametableArrangement::VERT);
+		case 1:  return Mapper001(BENCHMARK_PRG_NUM_BANKS, BENCHMARK_CHR_NUM_BANKS);
+		case 2:  return Mapper002(BENCHMARK_PRG_NUM_BANKS, BENCHMARK_CHR_NUM_BANKS, NametableArrangement::VERT);
+		case 3:  return Mapper003(BENCHMARK_PRG_NUM_BANKS, BENCHMARK_CHR_NUM_BANKS, NametableArrangement::VERT);
+		default: return Mapper004(BENCHMARK_PRG_NUM_BANKS, BENCHMARK_CHR_NUM_BANKS, NametableArrangement::VERT);
+	}
+}
+
+// Same workload for both dispatches: map the whole cartridge space, then a PPU frame worth of fetches
+template<typename CpuMapping, typename PpuMapping>
+static u32 runMappingWorkload(CpuMapping&& cpuMapping, PpuMapping&& ppuMapping, double& seconds)
+{
+	auto start = std::chrono::steady_clock::now();
+	u32 checksum = 0;
+	for (s32 i = 0; i < BENCHMARK_ITERATIONS; i++)
+	{
+		for (u32 address = 0x6000; address < 0x10000; address++)
+			checksum += cpuMapping((u16)address);
+
+		for (u32 fetch = 0; fetch < 0x8000; fetch++)
+			checksum += ppuMapping((u16)(fetch & 0x1FFF));
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	seconds = std::min(seconds, std::chrono::duration<double>(end - start).count());
+	return checksum;
+}
+
+void runMapperBenchmark()
+{
+	std::cout << "******** Mappers ********\n";
+
+	// The mapper is chosen at runtime, like a ROM would
+	volatile u8 firstMapperNum = 0;
+	for (u8 mapperNum = firstMapperNum; mapperNum <= 4; mapperNum++)
+	{
+		// Virtual dispatch
+		std::unique_ptr<VirtualMapper> virtualMapper = std::visit([](const auto& mapper) -> std::unique_ptr<VirtualMapper>
+		{
+			using mapperType_t = std::decay_t<decltype(mapper)>;
+			return std::make_unique<VirtualMapperAdapter<mapperType_t>>(mapper);
+		}, makeMapper(mapperNum));
+		virtualMapper->reset();
+
+		// Bus paths called out of line, as the PPU & CPU call the memory (the pointers are not folded)
+		virtualCartridge_t virtualCartridge = { virtualMapper.get(), virtualMapper->isMonitoringPpuBus() };
+		u32 (*volatile virtualCpuAccess)(virtualCartridge_t&, u16) = &accessVirtualMapperFromCpu;
+		u32 (*volatile virtualPpuAccess)(virtualCartridge_t&, u16) = &accessVirtualMapperFromPpu;
+		auto virtualCpuMapping = [&, cpuAccess = virtualCpuAccess](u16 address) { return cpuAccess(virtualCartridge, address); };
+		auto virtualPpuMapping = [&, ppuAccess = virtualPpuAccess](u16 address) { return ppuAccess(virtualCartridge, address); };
+
+		// Static dispatch
+		mapperVariant_t variantMapper = makeMapper(mapperNum);
+		std::visit([](auto& mapper) { mapper.reset(); }, variantMapper);
+
+		// Visited once, then one call per access through the chosen pointers (as MemoryNES::ppuRead, ...)
+		mappingAccesses_t accesses = std::visit([](auto& mapper) -> mappingAccesses_t
+		{
+			using mapperType_t = std::decay_t<decltype(mapper)>;
+			return { &accessMapperFromCpu<mapperType_t>, &accessMapperFromPpu<mapperType_t> };
+		}, variantMapper);
+		auto variantCpuMapping = [&](u16 address) { return accesses.cpuAccess(variantMapper, address); };
+		auto variantPpuMapping = [&](u16 address) { return accesses.ppuAccess(variantMapper, address); };
+
+		double virtualSeconds = std::numeric_limits<double>::max();
+		double variantSeconds = std::numeric_limits<double>::max();
+		u32 virtualChecksum = 0;
+		u32 variantChecksum = 0;
+		for (s32 run = 0; run < BENCHMARK_RUNS; run++)
+		{
+			virtualChecksum = runMappingWorkload(virtualCpuMapping, virtualPpuMapping, virtualSeconds);
+			variantChecksum = runMappingWorkload(variantCpuMapping, variantPpuMapping, variantSeconds);
+		}
+
+		// Results
+		std::cout << "Mapper " << +mapperNum << ": "
+		          << "virtual " << virtualSeconds * 1e3 << " ms, "
+		          << "variant " << variantSeconds * 1e3 << " ms "
+		          << "(x" << virtualSeconds / variantSeconds << ")"
+		          << (virtualChecksum == variantChecksum ? "" : " CHECKSUM MISMATCH") << '\n';
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,92 @@
+#include "Benchmarks.hpp"
+
+#include <iostream>
+#include <chrono>
+
+#include "NES/PPUDotActions.hpp"
+
+constexpr u32 BENCHMARK_FRAMES = 60 * 10;
+
+// Range & modulo checks on every dot, as the PPU used to decode its dots
+static dotActions_t decodeDotActions(u16 scanline, u16 dot)
+{
+	return computeDotActions(computeScanlineType(scanline), dot);
+}
+
+// Stand-in for the PPU work of a dot (same for both dispatches)
+struct DotWorkload
+{
+	u32 fetchCount = 0;
+	u32 renderedTileCount = 0;
+	u16 v = 0;
+	u16 t = 0;
+	u32 spriteWorkCount = 0;
+
+	inline void execute(dotActions_t actions)
+	{
+		if ((actions & DOT_BG_FETCH_ACTIONS) != 0)
+			fetchCount++;
+		if ((actions & DOT_RENDER_TILE) != 0)
+			renderedTileCount++;
+		if ((actions & DOT_INC_X) != 0)
+			v = (v & ~0x001F) | ((v + 1) & 0x001F);
+		if ((actions & DOT_INC_Y) != 0)
+			v += 0x1000;
+		if ((actions & DOT_COPY_X) != 0)
+			v = (v & ~0x041F) | (t & 0x041F);
+		if ((actions & DOT_COPY_Y) != 0)
+			v = (v & 0x041F) | (t & ~0x041F);
+		if ((actions & DOT_SPRITE_ACTIONS) != 0)
+			spriteWorkCount++;
+		if ((actions & DOT_FRAME_START) != 0)
+			t += 0x0421;
+	}
+
+	inline u32 getChecksum() const { return fetchCount * 31 + renderedTileCount * 17 + v + spriteWorkCount; }
+};
+
+template<typename Dispatch>
+static u32 runDotWorkload(Dispatch&& dispatch)
+{
+	DotWorkload workload;
+	for (u32 frame = 0; frame < BENCHMARK_FRAMES; frame++)
+		for (u16 scanline = 0; scanline < PPU_SCANLINES_PER_FRAME; scanline++)
+			for (u16 dot = 0; dot < PPU_DOTS_PER_SCANLINE; dot++)
+				workload.execute(dispatch(scanline, dot));
+
+	return workload.getChecksum();
+}
+
+void runPpuDotBenchmark()
+{
+	std::cout << "******** PPU dot dispatch ********\n";
+
+	// Decoding & table must agree on every dot of a frame
+	u32 mismatchCount = 0;
+	for (u16 scanline = 0; scanline < PPU_SCANLINES_PER_FRAME; scanline++)
+		for (u16 dot = 0; dot < PPU_DOTS_PER_SCANLINE; dot++)
+			if (decodeDotActions(scanline, dot) != getScanlineDotActions(scanline)[dot])
+				mismatchCount++;
+
+	// Decoding (the scanline may change on every dot, so it can't be hoisted by the compiler)
+	volatile u16 firstScanline = 0;
+	auto start = std::chrono::steady_clock::now();
+	u32 decodedChecksum = runDotWorkload([&](u16 scanline, u16 dot) { return decodeDotActions(scanline + firstScanline, dot); });
+	auto end = std::chrono::steady_clock::now();
+	double decodedSeconds = std::chrono::duration<double>(end - start).count();
+
+	// Table lookup
+	start = std::chrono::steady_clock::now();
+	u32 tableChecksum = runDotWorkload([&](u16 scanline, u16 dot) { return getScanlineDotActions(scanline + firstScanline)[dot]; });
+	end = std::chrono::steady_clock::now();
+	double tableSeconds = std::chrono::duration<double>(end - start).count();
+
+	// Results
+	constexpr double DOTS = (double)BENCHMARK_FRAMES * PPU_SCANLINES_PER_FRAME * PPU_DOTS_PER_SCANLINE;
+	std::cout << "Decoded: " << DOTS / decodedSeconds * 1e-6 << " Mdots/s\n"
+	          << "Table:   " << DOTS / tableSeconds * 1e-6 << " Mdots/s "
+	          << "(x" << decodedSeconds / tableSeconds << ")"
+	          << (decodedChecksum == tableChecksum ? "" : " CHECKSUM MISMATCH")
+	          << (mismatchCount == 0 ? "" : " TABLE MISMATCH") << '\n';
+	std::cout << std::endl;
+}
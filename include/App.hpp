@@ -1,12 +1,50 @@
 #pragma once
 
 #include <string>
+#include <atomic>
 #include <chrono>
 
 #include "NES/NES.hpp"
 #include "NES/Controller.hpp"
 #include "IO/GlfwApp.hpp"
 #include "IO/SoundManager.hpp"
+#include "FramePacer.hpp"
+#include "RewindBuffer.hpp"
+#include "TripleBuffer.hpp"
+
+// App thread -> emulation thread
+struct emulationSettings_t
+{
+	bool isPaused;
+	PictureFormat pictureFormat;
+	u32 renderingThreadCount;
+	u32 runAheadFrameCount;
+	bool isRewindEnabled;
+	bool isRewinding;
+	u64 rewindMemoryBudget;
+	float masterVolume;
+	PacingSource pacingSource;
+	u32 soundBufferSize;
+	u32 soundBufferCount;
+};
+
+// Emulation thread -> app thread
+struct emulationStats_t
+{
+	framePacingStats_t framePacing;
+	u32 soundQueueDepth;
+	u32 soundLatency;
+	u32 soundUnderrunCount;
+	double soundSampleRateRatio;
+	rewindStats_t rewind;
+};
+
+struct videoFrame_t
+{
+	PictureFormat format;
+	picture_t picture;
+	indexedPicture_t indexedPicture;
+};
 
 class App
 {
@@ -26,13 +64,38 @@ private:
 	void processIdleState(GlfwApp& appWindow);
 	void showErrorWindow(GlfwApp& appWindow);
 	void playGame(GlfwApp& appWindow);
-	void sendPictureToWindow(GlfwApp& appWindow, const picture_t& picture);
-	void linkFifosToWindow(NES& nes, GlfwApp& window);
+	void publishSettings(GlfwApp& appWindow);
+	void waitForFrame(GlfwApp& appWindow);
+	void drawFrame(GlfwApp& appWindow, const videoFrame_t& frame);
+	void updateSoundTaps(GlfwApp& appWindow, NES& nes);
+
+	// Emulation thread
+	void runEmulation(NES& nes);
+	void applySettings(NES& nes, const emulationSettings_t& settings);
+	void publishFrame(NES& nes);
+	void publishStats();
+	void updateFrameSkip(NES& nes);
+	void rewindFrame(NES& nes);
 
 	Controller mController1;
 	Controller mController2;
 	SoundManager mSoundManager;
+	FramePacer mFramePacer;
+
+	// The app thread polls the inputs & draws the UI, the emulation runs on its own thread
+	static constexpr std::chrono::microseconds FRAME_POLL_PERIOD{ 250 };
+	std::atomic<bool> mIsEmulationRunning;
+	TripleBuffer<emulationSettings_t> mSettings;
+	TripleBuffer<emulationStats_t> mStats;
+	TripleBuffer<videoFrame_t> mFrames;
+
+	// Adaptive frame skip: frames are emulated without rendering while the host is behind real time
+	static constexpr u8 MAX_SKIPPED_FRAMES = 4;
+	u8 mFramesToSkip;
+	u8 mSkippedFrameCount;
 
-	std::chrono::steady_clock::time_point mTimePrevious;
-	double mElapsedTimeOffset;
+	// Rewind: a snapshot per frame, the sound of the rewound frames is played backwards
+	RewindBuffer mRewindBuffer;
+	bool mIsRewindEnabled;
+	std::vector<float> mReversedSoundSamples;
 };
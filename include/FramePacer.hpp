@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "NES/Config.hpp"
+#include "IO/SoundManager.hpp"
+
+// Clock the frames are paced on
+enum class PacingSource : u8
+{
+	TIMER,  // Sleep most of the frame period, spin the end of it
+	VSYNC,  // Wait for the app thread to present a frame (its buffer swap waits for the display)
+	AUDIO,  // Wait for the sound queue to need a frame of samples
+	COUNT
+};
+
+struct framePacingStats_t
+{
+	double meanIntervalMs;  // Time per frame (skipped frames included)
+	double jitterMs;        // Standard deviation of the interval error
+	double maxErrorMs;      // Largest interval error
+	double spinMs;          // Spin duration at the end of the timer waits
+};
+
+class FramePacer
+{
+public:
+	FramePacer(double framePeriod, const SoundManager& soundManager);
+
+	void reset();
+	inline void setSource(PacingSource source) { mSource = source; }
+	inline PacingSource getSource() const { return mSource; }
+
+	// Waits for the end of the frames since the last wait, returns the delay behind the timer (seconds)
+	double waitForFrames(u32 frameCount);
+
+	// Paused or idle app (timer only)
+	void waitForIdleFrame();
+
+	// App thread (VSync)
+	inline void signalFramePresented() { mPresentedFrameCount.fetch_add(1, std::memory_order_release); }
+
+	inline const framePacingStats_t& getStats() const { return mStats; }
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	// The OS may wake a thread up late: the end of a wait is spun
+	static constexpr std::chrono::microseconds MIN_SPIN_DURATION{ 1'000 };
+	static constexpr double SPIN_DURATION_DECAY = 0.95;
+	// Frames waited for the sound queue or a presented frame before giving up 
+	// (no audio device, stream restart, app thread stalled)
+	static constexpr u32 MAX_WAIT_FRAMES = 4;
+	static constexpr std::chrono::microseconds PRESENT_POLL_PERIOD{ 250 };
+	// Delay behind the timer which is not caught up (seconds)
+	static constexpr double MAX_CAUGHT_UP_DELAY = 0.1;
+	static constexpr u32 STATS_HISTORY_SIZE = 120;
+
+	void waitUntil(clock::time_point deadline);
+	void waitForSoundQueue();
+	void waitForPresentedFrame();
+	void updateStats(clock::time_point now, u32 frameCount);
+
+	const SoundManager& mSoundManager;
+	PacingSource mSource;
+	clock::duration mFramePeriod;
+	clock::time_point mNextFrameTime;
+	clock::time_point mPreviousFrameTime;
+	clock::duration mSpinDuration;
+	bool mIsSoundQueueStalled; // The frames are paced by the timer until the audio thread drains the queue
+	std::atomic<u32> mPresentedFrameCount;
+	u32 mLastPresentedFrameCount;
+
+	// Interval errors (ms) of the last frames
+	std::array<double, STATS_HISTORY_SIZE> mIntervalErrors;
+	std::array<double, STATS_HISTORY_SIZE> mIntervals;
+	u32 mStatsIdx;
+	u32 mStatsCount;
+	framePacingStats_t mStats;
+};
@@ -5,12 +5,16 @@
 #include <memory>
 #include <string>
 #include <array>
+#include <atomic>
 #include <deque>
 
 #include "IO/Shader.hpp"
 #include "IO/SoundManager.hpp"
+#include "IO/SoundTaps.hpp"
 #include "NES/PPU.hpp"
 #include "NES/Controller.hpp"
+#include "FramePacer.hpp"
+#include "RewindBuffer.hpp"
 
 using timeArray_t = std::array<float, BUFFER_SIZE / 2>;
 
@@ -36,6 +40,7 @@ public:
     ~GlfwApp();
 
     void draw(const picture_t& pictureBuffer);
+    void draw(const indexedPicture_t& indexedPictureBuffer);
     bool drawError();
 
     void openFile();
@@ -49,20 +54,38 @@ public:
     inline const std::string& getRomName() const { return mPathToRom; }
 
     inline float getMasterVolume() const { return mMasterVolume; }
+    inline u32 getSoundBufferSize() const { return SoundManager::MIN_STREAM_BUFFER_SIZE << mSoundBufferSizeIdx; }
+    inline u32 getSoundBufferCount() const { return (u32)mSoundBufferCount; }
+    inline void setSoundStreamStats(u32 queueDepth, u32 latency, u32 underrunCount, double sampleRateRatio) 
+    { 
+        mSoundQueueDepth = queueDepth; 
+        mSoundLatency = latency;
+        mSoundUnderrunCount = underrunCount; 
+        mSoundSampleRateRatio = sampleRateRatio;
+    }
     inline bool isSoundChannelsWindowOpen() const { return mIsSoundChannelsWindowOpen; }
     inline bool isSpectrumWindowOpen() const { return mIsSpectrumWindowOpen; }
-    inline void setSoundFIFOPtr(const soundFIFO_t* const ptr) { mSoundFIFOPtr = ptr; }
-    inline void setP1FIFOPtr(const soundFIFO_t* const ptr) { mP1FIFOPtr = ptr; }
-    inline void setP2FIFOPtr(const soundFIFO_t* const ptr) { mP2FIFOPtr = ptr; }
-    inline void setTriangleFIFOPtr(const soundFIFO_t* const ptr) { mTriangleFIFOPtr = ptr; }
-    inline void setNoiseFIFOPtr(const soundFIFO_t* const ptr) { mNoiseFIFOPtr = ptr; }
-    inline void setDmcFIFOPtr(const soundFIFO_t* const ptr) { mDmcFIFOPtr = ptr; }
+    inline void setSoundTapsPtr(const SoundTaps* const ptr) { mSoundTapsPtr = ptr; }
+    inline PictureFormat getPictureFormat() const { return mPictureFormat; }
+    inline u32 getRenderingThreadCount() const { return (u32)mRenderingThreadCount; }
+    inline PacingSource getPacingSource() const { return mPacingSource; }
+    inline u32 getRunAheadFrameCount() const { return (u32)mRunAheadFrameCount; }
+    inline bool isRewindEnabled() const { return mIsRewindEnabled; }
+    inline bool isRewinding() const { return mIsRewinding; }
+    inline u64 getRewindMemoryBudget() const { return (u64)mRewindMemoryBudgetMB << 20; }
+    inline void setRewindStats(const rewindStats_t& stats) { mRewindStats = stats; }
+    inline void setFramePacingStats(const framePacingStats_t& stats) { mFramePacingStats = stats; }
     inline bool isPaused() const { return mIsPaused; }
     inline void switchPauseState() { mIsPaused = !mIsPaused; }
 
     inline keycode_t* getKeyToChange() { return mKeyToChange; }
     inline void clearKeyToChange() { mKeyToChange = nullptr; }
 
+    // Inputs (polled by every draw, & between draws with late polling)
+    void pollInputs();
+    inline bool isLateInputPollingEnabled() const { return mIsLateInputPollingEnabled; }
+    u8 getLatestControllerState(bool isPlayer1); // NES thread, when the game strobes the controllers
+
     inline void setHeaderInfo(const std::string& headerInfo) { mHeaderInfo = headerInfo; }
     inline void setErrorMessage(const std::string& errorMessage) { mErrorMessage = errorMessage; }
 
@@ -75,7 +98,10 @@ private:
     void initVao();
     void initShader();
     void initTexture(GLuint& textureObject);
-    void initFbo();
+    void initIndexedTextures();
+    void initFbo(GLuint& fboObject, GLuint textureObject);
+
+    void drawFrame();
 
     // Main menu bar
     void drawMainMenuBar();
@@ -116,15 +142,11 @@ private:
     bool mIsFrameTimeWindowOpen;
     std::deque<float> mFrameTimeHistoryDeque;
     std::array<float, FRAMETIME_HISTORY_MAXSIZE> mFrameTimeHistoryArray;
+    framePacingStats_t mFramePacingStats;
 
     bool mIsSoundChannelsWindowOpen;
     timeArray_t mTimeArray;
-    const soundFIFO_t* mSoundFIFOPtr;
-    const soundFIFO_t* mP1FIFOPtr;
-    const soundFIFO_t* mP2FIFOPtr;
-    const soundFIFO_t* mTriangleFIFOPtr;
-    const soundFIFO_t* mNoiseFIFOPtr;
-    const soundFIFO_t* mDmcFIFOPtr;
+    const SoundTaps* mSoundTapsPtr;
     
     bool mIsSpectrumWindowOpen;
     bool mIsLogScale;
@@ -132,6 +154,20 @@ private:
 
     bool mIsAudioSettingsWindowOpen;
     float mMasterVolume;
+    static constexpr const char* SOUND_BUFFER_SIZE_ITEMS[] = 
+    {
+        "128",
+        "256",
+        "512",
+        "1024",
+        "2048"
+    };
+    int mSoundBufferSizeIdx;
+    int mSoundBufferCount;
+    u32 mSoundQueueDepth;
+    u32 mSoundLatency;
+    u32 mSoundUnderrunCount;
+    double mSoundSampleRateRatio;
 
     bool mIsVideoSettingsWindowOpen;
     static constexpr const char* FILTERING_ITEMS[] = 
@@ -151,6 +187,22 @@ private:
     };
     const char* mCurrentShaderStr;
     std::string mShaderErrorMessage;
+    static constexpr const char* OUTPUT_ITEMS[] = 
+    {
+        "RGB",
+        "Indexed (GPU palette)"
+    };
+    PictureFormat mPictureFormat;
+    int mRenderingThreadCount;
+    static constexpr const char* PACING_ITEMS[] = 
+    {
+        "Timer",
+        "VSync",
+        "Audio clock"
+    };
+    PacingSource mPacingSource;
+    static constexpr int MAX_RUN_AHEAD_FRAMES = 4;
+    int mRunAheadFrameCount;
     
     bool mIsInputSettingsWindowOpen;
     bool mIsKeyboardEnabled;
@@ -198,10 +250,37 @@ private:
     GLuint mScreenTexture;
     std::unique_ptr<Shader> mScreenShader;
 
+    // Indexed output: palette applied into the pixel texture
+    GLuint mPaletteFbo;
+    GLuint mIndexedPixelTexture;
+    GLuint mPaletteTexture;
+    std::unique_ptr<Shader> mPaletteShader;
+
     Controller& mController1Ref;
     Controller& mController2Ref;
     uint8_t mController1State;
     uint8_t mController2State;
 
+    // Late input polling: latest inputs snapshot & input to strobe latency
+    static constexpr float INPUT_LATENCY_SMOOTHING = 0.1f;
+    bool mIsLateInputPollingEnabled;
+    std::atomic<u8> mController1Snapshot;
+    std::atomic<u8> mController2Snapshot;
+    std::atomic<u32> mInputChangeCount;
+    std::atomic<s64> mInputChangeTime; // ns (estimated: between the 2 polls which saw it)
+    s64 mLastInputPollTime;
+    u32 mStrobedInputChangeCount;
+    std::atomic<float> mInputLatencyMs;
+    std::atomic<float> mInputLatencyAverageMs;
+
+    // Rewind (while the key is held)
+    static constexpr int REWIND_KEY = GLFW_KEY_BACKSPACE;
+    static constexpr int MIN_REWIND_MEMORY_BUDGET_MB = 4;
+    static constexpr int MAX_REWIND_MEMORY_BUDGET_MB = 256;
+    bool mIsRewindEnabled;
+    bool mIsRewinding;
+    int mRewindMemoryBudgetMB;
+    rewindStats_t mRewindStats;
+
     bool mIsPaused;
 };
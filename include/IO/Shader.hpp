@@ -51,6 +51,27 @@ constexpr const char FRAG_SHADER_DEFAULT[] =
 "    fragColor = vec4(texture(screenTexture, texCoords).rgb, 1.0f);\n"
 "}";
 
+// Indexed picture to RGB: palette lookup & NTSC colour emphasis (non-emphasized channels attenuated)
+constexpr const char FRAG_SHADER_PALETTE[] =
+"#version 460 core\n"
+"out vec4 fragColor;\n"
+"uniform usampler2D indexedTexture;\n"
+"uniform sampler2D paletteTexture;\n"
+"const float EMPHASIS_ATTENUATION = 0.816;\n"
+"void main()\n"
+"{\n"
+"    uint pixel = texelFetch(indexedTexture, ivec2(gl_FragCoord.xy), 0).r;\n"
+"    uint colorCode = pixel & 0x3Fu;\n"
+"    uint emphasis = (pixel >> 6u) & 0x07u;\n"
+"    vec3 color = texelFetch(paletteTexture, ivec2(colorCode, 0), 0).rgb;\n"
+"    if ((colorCode & 0x0Eu) != 0x0Eu)\n"
+"    {\n"
+"        bvec3 isAttenuated = notEqual(uvec3(emphasis) & uvec3(6u, 5u, 3u), uvec3(0u));\n"
+"        color *= mix(vec3(1.0), vec3(EMPHASIS_ATTENUATION), vec3(isAttenuated));\n"
+"    }\n"
+"    fragColor = vec4(color, 1.0);\n"
+"}";
+
 constexpr const char FRAG_SHADER_NEGATIVE[] =
 "#version 460 core\n"
 "in vec2 texCoords;\n"
@@ -2,40 +2,86 @@
 
 #include <al.h>
 #include <array>
-#include <deque>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #include "NES/Config.hpp"
+#include "IO/SoundQueue.hpp"
 
 constexpr u32     BUFFER_SIZE   = 1 << 11;
 constexpr ALenum  BUFFER_FORMAT = AL_FORMAT_MONO8;
 constexpr ALsizei BUFFER_SAMPLE_RATE   = 44'100;
 constexpr float BUFFER_SAMPLE_PERIOD   = 1.0f / BUFFER_SAMPLE_RATE; 
 
-using soundFIFO_t = std::deque<float>;
-using soundBuffer_t = std::array<u8, BUFFER_SIZE>;
 using soundBufferF32_t = std::array<float, BUFFER_SIZE>;
 
-enum class StreamStatus
-{
-	QUEUED,
-	NOT_QUEUED
-};
-
 class SoundManager
 {
 public:
+	SoundManager();
 	int initialise();
 	~SoundManager();
 
-	StreamStatus streamSound(const soundBufferF32_t& soundBuffer);
+	// Samples are queued by the emulation, the audio thread streams them by buffers
+	u32 pushSamples(const float* samples, u32 sampleCount);
+	void setStreamBuffers(u32 bufferSize, u32 bufferCount);
+
+	// Dynamic rate control: ratio to apply to the sample rate of the emulation
+	// (disabled when the audio clock paces the frames)
+	inline double getSampleRateRatio() const { return mIsRateControlEnabled ? mSampleRateRatio : 1.0; }
+	inline void setRateControlEnabled(bool isEnabled) { mIsRateControlEnabled = isEnabled; }
+
+	// The queue is at its target depth after a push, the next frame of samples is needed below that
+	inline u32 getTargetQueueDepth() const { return FRAME_SAMPLES + mBufferSize; }
+	inline bool needsSamples() const { return getQueueDepth() + FRAME_SAMPLES <= getTargetQueueDepth(); }
+
+	// Stream statistics
+	inline u32 getQueueDepth() const { return mQueue.getDepth(); }
+	inline u32 getUnderrunCount() const { return mUnderrunCount.load(std::memory_order_relaxed); }
+	inline u32 getLatency() const { return getQueueDepth() + mBufferSize * mBufferCount; } // Samples (upper bound)
+
+	static constexpr u32 MIN_STREAM_BUFFER_SIZE = 128;
+	static constexpr u32 MAX_STREAM_BUFFER_SIZE = BUFFER_SIZE;
+	static constexpr u32 MIN_STREAM_BUFFER_COUNT = 2;
+	static constexpr u32 MAX_STREAM_BUFFER_COUNT = 8;
 
 private:
+	void startStream();
+	void stopStream();
+	void runStream();
+	void fillBuffer(ALuint buffer);
 	void checkError();
-	void convertBuffer(const soundBufferF32_t &buffer, soundBuffer_t& byteBuffer);
+	void convertBuffer(const float* buffer, u8* byteBuffer, u32 sampleCount);
 	
-	// Buffers
-	static constexpr u8 NUM_BUFFERS = 3;
-	std::array<ALuint, NUM_BUFFERS> mBuffers;
+	// Sample queue (~370 ms)
+	static constexpr u32 QUEUE_CAPACITY_LOG2 = 14;
+	SoundQueue mQueue;
+
+	// Dynamic rate control (PI): the queue depth after a push is kept at a frame of samples + a buffer,
+	// the host clocks (video & audio) drift by much less than MAX_RATE_DEVIATION
+	static constexpr u32 FRAME_SAMPLES = BUFFER_SAMPLE_RATE / 60;
+	static constexpr double MAX_RATE_DEVIATION = 0.0005;
+	static constexpr double RATE_INTEGRAL_GAIN = 0.000001; // By push
+	static constexpr double QUEUE_DEPTH_SMOOTHING = 0.05;
+	void updateSampleRateRatio();
+	bool mIsRateControlEnabled;
+	double mSampleRateRatio;
+	double mRateDeviationIntegral;
+	double mQueueDepthAverage;
+
+	// Buffers (default: 3 x 512 samples ~ 35 ms)
+	u32 mBufferSize;
+	u32 mBufferCount;
+	std::vector<ALuint> mBuffers;
+	std::vector<float> mStreamSamples;
+	std::vector<u8> mStreamBytes;
 
 	ALuint mSource;
+	bool mIsInitialised;
+
+	// Audio thread
+	std::thread mStreamThread;
+	std::atomic<bool> mIsStreaming;
+	std::atomic<u32> mUnderrunCount;
 };
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "NES/Config.hpp"
+
+/// @brief Lock-free single-producer single-consumer queue of sound samples
+///
+/// The emulation pushes the samples, the audio stream pops them.
+/// Indexes run freely (the capacity is a power of 2), the write index is published
+/// with release ordering once the samples are written, the read index once they are read.
+class SoundQueue
+{
+public:
+	explicit SoundQueue(u32 capacityLog2);
+
+	// Producer: returns the number of samples pushed (the queue may be full)
+	u32 push(const float* samples, u32 sampleCount);
+
+	// Consumer: returns the number of samples popped
+	u32 pop(float* samples, u32 sampleCount);
+
+	inline u32 getCapacity() const { return mCapacity; }
+	inline u32 getDepth() const
+	{
+		return mWriteIdx.load(std::memory_order_acquire) - mReadIdx.load(std::memory_order_acquire);
+	}
+
+private:
+	std::unique_ptr<float[]> mSamples;
+	u32 mCapacity;
+	u32 mIdxMask;
+
+	// Not on the same cache line (written by different threads)
+	alignas(64) std::atomic<u32> mWriteIdx;
+	alignas(64) std::atomic<u32> mReadIdx;
+};
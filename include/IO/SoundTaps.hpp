@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include "NES/Config.hpp"
+#include "IO/SoundManager.hpp"
+
+// Sound signals that can be plotted
+enum class SoundTap : u8
+{
+	OUTPUT,
+	PULSE1,
+	PULSE2,
+	TRIANGLE,
+	NOISE,
+	DMC,
+	COUNT
+};
+
+/// @brief Fixed-capacity single-producer single-consumer rings of the sound taps
+///
+/// The emulation pushes samples, the visualizers copy the last SNAPSHOT_SIZE samples.
+/// All rings share one allocation. Every sample is written twice (i and i + CAPACITY)
+/// so the last samples are always contiguous.
+/// The producer announces a write (reserved count) before touching the ring and publishes
+/// it (written count) after. A copy is kept if the producer did not reserve more than
+/// CAPACITY - SNAPSHOT_SIZE samples past the copied ones while it was read (seqlock).
+/// Taps are only filled while they are subscribed.
+class SoundTaps
+{
+public:
+	static constexpr u32 SNAPSHOT_SIZE = BUFFER_SIZE;
+	static constexpr u32 CAPACITY = 2 * SNAPSHOT_SIZE;
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "The sample counts wrap around: CAPACITY must be a power of 2");
+	static_assert(std::atomic<float>::is_always_lock_free, "Samples are shared between the emulation and the UI");
+
+	SoundTaps();
+
+	void clear();
+
+	// Consumer
+	void setSubscribed(SoundTap tap, bool isSubscribed);
+	// Returns false if the producer kept overwriting the samples being copied
+	bool copySnapshot(SoundTap tap, soundBufferF32_t& snapshot) const;
+
+	// Producer
+	inline bool isSubscribed(SoundTap tap) const { return mIsSubscribed[(u8)tap].load(std::memory_order_relaxed); }
+	inline bool isAnyChannelSubscribed() const
+	{
+		return isSubscribed(SoundTap::PULSE1) || isSubscribed(SoundTap::PULSE2) || isSubscribed(SoundTap::TRIANGLE) ||
+		       isSubscribed(SoundTap::NOISE) || isSubscribed(SoundTap::DMC);
+	}
+	inline void push(SoundTap tap, float sample)
+	{
+		std::atomic<float>* ring = getRing(tap);
+		u32 writtenCount = mWrittenCount[(u8)tap].load(std::memory_order_relaxed);
+		mReservedCount[(u8)tap].store(writtenCount + 1, std::memory_order_relaxed);
+
+		u32 writeIdx = writtenCount % CAPACITY;
+		ring[writeIdx].store(sample, std::memory_order_release);
+		ring[writeIdx + CAPACITY].store(sample, std::memory_order_release);
+		mWrittenCount[(u8)tap].store(writtenCount + 1, std::memory_order_release);
+	}
+	void push(SoundTap tap, const float* samples, u32 sampleCount);
+
+private:
+	static constexpr u32 TAP_COUNT = (u32)SoundTap::COUNT;
+	static constexpr u32 RING_SIZE = 2 * CAPACITY; // Mirrored
+	static constexpr u32 SNAPSHOT_ATTEMPTS = 4;
+
+	inline std::atomic<float>* getRing(SoundTap tap) { return &mSamples[(u8)tap * RING_SIZE]; }
+	inline const std::atomic<float>* getRing(SoundTap tap) const { return &mSamples[(u8)tap * RING_SIZE]; }
+
+	// The UI may read a slot while the emulation rewrites it: reading a newer sample
+	// (acquire) also makes the reserved count covering it visible
+	std::unique_ptr<std::atomic<float>[]> mSamples;
+	// Running sample counts (wrapping), the ring index is count % CAPACITY
+	std::array<std::atomic<u32>, TAP_COUNT> mReservedCount;
+	std::array<std::atomic<u32>, TAP_COUNT> mWrittenCount;
+	std::array<std::atomic<bool>, TAP_COUNT> mIsSubscribed;
+};
@@ -47,6 +47,14 @@ public:
 	void reset();
 
 	s32 executeOneCpuCycle(Memory& memory, bool isGetCycle);
+
+	// Cycles without frame counter step nor DMC memory read: the channels run them at once
+	s32 getIdleCpuCycles() const;
+	void executeIdleCpuCycles(s32 cpuCycles);
+
+	// Cycles to run so that the output may change on the last one
+	s32 getCpuCyclesToOutputChange() const;
+
 	float getOutput();
 	float getPulse1Output();
 	float getPulse2Output();
@@ -65,7 +73,13 @@ public:
 		mDmcChannel.clearIRQSignal(); 
 	}
 
+	// Scheduler
+	s32 getCpuCyclesToIrq() const;
+	inline s32 getMaxDmcDmaExtraCycles(s32 cpuCycles) const { return mDmcChannel.getMaxDmaExtraCycles(cpuCycles); }
+
 private:
+	friend class SaveStateSerializer; // Binary save states
+
 	float mixPulses(u8 pulse1, u8 pulse2);
 	float mixTnd(u8 triangle, u8 noise, u8 dmc);
 	float mix(u8 pulse1, 
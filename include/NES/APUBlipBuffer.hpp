@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "NES/Config.hpp"
+
+// Save state: pending steps & filters (the kernel & coefficients only depend on the rates)
+struct blipBufferState_t
+{
+	u64 samplesPerClock;
+	u64 nextSamplesPerClock;
+	u64 offset;
+	u32 samplesAvailable;
+	std::vector<float> deltas;
+	float integrator;
+	float highPass1PreviousInput;
+	float highPass1PreviousOutput;
+	float highPass2PreviousInput;
+	float highPass2PreviousOutput;
+	float lowPassPreviousOutput;
+};
+
+/// @brief Band-limited synthesis of the APU output (blip buffer)
+///
+/// The output is given as amplitude steps at clock timestamps (CPU cycles), each step is added
+/// as a band-limited impulse to a difference buffer. Samples are made by frames: the buffer is
+/// integrated, then filtered as the NES does (high-pass 90 Hz & 440 Hz, low-pass 14 kHz).
+class APUBlipBuffer
+{
+public:
+	APUBlipBuffer(u32 clockRate, u32 sampleRate, u32 sampleCapacity);
+
+	void clear();
+	void saveState(blipBufferState_t& state) const;
+	void loadState(const blipBufferState_t& state);
+
+	// Resampling ratio (dynamic rate control), applied from the next frame
+	void setSampleRateRatio(double ratio);
+
+	// Clock time is relative to the start of the frame
+	void addDelta(u32 clockTime, float delta);
+	void endFrame(u32 clockDuration);
+
+	inline u32 getSamplesAvailable() const { return mSamplesAvailable; }
+	inline u32 getSampleCapacity() const { return (u32)mDeltas.size() - KERNEL_WIDTH; }
+	inline u32 getDeltasSize() const { return (u32)mDeltas.size(); }
+	u32 readSamples(float* samples, u32 maxSampleCount);
+
+private:
+	static constexpr u32 TIME_BITS = 32;
+	static constexpr u32 PHASE_BITS = 6;
+	static constexpr u32 PHASE_COUNT = 1 << PHASE_BITS;
+	static constexpr u32 KERNEL_HALF_WIDTH = 8;
+	static constexpr u32 KERNEL_WIDTH = 2 * KERNEL_HALF_WIDTH;
+
+	// Filters cutoff frequencies (Hz)
+	static constexpr float HIGH_PASS_1_FREQUENCY = 90.0f;
+	static constexpr float HIGH_PASS_2_FREQUENCY = 440.0f;
+	static constexpr float LOW_PASS_FREQUENCY = 14'000.0f;
+
+	void computeKernel();
+
+	// Impulse of a step (sum is 1) for each sub-sample phase
+	std::array<std::array<float, KERNEL_WIDTH>, PHASE_COUNT> mKernel;
+
+	u32 mClockRate;
+	u32 mSampleRate;
+	u64 mSamplesPerClock;  // Fixed point (TIME_BITS)
+	u64 mNextSamplesPerClock;
+	u64 mOffset;           // Sample position of the frame start, fixed point (TIME_BITS)
+	u32 mSamplesAvailable;
+	std::vector<float> mDeltas;
+
+	// Integrator & filters state
+	float mIntegrator;
+	float mHighPass1Coef;
+	float mHighPass1PreviousInput;
+	float mHighPass1PreviousOutput;
+	float mHighPass2Coef;
+	float mHighPass2PreviousInput;
+	float mHighPass2PreviousOutput;
+	float mLowPassCoef;
+	float mLowPassPreviousOutput;
+};
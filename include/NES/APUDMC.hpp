@@ -12,6 +12,7 @@ public:
 	void reset();
 
 	s32 update(Memory& memory, bool isGetCycle);
+	void executeIdleCycles(u32 cycles);
 	void setReg0(u8 value);
 	void setReg1(u8 value);
 	void setReg2(u8 value);
@@ -22,12 +23,20 @@ public:
 	inline bool getStatus() const { return mMemReaderCount > 0; }
 	inline u8 getOutput() const { return mOutput; }
 	inline bool getIRQSignal() const { return mIsIRQSignalSet; }
+	s32 getCpuCyclesToIrq() const;
+	s32 getMaxDmaExtraCycles(s32 cpuCycles) const;
+	s32 getCyclesToMemoryRead() const;
+	s32 getCyclesToOutputChange() const;
 
 	inline void clearIRQSignal() { mIsIRQSignalSet = false; }
 
 private:
+	friend class SaveStateSerializer; // Binary save states
+
 	u8 dmaRead(Memory& memory, bool isGetCycle, s32& extraCycles);
 	void incrementReaderAddress();
+	void clockOutputUnit();
+	inline s32 getCpuCyclesPerSampleByte() const { return 8 * 2 * (mTimer.getPeriod() + 1); }
 
 	std::array<u16, 16> RATE_LUT_NTSC = 
 	{{
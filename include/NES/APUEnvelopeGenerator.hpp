@@ -9,7 +9,7 @@ class APUEnvelopeGenerator
 		void reset(); 
 
 		void onClock();
-		inline u8 getOutput() { return mIsConstantVolume ? mVolume : mDecayCounter; }
+		inline u8 getOutput() const { return mIsConstantVolume ? mVolume : mDecayCounter; }
 
 		void setVolume(u8 volume);
 		inline void setLoopFlag(bool isLoopFlagSet) { mIsLoopFlagSet = isLoopFlagSet; }
@@ -18,6 +18,8 @@ class APUEnvelopeGenerator
 		inline void setStartFlag() { mIsStartFlagClear = false; }
 
 	private:
+		friend class SaveStateSerializer; // Binary save states
+
 		static constexpr u8 DECAY_COUNTER_PERIOD = 15;
 
 		Divider mDivider;
@@ -16,14 +16,20 @@ public:
 	void reset();
 
 	APUFrameCounterState executeOneCpuCycle();
+	u32 executeIdleCpuCycles(u32 cpuCycles);
 	void writeRegister(u8 reg);
 
 	inline bool isEvenCycle() const { return mIsEvenCycle; }
 	inline bool getIRQSignal() const { return mIsIRQSignalSet; }
+	s32 getCpuCyclesToIrq() const;
+	s32 getCpuCyclesToNextStep() const;
+	inline bool isNextCycleEven() const { return mApuClockDivider.getCounter() == 0; }
 
 	inline void clearIRQSignal() { mIsIRQSignalSet = false; }
 
 private:
+	friend class SaveStateSerializer; // Binary save states
+
 	// NTSC cycles for sequence steps
 	static constexpr u16 FC_STEP1_CYCLE_COUNT = 3728; 
 	static constexpr u16 FC_STEP2_CYCLE_COUNT = 7456; 
@@ -23,6 +23,8 @@ public:
 	inline u8 getCounter() const { return mCounter; }
 
 private:
+	friend class SaveStateSerializer; // Binary save states
+
 	static constexpr std::array<u8, 0x20> LENGTH_LUT = 
 	{{
 		10, 254, 20,  2, 40,  4, 80,  6, 160,  8, 60, 10, 14, 12, 26, 14,
@@ -13,6 +13,8 @@ public:
 	void reset();
 
 	void update(APUFrameCounterState fcState);
+	void executeIdleCycles(u32 cycles);
+	s32 getCyclesToOutputChange() const;
 	void setReg0(u8 value);
 	void setReg1(u8 value);
 	void setReg2(u8 value);
@@ -23,6 +25,12 @@ public:
 	inline bool getStatus() const { return mLengthCounter.getCounter() > 0; }
 
 private:
+	friend class SaveStateSerializer; // Binary save states
+
+	void shiftRegister();
+	void updateOutput();
+	inline bool isSilenced() const { return mLengthCounter.getCounter() == 0 || mEnvelope.getOutput() == 0; }
+
 	static constexpr std::array<u16, 0x10> TIMER_NTSC_PERIOD_LUT = 
 	{{
 		2, 4, 8, 16, 32, 48, 64, 80, 101, 127, 190, 254, 381, 508, 1017, 2034
@@ -15,6 +15,8 @@ public:
 	void reset();
 
 	void update(APUFrameCounterState fcState);
+	void executeIdleCycles(u32 cycles);
+	s32 getCyclesToOutputChange() const;
 	void setReg0(u8 value);
 	void setReg1(u8 value);
 	void setReg2(u8 value);
@@ -26,6 +28,11 @@ public:
 	inline bool getStatus() const { return mLengthCounter.getCounter() > 0; }
 
 private:
+	friend class SaveStateSerializer; // Binary save states
+
+	bool isSilenced() const;
+	u8 computeOutput(u8 sequenceIndex) const;
+
 	inline void incrementSequenceIndex()
 	{
 		mSequenceIndex++;
@@ -10,10 +10,10 @@ public:
 
 	bool update(u16 timerPeriod, u16 targetPeriod);
 
-	u16 calculateTargetPeriod1(u16 timerPeriod);
-	u16 calculateTargetPeriod2(u16 timerPeriod);
+	u16 calculateTargetPeriod1(u16 timerPeriod) const;
+	u16 calculateTargetPeriod2(u16 timerPeriod) const;
 
-	inline bool isMuting(u16 timerPeriod, u16 targetPeriod)
+	inline bool isMuting(u16 timerPeriod, u16 targetPeriod) const
 	{
 		return (timerPeriod < 8 || targetPeriod > 0x7FF);
 	}
@@ -26,6 +26,8 @@ public:
 	inline void setReloadFlag() { mIsReloadFlagSet = true; }
 	
 private:
+	friend class SaveStateSerializer; // Binary save states
+
 	Divider mDivider;
 	u8 mShiftCount;
 	bool mIsEnabled;
@@ -12,6 +12,8 @@ public:
 	void reset();
 
 	void update(APUFrameCounterState fcState);
+	void executeIdleCycles(u32 cycles);
+	s32 getCyclesToOutputChange() const;
 	void setReg0(u8 value);
 	void setReg1(u8 value);
 	void setReg2(u8 value);
@@ -22,6 +24,8 @@ public:
 	inline bool getStatus() const { return mLengthCounter.getCounter() > 0; }
 
 private:
+	friend class SaveStateSerializer; // Binary save states
+
 	inline void incrementSequenceIndex()
 	{
 		mSequenceIndex++;
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <utility>
+
 #include "NES/Config.hpp"
 #include "NES/Memory.hpp"
 #include "NES/CPUConstants.hpp"
@@ -50,6 +53,8 @@ public:
 #endif
 
 private:
+    friend class SaveStateSerializer; // Binary save states
+
     // ******** Internal behaviour ******** //
     // Read/Write memory
     u8 fetchByte(s32& cycles, Memory& memory);
@@ -60,9 +65,21 @@ private:
     u8 stackPull(s32& cycles, Memory& memory);
 
     // *** Instruction execution *** //
-    s32 getInstructionCycleCount(Memory& memory);
-    u16 fetchAddr(s32& cycles, Memory& memory, AddressingMode addrMode, u16& dummyAddress, bool& hasPageCrossed);
-    void executeInstruction(s32& cycles, Memory& memory, instruction_t instruction, u16 address, u16 dummyAddress, bool hasPageCrossed);
+    using OpcodeHandler = void (CPU::*)(s32& cycles, Memory& memory);
+    
+    void predecode(const Memory& memory);
+    u8 fetchOpcode(s32& cycles, Memory& memory);
+    template<u8 opcode>
+    void executeOpcode(s32& cycles, Memory& memory);
+    template<AddressingMode addrMode>
+    u16 fetchAddr(s32& cycles, Memory& memory, u16& dummyAddress, bool& hasPageCrossed);
+    template<u8 opcode, Operation operation, AddressingMode addrMode>
+    void executeInstruction(s32& cycles, Memory& memory, u16 address, u16 dummyAddress, bool hasPageCrossed);
+
+    // One handler per opcode, generated from INSTRUCTION_LUT
+    template<std::size_t... opcodes>
+    static constexpr std::array<OpcodeHandler, sizeof...(opcodes)> makeOpcodeHandlerLut(std::index_sequence<opcodes...>);
+    static const std::array<OpcodeHandler, 256> OPCODE_HANDLER_LUT;
     
     // *** Instructions *** //
     void adc(s32& cycles, Memory& memory, u16 address, u16 dummyAddress, bool hasPageCrossed);
@@ -177,4 +194,7 @@ private:
 
     u8 mPreviousI: 1; // To emulate the delay on CLI SEI PLP
     bool mIsIDelayed;
+
+    // Instruction decoded by the cycles prediction, consumed by the execution
+    instructionDescriptor_t mPredecodedInstruction;
 };
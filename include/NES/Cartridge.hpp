@@ -1,12 +1,23 @@
 #pragma once
 
+#include <array>
 #include <fstream>
 #include <string>
 #include <vector>
-#include <memory>
+#include <variant>
+#include <type_traits>
 
 #include "NES/Config.hpp"
-#include "NES/Mapper.hpp"
+#include "NES/Mapper000.hpp"
+#include "NES/Mapper001.hpp"
+#include "NES/Mapper002.hpp"
+#include "NES/Mapper003.hpp"
+#include "NES/Mapper004.hpp"
+
+// Decoded pattern table row: one byte per pixel (leftmost first) holding its color index,
+// bit 0 comes from the LSB plane and bit 1 from the MSB plane
+constexpr u64 TILE_ROW_LSB_PLANE = 0x0101'0101'0101'0101;
+constexpr u64 TILE_ROW_MSB_PLANE = 0x0202'0202'0202'0202;
 
 enum TVSystem
 {
@@ -14,29 +25,100 @@ enum TVSystem
 	PAL = 1
 };
 
+// Mapper chosen at load time (no mapper if the ROM is not playable)
+using mapper_t = std::variant<std::monostate, Mapper000, Mapper001, Mapper002, Mapper003, Mapper004>;
+static_assert(std::is_trivially_copyable_v<mapper_t>, "Mapper registers are copied as they are by the in-memory save states");
+
+// Save state: cartridge RAMs & mapper registers (ROMs do not change)
+struct cartridgeState_t
+{
+	std::vector<u8> prgRam;
+	std::vector<u8> chrRam;
+	std::vector<u64> chrRamTileRows;
+	mapper_t mapper;
+};
+
 class Cartridge
 {
+private:
+	// Call the mapper with its concrete type, so that mapping can be inlined
+	// (default value without mapper)
+	template<typename Function>
+	inline auto visitMapper(Function&& function)
+	{
+		return std::visit([&](auto& mapper)
+		{
+			if constexpr (std::is_same_v<std::decay_t<decltype(mapper)>, std::monostate>)
+				return decltype(function(std::declval<Mapper000&>()))();
+			else
+				return function(mapper);
+		}, mMapper);
+	}
+
+	template<typename Function>
+	inline auto visitMapper(Function&& function) const
+	{
+		return std::visit([&](const auto& mapper)
+		{
+			if constexpr (std::is_same_v<std::decay_t<decltype(mapper)>, std::monostate>)
+				return decltype(function(std::declval<const Mapper000&>()))();
+			else
+				return function(mapper);
+		}, mMapper);
+	}
+
 public:
 	Cartridge(const std::string& romFilename);
 
 	void reset();
 
-	bool readPrg(u16 cpuAddress, u8& output);
-	bool writePrg(u16 cpuAddress, u8 input);
+	// Save state (the memory maps its pages again after a load)
+	void saveState(cartridgeState_t& state) const;
+	void loadState(const cartridgeState_t& state);
+
+	// Bus accesses compiled for the concrete mapper (std::monostate without mapper):
+	// the memory chooses the ones of the ROM mapper once (see MemoryNES)
+	template<typename MapperType> bool readPrg(u16 cpuAddress, u8& output);
+	template<typename MapperType> bool writePrg(u16 cpuAddress, u8 input);
+	template<typename MapperType> void processPpuAccess(u16 ppuAddress, u16 ppuCycleCount);
+	inline const mapper_t& getMapper() const { return mMapper; }
+
+	bool peekPrg(u16 cpuAddress, u8& output) const;
+	void mapPrgPages(std::array<const u8*, 256>& readPages, std::array<u8*, 256>& writePages);
+
+	void mapChrPages(std::array<const u8*, 8>& readPages, std::array<u8*, 8>& writePages, std::array<u64*, 8>& tileRowPages);
+	void mapNametables(std::array<u16, 4>& vramOffsets) const;
 
-	bool readChr(u16 ppuAddress, u8& output, u16& mappedNtAddress, u16 ppuCycleCount);
-	bool writeChr(u16 ppuAddress, u8 input, u16& mappedNtAddress, u16 ppuCycleCount);
+	inline bool isMonitoringPpuBus() const { return mIsMonitoringPpuBus; }
 
-	inline bool getIrqSignal() const { return mMapper->getIrqSignal(); }
-	inline void clearIrqSignal() { return mMapper->clearIrqSignal(); }
+	inline bool isIrqEnabled() const { return visitMapper([](const auto& mapper) { return mapper.isIrqEnabled(); }); }
+	inline bool getIrqSignal() const { return visitMapper([](const auto& mapper) { return mapper.getIrqSignal(); }); }
+	inline void clearIrqSignal() { visitMapper([](auto& mapper) { mapper.clearIrqSignal(); }); }
+
+	inline bool isMappingChanged() const { return visitMapper([](const auto& mapper) { return mapper.isMappingChanged(); }); }
+	inline void clearMappingChanged() { visitMapper([](auto& mapper) { mapper.clearMappingChanged(); }); }
 
 	inline const std::string& getHeaderInfo() const { return mHeaderInfo; }
 
+	// Tile row index of a pattern table byte: tile * 8 + fine Y (both planes share the row)
+	static inline u32 getTileRowIdx(u32 chrAddress) { return ((chrAddress >> 1) & ~0x0007) | (chrAddress & 0x0007); }
+	static u64 decodeTileRow(u8 ptLsb, u8 ptMsb);
+	static void decodeTileRows(const std::vector<u8>& chrMemory, std::vector<u64>& tileRows);
+
+	// Identifies the game of a save state (PRG-ROM & CHR-ROM)
+	inline u64 getRomHash() const { return mRomHash; }
+	// Sizes of the console a save state is loaded into
+	inline u32 getPrgRamSize() const { return (u32)mPrgRam.size(); }
+	inline u32 getChrRamSize() const { return (u32)mChrRam.size(); }
+	inline u32 getMapperIdx() const { return (u32)mMapper.index(); }
+
 	inline bool isRomPlayable() const { return mIsRomPlayable; } 
 	inline const std::string& getErrorMessage() const { return mErrorMessage; }
 
 private:
-	u16 mapNtAddress(u16 ppuAddress);
+	// PRG-RAM is mapped below PRG-ROM ($6000-$7FFF) by every mapper
+	static inline bool isPrgRamAddress(u16 cpuAddress) { return cpuAddress < 0x8000; }
+
 	void savePrgRam();
 	std::string buildHeaderInfoStr(bool isINesHeader, 
                                    u32 prgRomSize,
@@ -61,11 +143,69 @@ private:
 	std::vector<u8> mPrgRam;
 	std::vector<u8> mChrRom;
 	std::vector<u8> mChrRam;
+	u64 mRomHash;
+
+	// Pattern tables decoded once (CHR-RAM rows are decoded again when written),
+	// indexed like the CHR memory so that bank switches only move the pages
+	std::vector<u64> mChrRomTileRows;
+	std::vector<u64> mChrRamTileRows;
 
 	std::ofstream mCartRamFile;
 
-	std::unique_ptr<Mapper> mMapper;
+	mapper_t mMapper;
+	bool mIsMonitoringPpuBus;
 
 	bool mIsRomPlayable;
 	std::string mErrorMessage;
 };
+
+template<typename MapperType>
+inline bool Cartridge::readPrg(u16 cpuAddress, u8& output)
+{
+	if constexpr (std::is_same_v<MapperType, std::monostate>)
+		return false;
+	else
+	{
+		u32 prgAddr;
+		if (!std::get_if<MapperType>(&mMapper)->mapCpuRead(cpuAddress, prgAddr))
+			return false;
+
+		logMappedAddress(prgAddr);
+
+		// Check if target is PRG RAM or ROM (banks out of the memory are mirrored)
+		const std::vector<u8>& prgMemory = isPrgRamAddress(cpuAddress) ? mPrgRam : mPrgRom;
+		if (prgMemory.empty())
+			return false;
+		output = prgMemory[prgAddr % prgMemory.size()];
+
+		logValue(output);
+
+		return true;
+	}
+}
+
+template<typename MapperType>
+inline bool Cartridge::writePrg(u16 cpuAddress, u8 input)
+{
+	if constexpr (std::is_same_v<MapperType, std::monostate>)
+		return false;
+	else
+	{
+		// Write into the PRG-RAM
+		u32 prgRamAddr = 0xFFFFFFFF;
+		if (!std::get_if<MapperType>(&mMapper)->mapCpuWrite(cpuAddress, prgRamAddr, input))
+			return false;
+
+		if (prgRamAddr < mPrgRam.size())
+			mPrgRam[prgRamAddr] = input;
+
+		return true;
+	}
+}
+
+template<typename MapperType>
+inline void Cartridge::processPpuAccess(u16 ppuAddress, u16 ppuCycleCount)
+{
+	if constexpr (!std::is_same_v<MapperType, std::monostate>)
+		std::get_if<MapperType>(&mMapper)->processPpuAccess(ppuAddress, ppuCycleCount);
+}
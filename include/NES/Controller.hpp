@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+
 #include "NES/Config.hpp"
 
 enum ControllerInput
@@ -14,6 +17,17 @@ enum ControllerInput
     RIGHT  = 1 << 7
 };
 
+// Save state: the shift register (the buttons are inputs)
+struct controllerState_t
+{
+    u8 shiftRegister;
+    bool isUpdatingState;
+};
+
+// Gives the latest buttons state (called by the NES thread)
+using strobeCallback_t = std::function<u8()>;
+
+// The buttons state is written by the input thread, the shift register is emulated by the NES thread
 class Controller
 {
 public:
@@ -21,8 +35,19 @@ public:
     void setStrobe(u8 value);
     void updateControllerState(u8 state);
 
+    inline void saveState(controllerState_t& state) const { state = { mControllerShiftRegister, mIsUpdatingState }; }
+    inline void loadState(const controllerState_t& state)
+    {
+        mControllerShiftRegister = state.shiftRegister;
+        mIsUpdatingState = state.isUpdatingState;
+    }
+
+    // Late polling: the buttons state is pulled when the game strobes the controller
+    inline void setStrobeCallback(strobeCallback_t callback) { mStrobeCallback = std::move(callback); }
+
 private:
-    u8 mControllerState         = 0;
+    strobeCallback_t mStrobeCallback;
+    std::atomic<u8> mControllerState{ 0 };
     u8 mControllerShiftRegister = 0;
 
     bool mIsUpdatingState       = true;
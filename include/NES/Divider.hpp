@@ -10,13 +10,16 @@ public:
 	inline void reloadCounter() { mCounter = mPeriod; }
 	inline void loadPeriod(u16 period) { mPeriod = period; } 
 
-	inline u16 getCounter() { return mCounter; }
-	inline u16 getPeriod() { return mPeriod; }
+	inline u16 getCounter() const { return mCounter; }
+	inline u16 getPeriod() const { return mPeriod; }
 
 	bool countDown();
+	u32 countDown(u32 cycles);
 	bool registerShift();
 
 private:
+	friend class SaveStateSerializer; // Binary save states
+
 	u16 mPeriod;
 	u16 mCounter;
 };
\ No newline at end of file
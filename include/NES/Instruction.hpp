@@ -88,3 +88,10 @@ struct instruction_t
 	u8 opcode;
 	const char* str;
 };
+
+struct instructionDescriptor_t
+{
+	bool isValid; // false if the opcode could not be predecoded
+	u16 pc;
+	u8 opcode;
+};
@@ -13,33 +13,43 @@ enum NametableArrangement
 class Mapper
 {
 public:
+	// Common mapper state. Mappers are used through their concrete type (see Cartridge),
+	// each of them provides:
+	//   void reset();
+	//   bool mapCpuWrite(u16 address, u32& mappedAddress, u8 value);
+	//   bool mapCpuRead(u16 address, u32& mappedAddress) const;
+	//   bool mapPpuAddress(u16 address, u32& mappedAddress) const;
 	Mapper(u8 prgNumBanks, u8 chrNumBanks, NametableArrangement ntArr);
-	virtual ~Mapper() {}
 
-	virtual void reset() = 0;
-
-	virtual bool mapCpuWrite(u16 address, u32& mappedAddress, u8 value) = 0;
-	virtual bool mapCpuRead(u16 address, u32& mappedAddress) = 0;
-	virtual bool mapPpuWrite(u16 address, u32& mappedAddress, u16 ppuCycleCount) = 0;
-	virtual bool mapPpuRead(u16 address, u32& mappedAddress, u16 ppuCycleCount) = 0;
+	// Most mappers do not care about the PPU bus (inlined away from the bus paths)
+	inline void processPpuAccess(u16 address, u16 ppuCycleCount) { (void)address; (void)ppuCycleCount; }
 
 	inline NametableArrangement getNtArragenement() const { return mNtArrangement; }
 	inline u16 getVramBankAddressOffset() const { return mVramBankAddressOffset; }
-	inline bool isPrgRamRead() const { return mIsPrgRamRead; };
 	inline bool isChrRamSelected() const { return mIsChrRamSelected; };
+	inline bool isMonitoringPpuBus() const { return mIsMonitoringPpuBus; }
+
+	inline bool isMappingChanged() const { return mIsMappingChanged; }
+	inline void clearMappingChanged() { mIsMappingChanged = false; }
 
+	inline bool isIrqEnabled() const { return mIsIrqEnabled; }
 	inline bool getIrqSignal() const { return mIsIrqSignalSet; }
 	inline void clearIrqSignal() { mIsIrqSignalSet = false; }
 
 protected:
-	const u8 mPrgNumBanks;
-	const u8 mChrNumBanks;
+	friend class SaveStateSerializer; // Binary save states
+
+	// Set by the header (not const: save states assign the mappers)
+	u8 mPrgNumBanks;
+	u8 mChrNumBanks;
 	
 	NametableArrangement mNtArrangement;
 	u16 mVramBankAddressOffset;
 	
-	bool mIsPrgRamRead;
 	bool mIsChrRamSelected;
+	bool mIsMonitoringPpuBus; // The mapper must see every PPU access (e.g. MMC3 A12)
+	bool mIsMappingChanged;   // A register write switched a bank or the mirroring
 
+	bool mIsIrqEnabled;
 	bool mIsIrqSignalSet;
 };
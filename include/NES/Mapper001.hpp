@@ -7,17 +7,17 @@ class Mapper001 : public Mapper
 public:
 	Mapper001(u8 prgNumBanks, u8 chrNumBanks);
 	
-	void reset() override;
+	void reset();
 	void resetShiftRegister();
 	
-	bool mapCpuWrite(u16 address, u32& mappedAddress, u8 value) override;
-	bool mapCpuRead(u16 address, u32& mappedAddress) override;
-	bool mapPpuWrite(u16 address, u32& mappedAddress, u16 ppuCycleCount) override;
-	bool mapPpuRead(u16 address, u32& mappedAddress, u16 ppuCycleCount) override;
+	bool mapCpuWrite(u16 address, u32& mappedAddress, u8 value);
+	bool mapCpuRead(u16 address, u32& mappedAddress) const;
+	bool mapPpuAddress(u16 address, u32& mappedAddress) const;
 	
 private:
+	friend class SaveStateSerializer; // Binary save states
+
 	void processShiftRegister(u16 address);
-	bool mapPpuAddress(u16 address, u32& mappedAddress);
 
 	static constexpr u8 SHIFT_REGISTER_SIZE = 5;
 
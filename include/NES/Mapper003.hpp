@@ -7,15 +7,14 @@ class Mapper003 : public Mapper
 public:
 	Mapper003(u8 prgNumBanks, u8 chrNumBanks, NametableArrangement ntArr);
 
-	void reset() override;
+	void reset();
 	
-	bool mapCpuWrite(u16 address, u32& mappedAddress, u8 value) override;
-	bool mapCpuRead(u16 address, u32& mappedAddress) override;
-	bool mapPpuWrite(u16 address, u32& mappedAddress, u16 ppuCycleCount) override;
-	bool mapPpuRead(u16 address, u32& mappedAddress, u16 ppuCycleCount) override;
+	bool mapCpuWrite(u16 address, u32& mappedAddress, u8 value);
+	bool mapCpuRead(u16 address, u32& mappedAddress) const;
+	bool mapPpuAddress(u16 address, u32& mappedAddress) const;
 	
 private:
-	bool mapPpuAddress(u16 address, u32& mappedAddress);
-	
+	friend class SaveStateSerializer; // Binary save states
+
 	u8 mChrBankIdx;
 };
@@ -9,16 +9,17 @@ class Mapper004 : public Mapper
 public:
 	Mapper004(u8 prgNumBanks, u8 chrNumBanks, NametableArrangement ntArr);
 
-	void reset() override;
+	void reset();
 
-	bool mapCpuWrite(u16 address, u32& mappedAddress, u8 value) override;
-	bool mapCpuRead(u16 address, u32& mappedAddress) override;
-	bool mapPpuWrite(u16 address, u32& mappedAddress, u16 ppuCycleCount) override;
-	bool mapPpuRead(u16 address, u32& mappedAddress, u16 ppuCycleCount) override;
+	bool mapCpuWrite(u16 address, u32& mappedAddress, u8 value);
+	bool mapCpuRead(u16 address, u32& mappedAddress) const;
+	bool mapPpuAddress(u16 address, u32& mappedAddress) const;
+	void processPpuAccess(u16 address, u16 ppuCycleCount);
 
 private:
+	friend class SaveStateSerializer; // Binary save states
+
 	void processRegisterWrite(u16 address, u8 value);
-	bool mapPpuAddress(u16 address, u32& mappedAddress, u16 ppuCycleCount);
 	void processIrqCounter(u16 address, u16 ppuCycleCount);
 	void clockIrqCounter();
 
@@ -41,5 +42,4 @@ private:
 	u16 mPreviousPpuCycle;
 	u8 mM2CycleOffset;
 	bool mIsIrqReloadSet;
-	bool mIsIrqEnabled;
 };
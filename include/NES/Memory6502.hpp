@@ -11,6 +11,7 @@ public:
 	inline u8& operator[](u16 index) { return data[index]; }
 	
 	inline u8 cpuRead(u16 address) const { return data[address]; }
+	inline bool cpuPeek(u16 address, u8& value) const { value = data[address]; return true; }
 	inline void cpuWrite(u16 address, u8 value) { data[address] = value; }
 
 private:
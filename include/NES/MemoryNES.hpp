@@ -16,6 +16,26 @@ constexpr u16 PPUSCROLL_CPU_ADDR = 0x2005;
 constexpr u16 PPUADDR_CPU_ADDR   = 0x2006;
 constexpr u16 PPUDATA_CPU_ADDR   = 0x2007;
 
+constexpr u32 CPU_RAM_SIZE = 0x0800;  // 2 kB
+constexpr u32 PPU_VRAM_SIZE = 0x1000; // 2 kB (+ 2 kB on cartridge for four-screen)
+
+// Save state: RAMs, DMA, controllers & cartridge (the page tables are mapped again)
+struct memoryState_t
+{
+	std::array<u8, CPU_RAM_SIZE> cpuRam;
+	std::array<u8, PPU_VRAM_SIZE> ppuVram;
+	u8 oamDma;
+	u8 oamDmaBuffer;
+	u16 oamDmaIdx;
+	bool isOamDmaStarted;
+	bool isCpuHalt;
+	bool previousIsGetCycle;
+	controllerState_t controller1;
+	controllerState_t controller2;
+	cartridgeState_t cartridge;
+};
+
+class NES;
 class PPU;
 class APU;
 
@@ -23,44 +43,93 @@ class APU;
 class MemoryNES
 {
 public:
-	MemoryNES(const std::string& romFilename, APU& apuRef, PPU& ppuRef, Controller& controller1Ref, Controller& controller2Ref);
+	MemoryNES(const std::string& romFilename, NES& nesRef, APU& apuRef, PPU& ppuRef, Controller& controller1Ref, Controller& controller2Ref);
 	void reset();
 
+	void saveState(memoryState_t& state) const;
+	void loadState(const memoryState_t& state);
+
 	u8 cpuRead(u16 address);
+	bool cpuPeek(u16 address, u8& value) const;
 	void cpuWrite(u16 address, u8 value);
 	
-	u8 ppuRead(u16 address, u16 ppuCycleCount);
-	void ppuWrite(u16 address, u8 value, u16 ppuCycleCount);
+	inline u8 ppuRead(u16 address, u16 ppuCycleCount) { return (this->*mBusPaths.ppuRead)(address, ppuCycleCount); }
+	inline u64 ppuReadTileRow(u16 address, u16 ppuCycleCount) { return (this->*mBusPaths.ppuReadTileRow)(address, ppuCycleCount); }
+	inline void ppuWrite(u16 address, u8 value, u16 ppuCycleCount) { (this->*mBusPaths.ppuWrite)(address, value, ppuCycleCount); }
 
 	inline bool isOamDmaStarted() const { return mIsOamDmaStarted; }
 	s32 executeOamDma(bool isGetCycle);
 
+	inline bool isCartridgeIrqEnabled() const { return mCartridge.isIrqEnabled(); }
+	inline bool isCartridgeMonitoringPpuBus() const { return mCartridge.isMonitoringPpuBus(); }
 	inline bool getCartridgeIrq() const { return mCartridge.getIrqSignal(); }
 	inline void clearCartridgeIrq() { mCartridge.clearIrqSignal(); }
 
 	inline bool isRomPlayable() const { return mCartridge.isRomPlayable(); }
 	inline const std::string& getErrorMessage() const { return mCartridge.getErrorMessage(); }
 	inline const std::string& getHeaderInfo() const { return mCartridge.getHeaderInfo(); }
+	inline u64 getRomHash() const { return mCartridge.getRomHash(); }
+	inline u32 getPrgRamSize() const { return mCartridge.getPrgRamSize(); }
+	inline u32 getChrRamSize() const { return mCartridge.getChrRamSize(); }
+	inline u32 getMapperIdx() const { return mCartridge.getMapperIdx(); }
 
 private:
+	// Bus paths compiled for each mapper, so that the mapper calls are inlined
+	// (the CPU paths are taken when the page table has no pointer)
+	template<typename MapperType> u8 cpuReadMapped(u16 address);
+	template<typename MapperType> void cpuWriteMapped(u16 address, u8 value);
+	template<typename MapperType> u8 ppuReadMapped(u16 address, u16 ppuCycleCount);
+	template<typename MapperType> u64 ppuReadTileRowMapped(u16 address, u16 ppuCycleCount);
+	template<typename MapperType> void ppuWriteMapped(u16 address, u8 value, u16 ppuCycleCount);
+
+	// Page tables
+	void mapCpuPages();
+	void mapPpuPages();
+
 	// DMA
 	void startOamDma(u8 pageAddress);
 
 private:
+	// Bus paths of the ROM mapper, chosen once when it is loaded
+	struct busPaths_t
+	{
+		u8 (MemoryNES::*cpuRead)(u16 address);
+		void (MemoryNES::*cpuWrite)(u16 address, u8 value);
+		u8 (MemoryNES::*ppuRead)(u16 address, u16 ppuCycleCount);
+		u64 (MemoryNES::*ppuReadTileRow)(u16 address, u16 ppuCycleCount);
+		void (MemoryNES::*ppuWrite)(u16 address, u8 value, u16 ppuCycleCount);
+	};
+	busPaths_t mBusPaths;
+
 	// CPU
-	static constexpr u32 CPU_RAM_SIZE = 0x0800; // 2 kB
 	std::array<u8, CPU_RAM_SIZE> mCpuRam;
 
+	// CPU bus page table (256 bytes pages): direct pointers to RAM, PRG-RAM & PRG-ROM,
+	// nullptr when the page holds registers (or is left to the mapper)
+	static constexpr u32 CPU_PAGE_COUNT = 256;
+	std::array<const u8*, CPU_PAGE_COUNT> mCpuReadPages;
+	std::array<u8*, CPU_PAGE_COUNT> mCpuWritePages;
+
 	// Cartridge
 	Cartridge mCartridge;
 
+	// Scheduler
+	NES& mNesRef;
+
 	// APU
 	APU& mApuRef;
 
 	// PPU
-	static constexpr u32 PPU_VRAM_SIZE = 0x0800; // 2 kB
 	std::array<u8, PPU_VRAM_SIZE> mPpuVram;
 
+	// PPU bus page tables: 1 kB CHR banks (nullptr when read-only), their decoded tile rows & nametables
+	static constexpr u32 PPU_CHR_PAGE_COUNT = 8;
+	static constexpr u32 PPU_NT_COUNT = 4;
+	std::array<const u8*, PPU_CHR_PAGE_COUNT> mChrReadPages;
+	std::array<u8*, PPU_CHR_PAGE_COUNT> mChrWritePages;
+	std::array<u64*, PPU_CHR_PAGE_COUNT> mChrTileRowPages;
+	std::array<u8*, PPU_NT_COUNT> mNtPages;
+
 	PPU& mPpuRef;
 
 	// DMA
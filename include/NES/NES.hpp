@@ -2,12 +2,16 @@
 
 #include "NES/CPU.hpp"
 #include "NES/APU.hpp"
+#include "NES/APUBlipBuffer.hpp"
 #include "NES/PPU.hpp"
 #include "NES/Memory.hpp"
 #include "NES/Controller.hpp"
+#include "NES/SaveState.hpp"
 #include "IO/SoundManager.hpp"
+#include "IO/SoundTaps.hpp"
 
 #include <string>
+#include <vector>
 
 constexpr double FRAME_PERIOD_NTSC = 1.0 / 60.0988;
 
@@ -18,33 +22,56 @@ public:
 	~NES() { reset(); }
 
     void reset();
+	void saveState(nesState_t& state) const;
+	void loadState(const nesState_t& state);
+
+	// Binary save state (see SaveState.hpp), false if the buffer is not a save state of this game
+	void serializeState(std::vector<u8>& buffer);
+	bool deserializeState(const std::vector<u8>& buffer);
+    void runCpuBurst();
     void runOneCpuInstruction();
 
+	// Scheduler (called by the memory bus before/after touching APU, PPU or mapper registers)
+	void runPendingCycles();
+	inline void invalidateNextEvent() { mCpuCyclesToNextEvent = 0; }
+
 	inline bool isImageReady() const { return mPpu.isImageReady(); }
 	inline void clearIsImageReady() { mPpu.clearIsImageReady(); }
 	inline const picture_t& getPicture() { return mPpu.getPicture(); }
+	inline const indexedPicture_t& getIndexedPicture() { return mPpu.getIndexedPicture(); }
+	inline void setPictureFormat(PictureFormat pictureFormat) { mPpu.setPictureFormat(pictureFormat); }
+	inline void setNextFrameRenderingSkipped(bool isSkipped) { mIsNextFrameRenderingSkipped = isSkipped; applyRenderingSettings(); }
+	inline bool isFrameRenderingSkipped() const { return mIsPictureAhead ? mIsFrameAheadRenderingSkipped : mPpu.isFrameRenderingSkipped(); }
+	inline void setBandRenderingThreadCount(u32 threadCount) { mBandRenderingThreadCount = threadCount; applyRenderingSettings(); }
+
+	// Run-ahead: after each frame, the next ones are emulated with the current inputs,
+	// the last one is displayed then the state is rolled back (0: disabled)
+	inline void setRunAheadFrameCount(u32 frameCount) { mRunAheadFrameCount = frameCount; applyRenderingSettings(); }
 
 	inline void setMasterVolume(float masterVolume) { mMasterVolume = masterVolume; }
-	inline bool isSoundBufferReady() const { return mIsSoundBufferReady; }
-	inline void clearIsSoundBufferReady() { mIsSoundBufferReady = false; }
-	inline const soundBufferF32_t* getSoundBufferPtr() const { return mSoundBufferToSubmit; }
-	inline const soundFIFO_t* getSoundFIFOPtr() const { return &mSoundFIFO; }
-	inline const soundFIFO_t* getP1FIFOPtr() const { return &mP1FIFO; }
-	inline const soundFIFO_t* getP2FIFOPtr() const { return &mP2FIFO; }
-	inline const soundFIFO_t* getTriangleFIFOPtr() const { return &mTriangleFIFO; }
-	inline const soundFIFO_t* getNoiseFIFOPtr() const { return &mNoiseFIFO; }
-	inline const soundFIFO_t* getDmcFIFOPtr() const { return &mDmcFIFO; }
+	inline void setSoundSampleRateRatio(double ratio) { mBlipBuffer.setSampleRateRatio(ratio); }
+	inline bool areSoundSamplesReady() const { return mAreSoundSamplesReady; }
+	inline const float* getSoundSamples() const { return mSoundSamples.data(); }
+	inline u32 getSoundSampleCount() const { return mSoundSampleCount; }
+	inline void clearSoundSamples() { mSoundSampleCount = 0; mAreSoundSamplesReady = false; }
+	inline SoundTaps& getSoundTaps() { return mSoundTaps; }
 	
 	inline bool isRomPlayable() const { return mMemory.isRomPlayable(); }
 	inline const std::string& getErrorMessage() const { return mMemory.getErrorMessage(); }
 	inline const std::string& getHeaderInfo() const { return mMemory.getHeaderInfo(); }
 
 private:
+	void runAhead();
+	void applyRenderingSettings();
+
 	s32 getCpuCyclesPrediction();
+	s32 getCpuCyclesToNextEvent();
 	void pollIrqAndNmi();
-	void runApu();
+	s32 runApu(s32 cpuCycles);
+	void addApuOutputStep();
+	void readSoundSamples();
 	void runCpu();
-	void runPpu();
+	void runPpu(s32 cpuCycles);
 
     CPU mCpu;
 	APU mApu;
@@ -53,7 +80,11 @@ private:
 
 	s32 mCpuCyclesPredicted;
 	s32 mCpuCyclesElapsed;
-	s32 mDmcDmaExtraCycles;
+
+	// Scheduler: APU & PPU lag behind the CPU by the pending cycles,
+	// they catch up when the next event is due or when their registers are accessed
+	s32 mPendingCpuCycles;
+	s32 mCpuCyclesToNextEvent;
 	
 	bool mIsDmaGetCycle;
 
@@ -61,19 +92,32 @@ private:
 	bool mIsIrqSet;
     
     // Sound
-	static constexpr float TIME_PER_CYCLE = 1.0f / 1'789'773;
+	static constexpr u32 CPU_FREQUENCY = 1'789'773;
+	static constexpr u32 SOUND_FRAME_CPU_CYCLES = CPU_FREQUENCY / 60;
+	static constexpr u32 BLIP_BUFFER_CAPACITY = 2 * BUFFER_SIZE;
 	float mMasterVolume;
-	bool mIsUsingSoundBuffer0;
-	bool mIsSoundBufferReady;
-	soundBufferF32_t* mSoundBufferToSubmit;
-	soundBufferF32_t mSoundBuffer0;
-	soundBufferF32_t mSoundBuffer1;
-	soundFIFO_t mSoundFIFO;
-	soundFIFO_t mP1FIFO;
-	soundFIFO_t mP2FIFO;
-	soundFIFO_t mTriangleFIFO;
-	soundFIFO_t mNoiseFIFO;
-	soundFIFO_t mDmcFIFO;
-	float mApuTimestamp;
-	u16 mSoundSamplesCount;
+	bool mAreSoundSamplesReady;
+	std::array<float, BLIP_BUFFER_CAPACITY> mSoundSamples; // Until the app takes them
+	u32 mSoundSampleCount;
+	SoundTaps mSoundTaps;
+	u32 mApuSampleClock; // Channel taps
+
+	// Band-limited output (APU output steps, by CPU cycle)
+	APUBlipBuffer mBlipBuffer;
+	u32 mBlipClock;
+	float mApuOutput;
+
+	// Run-ahead (the frames ahead give no sound nor taps)
+	u32 mRunAheadFrameCount;
+	nesState_t mRunAheadState;
+
+	// Binary save states go through a state of the same game (its vectors are allocated once)
+	nesState_t mSerializedState;
+	bool mIsRunningAhead;
+	bool mIsPictureAhead;
+	bool mIsFrameAheadRenderingSkipped;
+
+	// Rendering settings (the real frames are not rendered while running ahead)
+	bool mIsNextFrameRenderingSkipped;
+	u32 mBandRenderingThreadCount;
 };
\ No newline at end of file
@@ -2,9 +2,13 @@
 
 #include <cstdint>
 #include <array>
+#include <vector>
+#include <memory>
 
 #include "NES/Config.hpp"
 #include "NES/Memory.hpp"
+#include "NES/PixelCompositor.hpp"
+#include "NES/PPUDotActions.hpp"
 
 constexpr u16 PPU_OUTPUT_WIDTH = 256;
 constexpr u16 PPU_OUTPUT_HEIGHT = 240;
@@ -12,11 +16,128 @@ constexpr u16 PPU_OUTPUT_CHANNELS = 3;
 
 using picture_t = std::array<std::array<std::array<u8, PPU_OUTPUT_CHANNELS>, PPU_OUTPUT_WIDTH>, PPU_OUTPUT_HEIGHT>;
 
+// Indexed pixel is: 0000'000E'EECC'CCCC (E: emphasis bits of PPUMASK, C: color code, grayscale applied)
+constexpr u16 INDEXED_PIXEL_COLOR_CODE_MASK = 0b0000'0000'0011'1111;
+constexpr u16 INDEXED_PIXEL_EMPHASIS_SHIFT = 6;
+using indexedPicture_t = std::array<std::array<u16, PPU_OUTPUT_WIDTH>, PPU_OUTPUT_HEIGHT>;
+
+constexpr u16 COLOR_LUT_SIZE = 64;
+using colorLut_t = std::array<std::array<u8, PPU_OUTPUT_CHANNELS>, COLOR_LUT_SIZE>;
+
+enum class PictureFormat
+{
+    RGB,
+    INDEXED
+};
+
+constexpr u32 PALETTE_RAM_SIZE = 0x0020; // 32 B
+using paletteRam_t = std::array<u8, PALETTE_RAM_SIZE>;
+using spriteRenderBuffer_t = std::array<u8, 32>;
+using spritePatternBuffer_t = std::array<u64, 8>;
+using spriteLineBuffer_t = std::array<u8, PPU_OUTPUT_WIDTH>;
+
+// Rendering log of a frame (band rendering): every rendered tile with the state it is rendered with.
+// The fetches are made by the emulation, so mapper bank switches are already applied to the tile rows.
+struct PPUTileRecord
+{
+    u64 tileRow;
+    u16 v;
+    s16 firstCol;
+    u16 spriteRecordIdx;
+    u8 at;
+    u8 x;
+    u8 mask;
+    u8 ctrl;
+    u8 row;
+};
+
+struct PPUSpriteRecord
+{
+    spriteRenderBuffer_t renderBuffer;
+    spritePatternBuffer_t patternBuffer;
+};
+
+struct PPUPaletteRecord
+{
+    u32 firstTileIdx;
+    paletteRam_t paletteRam;
+};
+
+struct PPUFrameLog
+{
+    PictureFormat pictureFormat;
+    std::vector<PPUTileRecord> tiles;
+    std::vector<PPUSpriteRecord> sprites;
+    std::vector<PPUPaletteRecord> palettes;
+    std::array<u32, PPU_OUTPUT_HEIGHT + 1> rowFirstTileIdx; // Rendered rows are in ascending order
+};
+
+// Save state: the emulated PPU (the pictures, the rendering settings & caches are not saved)
+struct ppuState_t
+{
+    // Timing
+    u16 scanlineCount;
+    u16 cycleCount;
+    bool isFirstPrerenderPassed;
+    bool isFrameRenderingSkipped;
+    bool isImageReady;
+
+    // Registers
+    u8 ppuCtrl;
+    u8 ppuMask;
+    u8 ppuStatus;
+    u8 oamAddr;
+    u8 oamData;
+    u8 ppuScrollX;
+    u8 ppuScrollY;
+    u16 ppuAddr;
+    u8 ppuData;
+    u16 v;
+    u16 t;
+    u8 x;
+    u8 w;
+
+    // Background fetches & scanline pixels
+    u8 bgNt;
+    u8 bgAt;
+    u64 bgTileRow;
+    std::array<u8, PPU_OUTPUT_WIDTH> bgLinePixels;
+    std::array<u8, PPU_OUTPUT_WIDTH> spriteLinePixels;
+
+    // OAM
+    std::array<u8, 256> oam;
+    std::array<u8, 32> oamSecondary;
+    spriteRenderBuffer_t spriteRenderBuffer;
+    spritePatternBuffer_t spritePatternBuffer;
+    u8 oamTransfertBuffer;
+    u8 oamSpriteIdx;
+    u8 oamByteIdx;
+    u8 secOamIdx;
+    bool isStoringOamSprite;
+    bool isNextLineSprite0InRenderBuffer;
+    bool isSprite0InRenderBuffer;
+
+    paletteRam_t paletteRam;
+
+    // NMI
+    bool vBlankNMISignal;
+    bool nmiCanOccur;
+};
+
+class PPUBandRenderer;
+
 class PPU
 {
 public:
+    PPU();
+    ~PPU();
+
     void reset();
+    void saveState(ppuState_t& state) const;
+    void loadState(const ppuState_t& state);
+
     void executeOneCycle(Memory& memory);
+    void executeCycles(Memory& memory, u32 cycles);
 
     void writeRegister(Memory& memory, u16 address, u8 value);
     u8 readRegister(Memory& memory, u16 address);
@@ -24,46 +145,74 @@ public:
     u8 readPaletteRam(u16 address);
     void writePaletteRam(u16 address, u8 value);
 
-    inline const picture_t& getPicture() const { return mPicture; }
+    inline const picture_t& getPicture() const { return *mDisplayedPicture; }
+    inline const indexedPicture_t& getIndexedPicture() const { return *mDisplayedIndexedPicture; }
+    inline PictureFormat getPictureFormat() const { return mPictureFormat; }
+    inline void setPictureFormat(PictureFormat pictureFormat) { mPictureFormat = pictureFormat; }
+    static inline const colorLut_t& getColorLut() { return LUT; }
+
+    // Render skip: the next frame (from the pre-render scanline) only keeps the emulated state (no picture)
+    inline void setNextFrameRenderingSkipped(bool isSkipped) { mIsNextFrameRenderingSkipped = isSkipped; }
+    inline bool isFrameRenderingSkipped() const { return mIsFrameRenderingSkipped; }
+
+    // Band rendering: the pictures are rendered by worker threads from a log, one frame late (0: disabled)
+    inline void setBandRenderingThreadCount(u32 threadCount) { mBandRenderingThreadCount = threadCount; }
     inline bool getVBlankNMISignal() const { return mVBlankNMISignal; }
     inline bool isImageReady() const { return mIsImageReady; }
     inline void clearIsImageReady() { mIsImageReady = false; }
     inline void clearNMISignal() { mVBlankNMISignal = false; mNMICanOccur = false; }
 
+    // Scheduler
+    u32 getDotsToVBlank() const;
+    u32 getDotsToRenderingFetches() const;
+
 private:
+    friend class PPUBandRenderer;
+
     struct backgroundData
     {
         u8 nt;
         u8 at;
-        u8 ptLsb;
-        u8 ptMsb;
-    };
-
-    struct oamData
-    {
-        u8 yPos;
-        u8 tileIdx;
-        u8 attribute;
-        u8 xPos;
+        u64 tileRow;
     };
 
     u8 readByte(Memory& memory, u16 address);
+    u64 readTileRow(Memory& memory, u16 address);
     void writeByte(Memory& memory, u16 address, u8 value);
 
-    void executeVisibleScanline(Memory& memory);
-    void executeVBlankScanline();
-    void executePreRenderScanline(Memory& memory);
+    void executeDotActions(Memory& memory, dotActions_t actions);
+
+    bool canExecuteWholeScanline(const Memory& memory) const;
+    void executeWholeScanline(Memory& memory);
+    void executeWholeVisibleScanline(Memory& memory);
 
-    void processPixelData(Memory& memory);
-    void processSpriteEvaluation(Memory& memory);
-    void setPictureColor(u8 colorCode, u16 row, u16 col);
+    void processPixelData(Memory& memory, dotActions_t actions);
+    void processSpriteEvaluation(Memory& memory, dotActions_t actions);
+    void renderTilePixels();
+    void composeLinePixels(u16 row, u16 colStart, u16 colEnd);
+    void updatePaletteTables();
+    inline bool isPictureRenderedByEmulation() const { return !mIsFrameRenderingSkipped && !mIsFrameRenderingDeferred; }
 
-    u16 getColorAddressFromBGData(u8 xIdx, u16 pixelX);
-    u16 getColorAddressFromSecOam(u16 pixelXPos, u16 pixelYPos, bool& hasSpritePriority);
-    u16 getColorAddressFromSprite(oamData sprite, u8 ptLsb, u8 ptMsb, u16 pixelXPos, u16 pixelYPos, bool& hasSpritePriority);
-    u8 getColorIndexFromPattern(u8 ptLsb, u8 ptMsb, u8 xIdx);
+    u8 getSpritePixel(u8 pixelXPos, u8 pixelYPos);
+    void buildSpriteLineBuffer(u8 pixelYPos);
 
-    bool isSprite0OnPixel(u8 pixelXPos, u8 pixelYPos, u16& colorAddress);
+    // Pixels (shared with the band renderer)
+    static u8 getBgPixel(u64 tileRow, u8 at, u16 v, u8 mask, u8 xIdx, u16 pixelX);
+    static void buildSpriteLineBuffer(spriteLineBuffer_t& lineBuffer, 
+                                      const spriteRenderBuffer_t& renderBuffer, 
+                                      const spritePatternBuffer_t& patternBuffer, 
+                                      u8 spriteHeight, 
+                                      u8 pixelYPos);
+    static void computePaletteTables(const paletteRam_t& paletteRam, u8 mask, paletteRgb_t& paletteRgb, paletteColorCodes_t& colorCodes);
+    static inline u8 getSpriteHeight(u8 ctrl) { return ((ctrl & 0b0010'0000) == 0) ? 8 : 16; }
+    static inline u16 getEmphasisBits(u8 mask) { return (u16)(mask & 0b1110'0000) << (INDEXED_PIXEL_EMPHASIS_SHIFT - 5); }
+    static inline u8 getColorIndexFromPattern(u64 tileRow, u8 xIdx) { return (u8)(tileRow >> (xIdx * 8)); }
+    static u64 flipTileRow(u64 tileRow);
+
+    // Band rendering
+    void startFrameLog();
+    void recordTile(u16 row, s32 firstCol);
+    void submitFrameLog();
 
     void incrementCoarseX();
     void incrementY();
@@ -75,8 +224,30 @@ private:
 
     void logPpu();
 
+    // Frame timing
+    static constexpr u32 DOTS_PER_SCANLINE = PPU_DOTS_PER_SCANLINE;
+    static constexpr u32 DOTS_PER_FRAME = PPU_SCANLINES_PER_FRAME * DOTS_PER_SCANLINE;
+
     // Rendering
     picture_t mPicture;
+    indexedPicture_t mIndexedPicture;
+    const picture_t* mDisplayedPicture;
+    const indexedPicture_t* mDisplayedIndexedPicture;
+    PictureFormat mPictureFormat = PictureFormat::RGB;
+    PixelCompositor mPixelCompositor;
+    std::array<u8, PPU_OUTPUT_WIDTH> mBgLinePixels;
+    std::array<u8, PPU_OUTPUT_WIDTH> mSpriteLinePixels;
+    bool mIsCompositionDeferred;
+    bool mIsFrameRenderingSkipped;
+    bool mIsNextFrameRenderingSkipped;
+
+    // Band rendering
+    std::unique_ptr<PPUBandRenderer> mBandRenderer;
+    u32 mBandRenderingThreadCount = 0;
+    bool mIsFrameRenderingDeferred;
+    PPUFrameLog* mFrameLog;             // Log being recorded (nullptr if none)
+    u16 mFrameLogNextRow;
+    bool mIsSpriteRecordOutdated;
     bool mIsImageReady;
     u16 mScanlineCount;
     u16 mCycleCount;
@@ -101,14 +272,11 @@ private:
     u8 mX : 3;
     u8 mW : 1;
 
-    bool mIsOddFrame;
-
     // OAM
-    static constexpr u16 SPRITE_NOT_IN_RANGE = 0xFFFF;
     std::array<u8, 256> mOam;
     std::array<u8, 32> mOamSecondary = {{ 0xFF }};
-    std::array<u8, 32> mSpriteRenderBuffer = {{ 0xFF }};
-    std::array<u8, 16> mSpritePatternBuffer = {{ 0xFF }};
+    spriteRenderBuffer_t mSpriteRenderBuffer = {{ 0xFF }};
+    spritePatternBuffer_t mSpritePatternBuffer = {{ TILE_ROW_LSB_PLANE }}; // Decoded (and flipped) tile rows
     u8 mOamTransfertBuffer;
     u8 mOamSpriteIdx;
     u8 mOamByteIdx;
@@ -117,16 +285,27 @@ private:
     bool mIsNextLineSprite0InRenderBuffer;
     bool mIsSprite0InRenderBuffer;
 
+    // Sprite line buffer: the 8 sprites composited once per scanline
+    // Pixel is: 0ZBC'CCCC (Z: sprite 0, B: behind background, C: color address, 0 if transparent)
+    static constexpr u8 SPRITE_PIXEL_COLOR_MASK = 0b0001'1111;
+    static constexpr u8 SPRITE_PIXEL_BEHIND_BG  = 0b0010'0000;
+    static constexpr u8 SPRITE_PIXEL_SPRITE_0   = 0b0100'0000;
+    static constexpr u16 SPRITE_LINE_BUFFER_INVALID = 0xFFFF;
+    spriteLineBuffer_t mSpriteLineBuffer;
+    u16 mSpriteLineBufferRow;
+    u8 mSpriteLineBufferHeight;
+
     // Palette RAM
-	static constexpr u32 PALETTE_RAM_SIZE = 0x0020; // 32 B
-    std::array<u8, PALETTE_RAM_SIZE> mPaletteRam;
+    paletteRam_t mPaletteRam;
+    paletteRgb_t mPaletteRgb;
+    paletteColorCodes_t mPaletteColorCodes;
 
     // NMI
     bool mVBlankNMISignal;
     bool mNMICanOccur;
 
     // Color Lookup table
-    static constexpr std::array<std::array<u8, 3>, 64> LUT = 
+    static constexpr colorLut_t LUT = 
     {{
         { 0x66, 0x66, 0x66 }, 
         { 0x00, 0x2a, 0x88 }, 
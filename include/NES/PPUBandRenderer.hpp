@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "NES/Config.hpp"
+#include "NES/PPU.hpp"
+#include "NES/PixelCompositor.hpp"
+
+/// @brief Renders the pictures of the PPU from its frame logs, by horizontal bands on worker threads
+///
+/// A frame is rendered while the emulation runs the next one. Its picture is displayed
+/// when the next frame is submitted (one frame late).
+class PPUBandRenderer
+{
+public:
+	PPUBandRenderer(u32 threadCount, const picture_t& initialPicture, const indexedPicture_t& initialIndexedPicture);
+	~PPUBandRenderer();
+
+	inline u32 getThreadCount() const { return (u32)mWorkers.size(); }
+	inline PPUFrameLog& getRecordingLog() { return *mRecordingLog; }
+
+	// Waits for the previous frame (then displayed) & starts rendering the recorded one
+	void submitRecordingLog();
+	void waitForFrame();
+
+	inline const picture_t& getPicture() const { return mPictures[mDisplayedIdx]; }
+	inline const indexedPicture_t& getIndexedPicture() const { return mIndexedPictures[mDisplayedIdx]; }
+
+private:
+	static constexpr u16 BAND_HEIGHT = 16;
+	static constexpr u32 BAND_COUNT = (PPU_OUTPUT_HEIGHT + BAND_HEIGHT - 1) / BAND_HEIGHT;
+
+	void runWorker();
+	void renderBand(u32 bandIdx);
+
+	// Frame logs
+	std::unique_ptr<PPUFrameLog> mRecordingLog;
+	std::unique_ptr<PPUFrameLog> mRenderingLog;
+
+	// Pictures (displayed one & rendered one)
+	std::unique_ptr<picture_t[]> mPictures;
+	std::unique_ptr<indexedPicture_t[]> mIndexedPictures;
+	u32 mDisplayedIdx;
+	u32 mRenderingIdx;
+
+	PixelCompositor mPixelCompositor;
+
+	// Workers
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	std::condition_variable mWorkCondition;
+	std::condition_variable mDoneCondition;
+	std::atomic<u32> mNextBandIdx;
+	u32 mRemainingBandCount;
+	u64 mFrameIdx;
+	bool mIsExiting;
+};
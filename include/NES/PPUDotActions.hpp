@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include "NES/Config.hpp"
+
+constexpr u16 PPU_DOTS_PER_SCANLINE = 341;
+constexpr u16 PPU_SCANLINES_PER_FRAME = 262;
+
+// Work of the PPU on a dot (done in this order when there are several)
+using dotActions_t = u32;
+constexpr dotActions_t DOT_PRE_RENDER_START   = 1 << 0;  // Registers writable (first pre-render scanline passed)
+constexpr dotActions_t DOT_FRAME_START        = 1 << 1;  // Clear status flags, start a frame
+constexpr dotActions_t DOT_FETCH_NT           = 1 << 2;  // Nametable byte (tile fetches, garbage & dummy fetches)
+constexpr dotActions_t DOT_FETCH_AT           = 1 << 3;  // Attribute table byte
+constexpr dotActions_t DOT_FETCH_PT_LO        = 1 << 4;  // Tile LSB
+constexpr dotActions_t DOT_FETCH_PT_HI        = 1 << 5;  // Tile MSB
+constexpr dotActions_t DOT_RENDER_TILE        = 1 << 6;  // Render the fetched tile
+constexpr dotActions_t DOT_INC_X              = 1 << 7;  // Increment reg.v: coarse X
+constexpr dotActions_t DOT_INC_Y              = 1 << 8;  // Increment reg.v: Y
+constexpr dotActions_t DOT_COPY_X             = 1 << 9;  // reg.t -> reg.v: horizontal bits
+constexpr dotActions_t DOT_COPY_Y             = 1 << 10; // reg.t -> reg.v: vertical bits
+constexpr dotActions_t DOT_RESET_OAM_ADDR     = 1 << 11;
+constexpr dotActions_t DOT_SPRITE_RESET       = 1 << 12; // Sprite evaluation: reset counters
+constexpr dotActions_t DOT_SPRITE_CLEAR       = 1 << 13; // Sprite evaluation: clear a secondary OAM byte
+constexpr dotActions_t DOT_SPRITE_EVAL_READ   = 1 << 14; // Sprite evaluation: read from primary OAM
+constexpr dotActions_t DOT_SPRITE_EVAL_WRITE  = 1 << 15; // Sprite evaluation: write into secondary OAM
+constexpr dotActions_t DOT_SPRITE_LOAD        = 1 << 16; // Secondary OAM -> sprite render buffer
+constexpr dotActions_t DOT_SPRITE_FETCH       = 1 << 17; // Sprite pattern byte
+constexpr dotActions_t DOT_VBLANK_START       = 1 << 18; // Set VBlank flag & NMI
+
+constexpr dotActions_t DOT_BG_FETCH_ACTIONS = DOT_FETCH_NT | DOT_FETCH_AT | DOT_FETCH_PT_LO | DOT_FETCH_PT_HI;
+constexpr dotActions_t DOT_SPRITE_ACTIONS = DOT_SPRITE_RESET | DOT_SPRITE_CLEAR | DOT_SPRITE_EVAL_READ | DOT_SPRITE_EVAL_WRITE | DOT_SPRITE_LOAD | DOT_SPRITE_FETCH;
+
+// Scanlines of a same type have the same dot actions
+enum class ScanlineType : u8
+{
+	VISIBLE,
+	LAST_VISIBLE,  // Next scanline tiles are not rendered
+	IDLE,
+	VBLANK_START,
+	PRE_RENDER,
+	COUNT
+};
+
+constexpr ScanlineType computeScanlineType(u16 scanline)
+{
+	if (scanline < 239)
+		return ScanlineType::VISIBLE;
+	else if (scanline == 239)
+		return ScanlineType::LAST_VISIBLE;
+	else if (scanline == 241)
+		return ScanlineType::VBLANK_START;
+	else if (scanline == 261)
+		return ScanlineType::PRE_RENDER;
+	else
+		return ScanlineType::IDLE;
+}
+
+constexpr dotActions_t computeDotActions(ScanlineType type, u16 dot)
+{
+	if (type == ScanlineType::VBLANK_START)
+		return (dot == 1) ? DOT_VBLANK_START : 0;
+	else if (type == ScanlineType::IDLE)
+		return 0;
+
+	dotActions_t actions = 0;
+	bool isPreRender = type == ScanlineType::PRE_RENDER;
+	bool isEvenDot = (dot % 2) == 0;
+
+	if (isPreRender && dot == 0)
+		actions |= DOT_PRE_RENDER_START;
+	if (isPreRender && dot == 1)
+		actions |= DOT_FRAME_START;
+
+	// Background tile fetches (HW use two dots per fetch, the emulation does it on the second one)
+	bool isTileFetchDot = (1 <= dot && dot <= 256) || (321 <= dot && dot <= 336);
+	if (isTileFetchDot && isEvenDot)
+	{
+		switch ((dot - 1) % 8)
+		{
+			case 1: actions |= DOT_FETCH_NT; break;
+			case 3: actions |= DOT_FETCH_AT; break;
+			case 5: actions |= DOT_FETCH_PT_LO; break;
+			default:
+			{
+				actions |= DOT_FETCH_PT_HI | DOT_INC_X;
+
+				bool isUnusedTileFetch = (248 < dot && dot <= 256) || (type == ScanlineType::LAST_VISIBLE && dot > 256);
+				if (!isUnusedTileFetch)
+					actions |= DOT_RENDER_TILE;
+				break;
+			}
+		}
+	}
+
+	// Dummy pattern table LSB fetch
+	if (!isPreRender && dot == 0)
+		actions |= DOT_FETCH_PT_LO;
+
+	if (dot == 256)
+		actions |= DOT_INC_Y;
+	if (dot == 257)
+		actions |= DOT_COPY_X;
+	if (isPreRender && 280 <= dot && dot <= 304)
+		actions |= DOT_COPY_Y;
+
+	// Sprite fetches (with garbage nametable fetches)
+	if (257 <= dot && dot <= 320)
+	{
+		actions |= DOT_RESET_OAM_ADDR;
+		if (isEvenDot && ((dot - 1) % 8) < 4)
+			actions |= DOT_FETCH_NT;
+		else if (isEvenDot)
+			actions |= DOT_SPRITE_FETCH;
+	}
+
+	// Dummy nametable fetches
+	// (the pre-render scanline always lasts 341 dots: the odd frame dot skip is not emulated)
+	if (dot > 336 && isEvenDot)
+		actions |= DOT_FETCH_NT;
+
+	// Sprite evaluation (none in pre-render scanline)
+	if (!isPreRender && dot == 0)
+		actions |= DOT_SPRITE_RESET;
+	else if (!isPreRender && 1 <= dot && dot <= 64 && !isEvenDot)
+		actions |= DOT_SPRITE_CLEAR;
+	else if (!isPreRender && 65 <= dot && dot <= 256)
+		actions |= isEvenDot ? DOT_SPRITE_EVAL_WRITE : DOT_SPRITE_EVAL_READ;
+
+	if (dot == 257)
+		actions |= DOT_SPRITE_LOAD;
+
+	return actions;
+}
+
+using scanlineDotActions_t = std::array<dotActions_t, PPU_DOTS_PER_SCANLINE>;
+using dotActionTable_t = std::array<scanlineDotActions_t, (u8)ScanlineType::COUNT>;
+using scanlineTypeTable_t = std::array<ScanlineType, PPU_SCANLINES_PER_FRAME>;
+
+constexpr dotActionTable_t computeDotActionTable()
+{
+	dotActionTable_t table = {};
+	for (u8 type = 0; type < (u8)ScanlineType::COUNT; type++)
+		for (u16 dot = 0; dot < PPU_DOTS_PER_SCANLINE; dot++)
+			table[type][dot] = computeDotActions((ScanlineType)type, dot);
+
+	return table;
+}
+
+constexpr scanlineTypeTable_t computeScanlineTypeTable()
+{
+	scanlineTypeTable_t table = {};
+	for (u16 scanline = 0; scanline < PPU_SCANLINES_PER_FRAME; scanline++)
+		table[scanline] = computeScanlineType(scanline);
+
+	return table;
+}
+
+// Dot actions of a frame: 5 scanline types x 341 dots (+ the type of the 262 scanlines)
+inline constexpr dotActionTable_t PPU_DOT_ACTIONS = computeDotActionTable();
+inline constexpr scanlineTypeTable_t PPU_SCANLINE_TYPES = computeScanlineTypeTable();
+
+inline const scanlineDotActions_t& getScanlineDotActions(u16 scanline)
+{
+	return PPU_DOT_ACTIONS[(u8)PPU_SCANLINE_TYPES[scanline]];
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include "NES/Config.hpp"
+
+// RGB color of each palette RAM entry, one table per channel
+constexpr u32 PALETTE_ENTRIES = 32;
+using paletteRgb_t = std::array<std::array<u8, PALETTE_ENTRIES>, 3>;
+
+// Color code (6 bits) of each palette RAM entry
+using paletteColorCodes_t = std::array<u8, PALETTE_ENTRIES>;
+
+/// @brief Final background/sprite priority mux & palette lookup, over runs of pixels
+///
+/// BG pixel is:     0000'PPCC (P: palette, C: color index, transparent if 0)
+/// Sprite pixel is: 0ZBC'CCCC (Z: sprite 0, B: behind background, C: color address, transparent if 0)
+/// Output is RGB (3 bytes per pixel) or indexed (EEEC'CCCC u16, E: emphasis, C: color code)
+class PixelCompositor
+{
+public:
+	enum class Implementation
+	{
+		SCALAR,
+		SSE2,
+		AVX2
+	};
+
+	// Best implementation supported by the CPU
+	PixelCompositor();
+
+	static bool isImplementationSupported(Implementation implementation);
+	bool setImplementation(Implementation implementation);
+	inline Implementation getImplementation() const { return mImplementation; }
+
+	inline void composePixels(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteRgb_t& paletteRgb, u8* rgbOutput) const
+	{
+		mComposePixelsFunction(bgPixels, spritePixels, pixelCount, paletteRgb, rgbOutput);
+	}
+
+	inline void composeIndexedPixels(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput) const
+	{
+		mComposeIndexedPixelsFunction(bgPixels, spritePixels, pixelCount, colorCodes, emphasisBits, indexedOutput);
+	}
+
+private:
+	using composePixelsFunction_t = void (*)(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteRgb_t& paletteRgb, u8* rgbOutput);
+	using composeIndexedPixelsFunction_t = void (*)(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput);
+
+	static void composePixelsScalar(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteRgb_t& paletteRgb, u8* rgbOutput);
+	static void composePixelsSse2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteRgb_t& paletteRgb, u8* rgbOutput);
+	static void composePixelsAvx2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteRgb_t& paletteRgb, u8* rgbOutput);
+
+	static void composeIndexedPixelsScalar(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput);
+	static void composeIndexedPixelsSse2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput);
+	static void composeIndexedPixelsAvx2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput);
+
+	Implementation mImplementation;
+	composePixelsFunction_t mComposePixelsFunction;
+	composeIndexedPixelsFunction_t mComposeIndexedPixelsFunction;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <type_traits>
+#include <vector>
+
+#include "NES/Config.hpp"
+#include "NES/CPU.hpp"
+#include "NES/APU.hpp"
+#include "NES/APUBlipBuffer.hpp"
+#include "NES/PPU.hpp"
+#include "NES/Memory.hpp"
+
+// Save state of the console, in memory (a few tens of kB, copied in a few microseconds).
+// The sound samples the app has not taken yet and the settings are not part of it.
+struct nesState_t
+{
+	// Chips without pointers are copied as they are (the CPU keeps the predecoded opcode, not its LUT entry)
+	CPU cpu;
+	APU apu;
+	ppuState_t ppu;
+	memoryState_t memory;
+
+	// Scheduler
+	s32 cpuCyclesPredicted;
+	s32 cpuCyclesElapsed;
+	s32 pendingCpuCycles;
+	s32 cpuCyclesToNextEvent;
+	bool isDmaGetCycle;
+	bool isNmiSet;
+	bool isIrqSet;
+
+	// Sound
+	blipBufferState_t blipBuffer;
+	u32 blipClock;
+	float apuOutput;
+	u32 apuSampleClock;
+};
+static_assert(std::is_trivially_copyable_v<CPU> && std::is_trivially_copyable_v<APU>, "CPU & APU states are plain copies");
+
+// Binary save state: version of the format, to bump whenever a saved struct changes
+constexpr u32 SAVE_STATE_VERSION = 2;
+
+// Console a binary save state is loaded into: the sizes & the mapper read from the buffer must be its own
+struct saveStateShape_t
+{
+	u64 romHash;
+	u32 prgRamSize;
+	u32 chrRamSize;
+	u32 mapperIdx;
+	u32 blipDeltasSize;
+	u32 blipSampleCapacity;
+};
+
+/// @brief Binary image of a save state
+///
+/// Header (magic, version, ROM hash), then the fields one by one in native byte order
+/// (no padding, no pointer). The buffer keeps its capacity: once it has been big enough,
+/// saves & loads make no allocation. CHR-RAM tile rows are decoded again on load.
+void serializeNesState(const nesState_t& state, u64 romHash, std::vector<u8>& buffer);
+
+// False if the buffer is not a save state of this version & console: truncated buffers, other sizes,
+// other mapper, invalid booleans and out-of-range indices & cycle counts are rejected
+// (the state is then partly read). The state must be the one of the console: the fields that are not
+// saved (ROM shape, tables) are kept. There is no checksum: registers in range are taken as they are.
+bool deserializeNesState(const std::vector<u8>& buffer, const saveStateShape_t& shape, nesState_t& state);
@@ -3,7 +3,6 @@
 #include <string>
 #include <array>
 #include <complex>
-#include <deque>
 #include <algorithm>
 #include "NES/Config.hpp"
 #include "IO/SoundManager.hpp"
@@ -14,24 +13,17 @@ void traceLog(const std::string& log);
 float limitToInterval(float value, float min, float max);
 
 template <typename T>
-void popAndPush(std::deque<T>& fifo, T value)
+s32 getScopeTriggerOffset(const T* samples, u32 sampleCount)
 {
-	fifo.pop_front();
-	fifo.push_back(value);
-}
-
-template <typename T, size_t S>
-s32 getScopeTriggerOffset(const std::array<T, S>& array)
-{
-    T minValue = *std::min_element(array.begin(), array.end());
-    T maxValue = *std::max_element(array.begin(), array.end());
+    T minValue = *std::min_element(samples, samples + sampleCount);
+    T maxValue = *std::max_element(samples, samples + sampleCount);
     T average = 0.5f * (minValue + maxValue);
 
     s32 sampleMiddleOffset = 0;
-    for (u32 i = (BUFFER_SIZE / 4); i < (3 * (BUFFER_SIZE / 4)); i++)
+    for (u32 i = (sampleCount / 4); i < (3 * (sampleCount / 4)); i++)
     {
-        T currentValue = array[i];
-        T nextValue = array[i + 1];
+        T currentValue = samples[i];
+        T nextValue = samples[i + 1];
         if (currentValue <= average && average < nextValue)
         {
             sampleMiddleOffset = i;
@@ -39,11 +31,11 @@ s32 getScopeTriggerOffset(const std::array<T, S>& array)
         }
     }
 
-    return sampleMiddleOffset > 0 ? sampleMiddleOffset - (BUFFER_SIZE / 4) : 0;
+    return sampleMiddleOffset > 0 ? sampleMiddleOffset - (sampleCount / 4) : 0;
 }
 
 template <unsigned int S>
-void fftMagnitude(const std::array<float, S>& signal, std::array<float, S>& spectrum)
+void fftMagnitude(const float* signal, std::array<float, S>& spectrum)
 {
 	using complex = std::complex<float>;
 	
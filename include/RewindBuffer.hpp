@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "NES/Config.hpp"
+#include "NES/NES.hpp"
+
+struct rewindStats_t
+{
+	double durationS;        // Time which can be rewound
+	u64 storedBytes;         // Compressed snapshots + the latest one
+	double compressionRatio; // Snapshot size / compressed size
+};
+
+/// @brief History of the frames to rewind
+///
+/// The emulation thread serializes the console at each frame into a queue of snapshots.
+/// A worker XORs each snapshot with the previous one and run-length encodes the (mostly zero) result:
+/// from the latest snapshot, the deltas give back the previous ones. The oldest deltas are dropped
+/// to stay within the memory budget.
+class RewindBuffer
+{
+public:
+	RewindBuffer();
+	~RewindBuffer();
+
+	// Emulation thread: the snapshot is dropped when the worker is behind (no wait)
+	void saveFrame(NES& nes);
+	// Emulation thread: loads the frame before the latest one (which becomes the latest), false at the oldest one
+	bool loadPreviousFrame(NES& nes);
+	// Thread which saves the frames (or once it is stopped): the queued snapshots are dropped with the history
+	void clear();
+
+	inline void setMemoryBudget(u64 byteCount) { mMemoryBudget.store(byteCount, std::memory_order_relaxed); }
+	rewindStats_t getStats() const;
+
+private:
+	static constexpr u32 SNAPSHOT_QUEUE_SIZE = 4;
+	static constexpr std::chrono::microseconds DRAIN_POLL_PERIOD{ 100 };
+
+	// Run-length encoding of the delta: [zero count (u16)][literal count (u16)][literals]...
+	// (zero runs shorter than a token header are kept in the literals)
+	static constexpr u32 MAX_RUN_LENGTH = 0xFFFF;
+	static constexpr u32 MIN_ZERO_RUN_LENGTH = 2 * sizeof(u16);
+
+	void runWorker();
+	void waitForQueuedSnapshots();
+	void compressSnapshot(const std::vector<u8>& snapshot);
+	void evictOldestDeltas();
+	void recycleDelta(std::vector<u8>& delta);
+	void updateStats();
+
+	static void encodeDelta(const std::vector<u8>& previous, const std::vector<u8>& current, std::vector<u8>& delta);
+	static void decodeDelta(const std::vector<u8>& delta, std::vector<u8>& state);
+
+	// Emulation thread -> worker
+	std::array<std::vector<u8>, SNAPSHOT_QUEUE_SIZE> mSnapshots;
+	std::atomic<u32> mSnapshotWriteIdx;
+	std::atomic<u32> mSnapshotReadIdx;
+	std::mutex mQueueMutex; // The worker sleeps until a snapshot is queued
+	std::condition_variable mQueueCondition;
+
+	// Worker (& the emulation thread while rewinding, the worker is idle then)
+	std::mutex mHistoryMutex;
+	std::vector<u8> mLatestSnapshot;
+	std::deque<std::vector<u8>> mDeltas; // Oldest first
+	static constexpr u32 MAX_FREE_DELTAS = 16;
+	std::vector<std::vector<u8>> mFreeDeltas; // Buffers of the dropped deltas, reused by the next ones
+	u64 mDeltaBytes;
+
+	std::atomic<u64> mMemoryBudget;
+	std::atomic<u32> mStoredFrameCount;
+	std::atomic<u64> mStoredBytes;
+	std::atomic<u64> mLatestSnapshotSize;
+
+	std::atomic<bool> mIsWorkerRunning;
+	std::thread mWorker;
+};
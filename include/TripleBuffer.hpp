@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "NES/Config.hpp"
+
+/// @brief Lock-free handoff of the latest value from a producer thread to a consumer thread
+///
+/// The producer writes a back buffer then publishes it, the consumer takes the last published one.
+/// The buffers are swapped through the middle slot: nobody waits, values the consumer
+/// did not take in time are overwritten.
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+	{
+		mBuffers = std::make_unique<T[]>(3);
+		mWriteIdx = 0;
+		mMiddle.store(1, std::memory_order_relaxed);
+		mReadIdx = 2;
+	}
+
+	// Producer
+	inline T& getWriteBuffer() { return mBuffers[mWriteIdx]; }
+	inline void publish()
+	{
+		u8 previousMiddle = mMiddle.exchange(mWriteIdx | NEW_FLAG, std::memory_order_acq_rel);
+		mWriteIdx = previousMiddle & IDX_MASK;
+	}
+
+	// Consumer (returns false when nothing was published since the last update)
+	inline bool isNewAvailable() const { return (mMiddle.load(std::memory_order_relaxed) & NEW_FLAG) != 0; }
+	inline bool update()
+	{
+		if (!isNewAvailable())
+			return false;
+
+		u8 previousMiddle = mMiddle.exchange(mReadIdx, std::memory_order_acq_rel);
+		mReadIdx = previousMiddle & IDX_MASK;
+		return true;
+	}
+	inline const T& getReadBuffer() const { return mBuffers[mReadIdx]; }
+
+private:
+	static constexpr u8 IDX_MASK = 0b0000'0011;
+	static constexpr u8 NEW_FLAG = 0b0000'0100;
+
+	std::unique_ptr<T[]> mBuffers;
+	u8 mWriteIdx;
+	std::atomic<u8> mMiddle;
+	u8 mReadIdx;
+};
@@ -2,7 +2,10 @@
 
 #include <cstdlib>
 #include <iostream>
-#include <chrono>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <iterator>
 #include "NES/NES.hpp"
 #include "NES/Cartridge.hpp"
 #include "NES/Toolbox.hpp"
@@ -12,7 +15,9 @@
 #include <cmath>
 
 App::App()
+	: mFramePacer(FRAME_PERIOD_NTSC, mSoundManager)
 {
+	mIsRewindEnabled = false;
 }
 
 int App::run()
@@ -50,7 +55,10 @@ void App::processIdleState(GlfwApp& appWindow)
 	constexpr picture_t BLANK_SCREEN = { 0 };
 
 	while (!appWindow.shouldWindowClose() && !appWindow.isRomOpened())
+	{
+		mFramePacer.waitForIdleFrame();
 		appWindow.draw(BLANK_SCREEN);
+	}
 	
 	mAppState = AppState::PLAYING;
 }
@@ -67,8 +75,6 @@ void App::showErrorWindow(GlfwApp &appWindow)
 
 void App::playGame(GlfwApp& appWindow)
 {
-	using std::chrono::steady_clock;
-	
 	// *************** NES Emulation *************** //
 	NES nes(mController1, mController2, appWindow.getRomName());
 	appWindow.clearIsRomOpened();
@@ -81,80 +87,243 @@ void App::playGame(GlfwApp& appWindow)
 		return;
 	}
 
-	linkFifosToWindow(nes, appWindow);
+	appWindow.setSoundTapsPtr(&nes.getSoundTaps());
 
-    mTimePrevious = steady_clock::now();
-	mElapsedTimeOffset = 0;
+	// The controllers take the latest inputs when the game strobes them
+	mController1.setStrobeCallback([&appWindow]() { return appWindow.getLatestControllerState(true); });
+	mController2.setStrobeCallback([&appWindow]() { return appWindow.getLatestControllerState(false); });
+
+	// Emulation thread (settings are published before it starts)
+	publishSettings(appWindow);
+	mIsEmulationRunning = true;
+	std::thread emulationThread(&App::runEmulation, this, std::ref(nes));
 
 	while (!appWindow.shouldWindowClose() && !appWindow.isRomOpened())
 	{
+		publishSettings(appWindow);
+		updateSoundTaps(appWindow, nes);
+
+		// Video & Inputs (the UI is drawn even without a new frame: pause, slow emulation)
+		waitForFrame(appWindow);
+		mFrames.update();
+		if (mStats.update())
+		{
+			const emulationStats_t& stats = mStats.getReadBuffer();
+			appWindow.setFramePacingStats(stats.framePacing);
+			appWindow.setSoundStreamStats(stats.soundQueueDepth, 
+			                              stats.soundLatency, 
+			                              stats.soundUnderrunCount, 
+			                              stats.soundSampleRateRatio);
+			appWindow.setRewindStats(stats.rewind);
+		}
+		drawFrame(appWindow, mFrames.getReadBuffer());
+		mFramePacer.signalFramePresented();
+	}
+
+	mIsEmulationRunning = false;
+	emulationThread.join();
+	mRewindBuffer.clear();
+
+	// The sound taps are gone with the NES
+	appWindow.setSoundTapsPtr(nullptr);
+	mController1.setStrobeCallback(nullptr);
+	mController2.setStrobeCallback(nullptr);
+}
+
+void App::publishSettings(GlfwApp &appWindow)
+{
+	emulationSettings_t& settings = mSettings.getWriteBuffer();
+	settings.isPaused = appWindow.isPaused();
+	settings.pictureFormat = appWindow.getPictureFormat();
+	settings.renderingThreadCount = appWindow.getRenderingThreadCount();
+	settings.runAheadFrameCount = appWindow.getRunAheadFrameCount();
+	settings.isRewindEnabled = appWindow.isRewindEnabled();
+	settings.isRewinding = appWindow.isRewinding();
+	settings.rewindMemoryBudget = appWindow.getRewindMemoryBudget();
+	settings.masterVolume = appWindow.getMasterVolume();
+	settings.pacingSource = appWindow.getPacingSource();
+	settings.soundBufferSize = appWindow.getSoundBufferSize();
+	settings.soundBufferCount = appWindow.getSoundBufferCount();
+	mSettings.publish();
+}
+
+void App::waitForFrame(GlfwApp& appWindow)
+{
+	// A frame period at most
+	using std::chrono::steady_clock;
+	auto framePeriod = std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(FRAME_PERIOD_NTSC));
+	steady_clock::time_point timeout = steady_clock::now() + framePeriod;
+	bool isLateInputPollingEnabled = appWindow.isLateInputPollingEnabled();
+	while (!mFrames.isNewAvailable() && steady_clock::now() < timeout)
+	{
+		// Late input polling: the inputs the game strobes are a poll period old at most
+		// (GLFW events can only be polled on this thread)
+		if (isLateInputPollingEnabled)
+			appWindow.pollInputs();
+		std::this_thread::sleep_for(FRAME_POLL_PERIOD);
+	}
+}
+
+void App::drawFrame(GlfwApp &appWindow, const videoFrame_t& frame)
+{
+	if (frame.format == PictureFormat::INDEXED)
+		appWindow.draw(frame.indexedPicture);
+	else
+		appWindow.draw(frame.picture);
+}
+
+void App::updateSoundTaps(GlfwApp &appWindow, NES &nes)
+{
+	// Sound signals are only recorded while they are plotted
+	SoundTaps& soundTaps = nes.getSoundTaps();
+	bool isChannelsWindowOpen = appWindow.isSoundChannelsWindowOpen();
+	soundTaps.setSubscribed(SoundTap::OUTPUT, isChannelsWindowOpen || appWindow.isSpectrumWindowOpen());
+	soundTaps.setSubscribed(SoundTap::PULSE1, isChannelsWindowOpen);
+	soundTaps.setSubscribed(SoundTap::PULSE2, isChannelsWindowOpen);
+	soundTaps.setSubscribed(SoundTap::TRIANGLE, isChannelsWindowOpen);
+	soundTaps.setSubscribed(SoundTap::NOISE, isChannelsWindowOpen);
+	soundTaps.setSubscribed(SoundTap::DMC, isChannelsWindowOpen);
+}
+
+void App::runEmulation(NES &nes)
+{
+	mFramePacer.reset();
+	mFramesToSkip = 0;
+	mSkippedFrameCount = 0;
+
+	while (mIsEmulationRunning.load(std::memory_order_relaxed))
+	{
+		mSettings.update();
+		const emulationSettings_t& settings = mSettings.getReadBuffer();
+
 		// Pause
-		if (appWindow.isPaused())
+		if (settings.isPaused)
 		{
-			appWindow.draw(nes.getPicture());
-			mTimePrevious = steady_clock::now();
+			mFramePacer.waitForIdleFrame();
+			continue;
+		}
 
+		// Rewind
+		applySettings(nes, settings);
+		if (settings.isRewinding && mIsRewindEnabled)
+		{
+			rewindFrame(nes);
 			continue;
 		}
 
 		// Emulation
-		nes.runOneCpuInstruction();
+		nes.runCpuBurst();
 
-		// Video & Inputs
+		// Video (the snapshot is compressed by the rewind worker)
 		if (nes.isImageReady())
 		{
 			nes.clearIsImageReady();
-			sendPictureToWindow(appWindow, nes.getPicture());
-
-			// Update volume
-			nes.setMasterVolume(appWindow.getMasterVolume());
+			if (mIsRewindEnabled)
+				mRewindBuffer.saveFrame(nes);
+			if (nes.isFrameRenderingSkipped())
+				mSkippedFrameCount++;
+			else
+				publishFrame(nes);
+			updateFrameSkip(nes);
+			publishStats();
 		}
 
-		// Sound
-		if (nes.isSoundBufferReady())
+		// Sound (streamed by the audio thread)
+		if (nes.areSoundSamplesReady())
 		{
-			nes.clearIsSoundBufferReady();
-
-			// Push sample to sound stream
-			mSoundManager.streamSound(*nes.getSoundBufferPtr());
+			mSoundManager.pushSamples(nes.getSoundSamples(), nes.getSoundSampleCount());
+			nes.clearSoundSamples();
+			nes.setSoundSampleRateRatio(mSoundManager.getSampleRateRatio());
 		}
 	}
 }
 
-void App::sendPictureToWindow(GlfwApp &appWindow, const picture_t &picture)
+void App::applySettings(NES &nes, const emulationSettings_t &settings)
 {
-	using std::chrono::steady_clock;
-	using std::chrono::duration;
-	
-	steady_clock::time_point timeNow;
-	double elapsedTime;
+	nes.setPictureFormat(settings.pictureFormat);
+	nes.setBandRenderingThreadCount(settings.renderingThreadCount);
+	nes.setRunAheadFrameCount(settings.runAheadFrameCount);
+	nes.setMasterVolume(settings.masterVolume);
 
-	// Wait before rendering -> 60 FPS
-	do
+	// Audio clock: the sound queue depth is kept by the pacing instead of the rate control
+	mFramePacer.setSource(settings.pacingSource);
+	mSoundManager.setRateControlEnabled(settings.pacingSource != PacingSource::AUDIO);
+	mSoundManager.setStreamBuffers(settings.soundBufferSize, settings.soundBufferCount);
+
+	// Rewind: the history is dropped when disabled
+	if (mIsRewindEnabled && !settings.isRewindEnabled)
+		mRewindBuffer.clear();
+	mIsRewindEnabled = settings.isRewindEnabled;
+	mRewindBuffer.setMemoryBudget(settings.rewindMemoryBudget);
+}
+
+void App::publishFrame(NES &nes)
+{
+	// Wait before publishing -> 60 FPS (skipped frames included)
+	double delay = mFramePacer.waitForFrames(mSkippedFrameCount + 1);
+
+	// Frames to skip to get back to real time
+	mFramesToSkip = (u8)std::min(delay / FRAME_PERIOD_NTSC, (double)MAX_SKIPPED_FRAMES);
+	mSkippedFrameCount = 0;
+
+	// Only the picture of the current format is copied
+	videoFrame_t& frame = mFrames.getWriteBuffer();
+	frame.format = mSettings.getReadBuffer().pictureFormat;
+	if (frame.format == PictureFormat::INDEXED)
+		frame.indexedPicture = nes.getIndexedPicture();
+	else
+		frame.picture = nes.getPicture();
+	mFrames.publish();
+}
+
+void App::publishStats()
+{
+	emulationStats_t& stats = mStats.getWriteBuffer();
+	stats.framePacing = mFramePacer.getStats();
+	stats.soundQueueDepth = mSoundManager.getQueueDepth();
+	stats.soundLatency = mSoundManager.getLatency();
+	stats.soundUnderrunCount = mSoundManager.getUnderrunCount();
+	stats.soundSampleRateRatio = mSoundManager.getSampleRateRatio();
+	stats.rewind = mRewindBuffer.getStats();
+	mStats.publish();
+}
+
+void App::updateFrameSkip(NES &nes)
+{
+	// Next frame is only emulated (no picture) while there are frames to skip
+	bool isNextFrameSkipped = mSkippedFrameCount < mFramesToSkip;
+	nes.setNextFrameRenderingSkipped(isNextFrameSkipped);
+}
+
+void App::rewindFrame(NES &nes)
+{
+	// Oldest frame: the last picture stays displayed
+	if (!mRewindBuffer.loadPreviousFrame(nes))
 	{
-		timeNow = steady_clock::now();
-		elapsedTime = duration<double>(timeNow - mTimePrevious).count();
-	} while (elapsedTime + mElapsedTimeOffset < FRAME_PERIOD_NTSC);
+		mFramePacer.waitForIdleFrame();
+		return;
+	}
 
-	// Save time point and over delay
-	mTimePrevious = timeNow;
-	mElapsedTimeOffset += elapsedTime;
+	// The frame after the loaded one is emulated again for its picture & its sound
+	// (with the current inputs: the picture may differ from the one played), rendered right away
+	nes.clearSoundSamples();
+	nes.clearIsImageReady();
+	nes.setRunAheadFrameCount(0);
+	nes.setBandRenderingThreadCount(0);
+	nes.setNextFrameRenderingSkipped(false);
 	do
 	{
-		mElapsedTimeOffset -= FRAME_PERIOD_NTSC;
-	} while (mElapsedTimeOffset > FRAME_PERIOD_NTSC);
+		nes.runCpuBurst();
+	} while (!nes.isImageReady());
+	nes.clearIsImageReady();
 
-	// Render
-	appWindow.draw(picture);
-	
-}
+	// Sound played backwards
+	const float* soundSamples = nes.getSoundSamples();
+	mReversedSoundSamples.assign(std::make_reverse_iterator(soundSamples + nes.getSoundSampleCount()), 
+	                             std::make_reverse_iterator(soundSamples));
+	mSoundManager.pushSamples(mReversedSoundSamples.data(), (u32)mReversedSoundSamples.size());
+	nes.clearSoundSamples();
 
-void App::linkFifosToWindow(NES &nes, GlfwApp &window)
-{
-	window.setSoundFIFOPtr(nes.getSoundFIFOPtr());
-	window.setP1FIFOPtr(nes.getP1FIFOPtr());
-	window.setP2FIFOPtr(nes.getP2FIFOPtr());
-	window.setTriangleFIFOPtr(nes.getTriangleFIFOPtr());
-	window.setNoiseFIFOPtr(nes.getNoiseFIFOPtr());
-	window.setDmcFIFOPtr(nes.getDmcFIFOPtr());
+	publishFrame(nes);
+	publishStats();
 }
@@ -0,0 +1,153 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+FramePacer::FramePacer(double framePeriod, const SoundManager& soundManager)
+	: mSoundManager(soundManager)
+{
+	mSource = PacingSource::TIMER;
+	mFramePeriod = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(framePeriod));
+	mSpinDuration = MIN_SPIN_DURATION;
+	mPresentedFrameCount = 0;
+	mLastPresentedFrameCount = 0;
+	reset();
+}
+
+void FramePacer::reset()
+{
+	mNextFrameTime = clock::now();
+	mPreviousFrameTime = mNextFrameTime;
+	mIsSoundQueueStalled = false;
+
+	mStatsIdx = 0;
+	mStatsCount = 0;
+	mStats = { 0.0, 0.0, 0.0, 0.0 };
+}
+
+double FramePacer::waitForFrames(u32 frameCount)
+{
+	mNextFrameTime += frameCount * mFramePeriod;
+
+	switch (mSource)
+	{
+		case PacingSource::TIMER:
+			waitUntil(mNextFrameTime);
+			break;
+
+		case PacingSource::VSYNC:
+			waitForPresentedFrame();
+			break;
+
+		case PacingSource::AUDIO:
+			// Stalled stream: timer until the queue is drained again
+			if (mIsSoundQueueStalled)
+			{
+				waitUntil(mNextFrameTime);
+				mIsSoundQueueStalled = !mSoundManager.needsSamples();
+			}
+			else
+			{
+				waitForSoundQueue();
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	clock::time_point now = clock::now();
+	updateStats(now, frameCount);
+
+	// Delay behind the timer (other sources are ahead of it or behind it: the timer follows them)
+	double delay = std::chrono::duration<double>(now - mNextFrameTime).count();
+	if (delay < 0.0 || delay > MAX_CAUGHT_UP_DELAY)
+		mNextFrameTime = now;
+
+	return std::clamp(delay, 0.0, MAX_CAUGHT_UP_DELAY);
+}
+
+void FramePacer::waitForIdleFrame()
+{
+	mNextFrameTime = std::max(mNextFrameTime + mFramePeriod, clock::now());
+	waitUntil(mNextFrameTime);
+	mPreviousFrameTime = clock::now();
+}
+
+void FramePacer::waitUntil(clock::time_point deadline)
+{
+	// Sleep most of the period
+	clock::time_point sleepDeadline = deadline - mSpinDuration;
+	if (clock::now() < sleepDeadline)
+	{
+		std::this_thread::sleep_until(sleepDeadline);
+
+		// Spin longer when the OS wakes the thread up later than that
+		clock::duration wakeUpDelay = clock::now() - sleepDeadline;
+		clock::duration decayedSpinDuration = std::chrono::duration_cast<clock::duration>(mSpinDuration * SPIN_DURATION_DECAY);
+		mSpinDuration = std::max({ (clock::duration)MIN_SPIN_DURATION, wakeUpDelay, decayedSpinDuration });
+	}
+
+	// Spin the end of it
+	while (clock::now() < deadline)
+		std::this_thread::yield();
+}
+
+void FramePacer::waitForSoundQueue()
+{
+	// The queue is drained by the audio thread (polled every quarter of a stream buffer)
+	clock::time_point timeout = clock::now() + MAX_WAIT_FRAMES * mFramePeriod;
+	while (!mSoundManager.needsSamples())
+	{
+		if (clock::now() >= timeout)
+		{
+			mIsSoundQueueStalled = true;
+			return;
+		}
+		std::this_thread::sleep_for(MIN_SPIN_DURATION);
+	}
+}
+
+void FramePacer::waitForPresentedFrame()
+{
+	// The app thread presents frames at the display rate
+	clock::time_point timeout = clock::now() + MAX_WAIT_FRAMES * mFramePeriod;
+	while (mPresentedFrameCount.load(std::memory_order_acquire) == mLastPresentedFrameCount && clock::now() < timeout)
+		std::this_thread::sleep_for(PRESENT_POLL_PERIOD);
+
+	mLastPresentedFrameCount = mPresentedFrameCount.load(std::memory_order_relaxed);
+}
+
+void FramePacer::updateStats(clock::time_point now, u32 frameCount)
+{
+	using ms = std::chrono::duration<double, std::milli>;
+
+	double interval = ms(now - mPreviousFrameTime).count();
+	double expectedInterval = ms(frameCount * mFramePeriod).count();
+	mPreviousFrameTime = now;
+
+	mIntervals[mStatsIdx] = interval / frameCount;
+	mIntervalErrors[mStatsIdx] = interval - expectedInterval;
+	mStatsIdx = (mStatsIdx + 1) % STATS_HISTORY_SIZE;
+	mStatsCount = std::min(mStatsCount + 1, STATS_HISTORY_SIZE);
+
+	// Statistics of the last frames
+	double intervalSum = 0.0;
+	double errorSum = 0.0;
+	double errorSquareSum = 0.0;
+	double maxError = 0.0;
+	for (u32 i = 0; i < mStatsCount; i++)
+	{
+		intervalSum += mIntervals[i];
+		errorSum += mIntervalErrors[i];
+		errorSquareSum += mIntervalErrors[i] * mIntervalErrors[i];
+		maxError = std::max(maxError, std::abs(mIntervalErrors[i]));
+	}
+	double errorMean = errorSum / mStatsCount;
+
+	mStats.meanIntervalMs = intervalSum / mStatsCount;
+	mStats.jitterMs = std::sqrt(std::max(errorSquareSum / mStatsCount - errorMean * errorMean, 0.0));
+	mStats.maxErrorMs = maxError;
+	mStats.spinMs = ms(mSpinDuration).count();
+}
@@ -11,6 +11,8 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 static void resizeCallback(GLFWwindow* window, int windowWidth, int windowHeight);
@@ -64,7 +66,9 @@ GlfwApp::GlfwApp(Controller& controller1Ref, Controller& controller2Ref)
     initShader();
     initTexture(mPixelTexture);
     initTexture(mScreenTexture);
-    initFbo();
+    initIndexedTextures();
+    initFbo(mScreenFbo, mScreenTexture);
+    initFbo(mPaletteFbo, mPixelTexture);
     
     // OpenGL settings
     glEnable(GL_CULL_FACE);
@@ -74,15 +78,11 @@ GlfwApp::GlfwApp(Controller& controller1Ref, Controller& controller2Ref)
     mIsRomOpened = false;
     mIsFrameTimeWindowOpen = false;
     mFrameTimeHistoryDeque.resize(FRAMETIME_HISTORY_MAXSIZE);
+    mFramePacingStats = { 0.0, 0.0, 0.0, 0.0 };
 
     mIsSoundChannelsWindowOpen = false;
     mTimeArray = calculateTimeArray();
-    mSoundFIFOPtr = nullptr;
-    mP1FIFOPtr = nullptr;
-    mP2FIFOPtr = nullptr;
-    mTriangleFIFOPtr = nullptr;
-    mNoiseFIFOPtr = nullptr;
-    mDmcFIFOPtr = nullptr;
+    mSoundTapsPtr = nullptr;
 
     mIsSpectrumWindowOpen = false;
     mFrequencies = calculateFrequencyArray();
@@ -118,11 +118,14 @@ GlfwApp::~GlfwApp()
     ImGui::DestroyContext();
 
     glDeleteFramebuffers(1, &mScreenFbo);
+    glDeleteFramebuffers(1, &mPaletteFbo);
     glDeleteVertexArrays(1, &mScreenVao);
     glDeleteBuffers(1, &mScreenVbo);
     glDeleteBuffers(1, &mScreenEbo);
     glDeleteTextures(1, &mScreenTexture);
     glDeleteTextures(1, &mPixelTexture);
+    glDeleteTextures(1, &mIndexedPixelTexture);
+    glDeleteTextures(1, &mPaletteTexture);
     glfwDestroyWindow(mWindow);
     glfwTerminate();
 }
@@ -130,12 +133,22 @@ GlfwApp::~GlfwApp()
 void GlfwApp::initAudio()
 {
     mMasterVolume = 1.0f;
+    mSoundBufferSizeIdx = 2;
+    mSoundBufferCount = 3;
+    mSoundQueueDepth = 0;
+    mSoundLatency = 0;
+    mSoundUnderrunCount = 0;
+    mSoundSampleRateRatio = 1.0;
 }
 
 void GlfwApp::initVideo()
 {
     mCurrentFiltering = FILTERING_ITEMS[1];
     mCurrentShaderStr = SHADER_ITEMS[0];
+    mPictureFormat = PictureFormat::RGB;
+    mRenderingThreadCount = 0;
+    mPacingSource = PacingSource::TIMER;
+    mRunAheadFrameCount = 0;
 }
 
 void GlfwApp::initInputs()
@@ -161,6 +174,23 @@ void GlfwApp::initInputs()
         mAreGamepadsPlayer1Selected[i] = true;
         mAreGamepadsLayoutAlternative[i] = false;
     }
+
+    // Rewind
+    mIsRewindEnabled = true;
+    mIsRewinding = false;
+    mRewindMemoryBudgetMB = 32;
+    mRewindStats = { 0.0, 0, 0.0 };
+
+    // Late input polling
+    mIsLateInputPollingEnabled = false;
+    mController1Snapshot.store(0, std::memory_order_relaxed);
+    mController2Snapshot.store(0, std::memory_order_relaxed);
+    mInputChangeCount.store(0, std::memory_order_relaxed);
+    mInputChangeTime.store(0, std::memory_order_relaxed);
+    mLastInputPollTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    mStrobedInputChangeCount = 0;
+    mInputLatencyMs.store(0.0f, std::memory_order_relaxed);
+    mInputLatencyAverageMs.store(0.0f, std::memory_order_relaxed);
 }
 void GlfwApp::initVao()
 
@@ -195,6 +225,11 @@ void GlfwApp::initShader()
     mScreenShader = std::make_unique<Shader>(VERT_SHADER_DEFAULT, FRAG_SHADER_DEFAULT);
     mScreenShader->use();
     mScreenShader->setInt("screenTexture", 0);
+
+    mPaletteShader = std::make_unique<Shader>(VERT_SHADER_DEFAULT, FRAG_SHADER_PALETTE);
+    mPaletteShader->use();
+    mPaletteShader->setInt("indexedTexture", 0);
+    mPaletteShader->setInt("paletteTexture", 1);
 }
 
 void GlfwApp::initTexture(GLuint& textureObject)
@@ -213,13 +248,41 @@ void GlfwApp::initTexture(GLuint& textureObject)
     glGenerateMipmap(GL_TEXTURE_2D);
 }
 
-void GlfwApp::initFbo()
+void GlfwApp::initIndexedTextures()
 {
-    glGenFramebuffers(1, &mScreenFbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, mScreenFbo);
+    // Indexed pixels (integer texture: no filtering)
+    glGenTextures(1, &mIndexedPixelTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mIndexedPixelTexture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, PPU_OUTPUT_WIDTH, PPU_OUTPUT_HEIGHT, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+
+    // Palette (the 64 colours of the PPU, uploaded once)
+    glGenTextures(1, &mPaletteTexture);
+    glBindTexture(GL_TEXTURE_2D, mPaletteTexture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, COLOR_LUT_SIZE, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, PPU::getColorLut().data()->data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void GlfwApp::initFbo(GLuint& fboObject, GLuint textureObject)
+{
+    glGenFramebuffers(1, &fboObject);
+    glBindFramebuffer(GL_FRAMEBUFFER, fboObject);
 
     // Color
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mScreenTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureObject, 0);
 
     // Final check
     if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
@@ -234,17 +297,40 @@ void GlfwApp::initFbo()
 
 void GlfwApp::draw(const picture_t &pictureBuffer)
 {
-    // Reset controllers;
-    mController1State = 0;
-    mController2State = 0;
+    // Update pixel texture
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mPixelTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, PPU_OUTPUT_WIDTH, PPU_OUTPUT_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, pictureBuffer.data()->data()->data());
 
-    // Poll events
-    glfwPollEvents();
-    pollGamepads();
-    pollKeyboard();
+    drawFrame();
+}
 
-    // Update controllers
-    updateControllersState();
+void GlfwApp::draw(const indexedPicture_t &indexedPictureBuffer)
+{
+    // Update indexed texture (2 bytes per pixel instead of 3)
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mIndexedPixelTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, PPU_OUTPUT_WIDTH, PPU_OUTPUT_HEIGHT, GL_RED_INTEGER, GL_UNSIGNED_SHORT, indexedPictureBuffer.data()->data());
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, mPaletteTexture);
+
+    // Apply palette & emphasis -> pixel texture
+    glBindFramebuffer(GL_FRAMEBUFFER, mPaletteFbo);
+    mPaletteShader->use();
+    glBindVertexArray(mScreenVao);
+    glViewport(0, 0, PPU_OUTPUT_WIDTH, PPU_OUTPUT_HEIGHT);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mPixelTexture);
+
+    drawFrame();
+}
+
+void GlfwApp::drawFrame()
+{
+    pollInputs();
 
     // Clear frame buffer
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -260,13 +346,9 @@ void GlfwApp::draw(const picture_t &pictureBuffer)
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // Update screen texture
-    // SubImage
+    // Bind pixel texture, screen vao & shader
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, mPixelTexture);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, PPU_OUTPUT_WIDTH, PPU_OUTPUT_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, pictureBuffer.data()->data()->data());
-
-    // Bind screen vao & shader
     mScreenShader->use();
     mScreenShader->setInt("screenTexture", 0);
     mScreenShader->setFloat("time", (float)glfwGetTime());
@@ -350,6 +432,22 @@ bool GlfwApp::drawError()
     return isErrorWindowClosed;
 }
 
+void GlfwApp::pollInputs()
+{
+    // Reset controllers;
+    mController1State = 0;
+    mController2State = 0;
+
+    // Poll events
+    glfwPollEvents();
+    pollGamepads();
+    pollKeyboard();
+    mIsRewinding = glfwGetKey(mWindow, REWIND_KEY) == GLFW_PRESS;
+
+    // Update controllers
+    updateControllersState();
+}
+
 void GlfwApp::prepareControllersState(bool isPlayer1, ControllerInput input, bool isPressed)
 {
     if (isPlayer1)
@@ -512,6 +610,12 @@ void GlfwApp::drawFrameTimeWindow()
                   mFrameTimeHistoryArray.begin());
 
         ImGui::Text("Time between frames: %.1f ms (%.1f Hz)", deltaTimeMs, currentFreq);
+        ImGui::Text("Pacing (%s): %.3f ms per frame, jitter %.3f ms (max %.3f ms), spin %.2f ms", 
+                    PACING_ITEMS[(int)mPacingSource],
+                    mFramePacingStats.meanIntervalMs, 
+                    mFramePacingStats.jitterMs, 
+                    mFramePacingStats.maxErrorMs, 
+                    mFramePacingStats.spinMs);
         // ImGui::PlotLines("Frame timing", mFrameTimeHistoryArray.data(), (int)mFrameTimeHistoryArray.size(), 0, nullptr, 0, 30, {0.0f, 0.0f});
         if (ImPlot::BeginPlot("Frame timing", { -1, -1 }))
         {
@@ -532,19 +636,18 @@ void GlfwApp::drawSoundChannelsWindow()
     {
         // TODO: Plot the 5 sound channels
         // TODO: Add a button to plot mixed channels ?
-        soundBufferF32_t buffer;
+        soundBufferF32_t samples;
         s32 offset;
         if (ImPlot::BeginSubplots("##NoTitle", 6, 1, { -1, -1}))
         {
             if (ImPlot::BeginPlot("Sound output", { -1, -1 }))
             {
                 ImPlot::SetupAxis(ImAxis_X1, nullptr, ImPlotAxisFlags_Lock | ImPlotAxisFlags_NoTickLabels);
-                ImPlot::SetupAxesLimits(mTimeArray.front(), mTimeArray.back(), -0.1f, 1);
-                if (mSoundFIFOPtr != nullptr)
+                ImPlot::SetupAxesLimits(mTimeArray.front(), mTimeArray.back(), -1, 1);
+                if (mSoundTapsPtr != nullptr && mSoundTapsPtr->copySnapshot(SoundTap::OUTPUT, samples))
                 {
-                    std::copy(mSoundFIFOPtr->begin(), mSoundFIFOPtr->end(), buffer.begin());
-                    offset = getScopeTriggerOffset(buffer);
-                    ImPlot::PlotLine("Sound output", mTimeArray.data(), buffer.data() + offset, (int)mTimeArray.size());
+                    offset = getScopeTriggerOffset(samples.data(), SoundTaps::SNAPSHOT_SIZE);
+                    ImPlot::PlotLine("Sound output", mTimeArray.data(), samples.data() + offset, (int)mTimeArray.size());
                 }
                 ImPlot::EndPlot();
             }
@@ -553,11 +656,10 @@ void GlfwApp::drawSoundChannelsWindow()
             {
                 ImPlot::SetupAxis(ImAxis_X1, nullptr, ImPlotAxisFlags_Lock | ImPlotAxisFlags_NoTickLabels);
                 ImPlot::SetupAxesLimits(mTimeArray.front(), mTimeArray.back(), -0.1f, 1);
-                if (mP1FIFOPtr != nullptr)
+                if (mSoundTapsPtr != nullptr && mSoundTapsPtr->copySnapshot(SoundTap::PULSE1, samples))
                 {
-                    std::copy(mP1FIFOPtr->begin(), mP1FIFOPtr->end(), buffer.begin());
-                    offset = getScopeTriggerOffset(buffer);
-                    ImPlot::PlotLine("Pulse 1", mTimeArray.data(), buffer.data() + offset, (int)mTimeArray.size());
+                    offset = getScopeTriggerOffset(samples.data(), SoundTaps::SNAPSHOT_SIZE);
+                    ImPlot::PlotLine("Pulse 1", mTimeArray.data(), samples.data() + offset, (int)mTimeArray.size());
                 }
                 ImPlot::EndPlot();
             }
@@ -566,11 +668,10 @@ void GlfwApp::drawSoundChannelsWindow()
             {
                 ImPlot::SetupAxis(ImAxis_X1, nullptr, ImPlotAxisFlags_Lock | ImPlotAxisFlags_NoTickLabels);
                 ImPlot::SetupAxesLimits(mTimeArray.front(), mTimeArray.back(), -0.1f, 1);
-                if (mP2FIFOPtr != nullptr)
+                if (mSoundTapsPtr != nullptr && mSoundTapsPtr->copySnapshot(SoundTap::PULSE2, samples))
                 {
-                    std::copy(mP2FIFOPtr->begin(), mP2FIFOPtr->end(), buffer.begin());
-                    offset = getScopeTriggerOffset(buffer);
-                    ImPlot::PlotLine("Pulse 2", mTimeArray.data(), buffer.data() + offset, (int)mTimeArray.size());
+                    offset = getScopeTriggerOffset(samples.data(), SoundTaps::SNAPSHOT_SIZE);
+                    ImPlot::PlotLine("Pulse 2", mTimeArray.data(), samples.data() + offset, (int)mTimeArray.size());
                 }
                 ImPlot::EndPlot();
             }
@@ -579,11 +680,10 @@ void GlfwApp::drawSoundChannelsWindow()
             {
                 ImPlot::SetupAxis(ImAxis_X1, nullptr, ImPlotAxisFlags_Lock | ImPlotAxisFlags_NoTickLabels);
                 ImPlot::SetupAxesLimits(mTimeArray.front(), mTimeArray.back(), -0.1f, 1);
-                if (mTriangleFIFOPtr != nullptr)
+                if (mSoundTapsPtr != nullptr && mSoundTapsPtr->copySnapshot(SoundTap::TRIANGLE, samples))
                 {
-                    std::copy(mTriangleFIFOPtr->begin(), mTriangleFIFOPtr->end(), buffer.begin());
-                    offset = getScopeTriggerOffset(buffer);
-                    ImPlot::PlotLine("Triangle", mTimeArray.data(), buffer.data() + offset, (int)mTimeArray.size());
+                    offset = getScopeTriggerOffset(samples.data(), SoundTaps::SNAPSHOT_SIZE);
+                    ImPlot::PlotLine("Triangle", mTimeArray.data(), samples.data() + offset, (int)mTimeArray.size());
                 }
                 ImPlot::EndPlot();
             }
@@ -592,11 +692,10 @@ void GlfwApp::drawSoundChannelsWindow()
             {
                 ImPlot::SetupAxis(ImAxis_X1, nullptr, ImPlotAxisFlags_Lock | ImPlotAxisFlags_NoTickLabels);
                 ImPlot::SetupAxesLimits(mTimeArray.front(), mTimeArray.back(), -0.1f, 1);
-                if (mNoiseFIFOPtr != nullptr)
+                if (mSoundTapsPtr != nullptr && mSoundTapsPtr->copySnapshot(SoundTap::NOISE, samples))
                 {
-                    std::copy(mNoiseFIFOPtr->begin(), mNoiseFIFOPtr->end(), buffer.begin());
-                    offset = getScopeTriggerOffset(buffer);
-                    ImPlot::PlotLine("Noise", mTimeArray.data(), buffer.data() + offset, (int)mTimeArray.size());
+                    offset = getScopeTriggerOffset(samples.data(), SoundTaps::SNAPSHOT_SIZE);
+                    ImPlot::PlotLine("Noise", mTimeArray.data(), samples.data() + offset, (int)mTimeArray.size());
                 }
                 ImPlot::EndPlot();
             }
@@ -605,11 +704,10 @@ void GlfwApp::drawSoundChannelsWindow()
             {
                 ImPlot::SetupAxis(ImAxis_X1, nullptr, ImPlotAxisFlags_Lock);
                 ImPlot::SetupAxesLimits(mTimeArray.front(), mTimeArray.back(), -0.1f, 1);
-                if (mDmcFIFOPtr != nullptr)
+                if (mSoundTapsPtr != nullptr && mSoundTapsPtr->copySnapshot(SoundTap::DMC, samples))
                 {
-                    std::copy(mDmcFIFOPtr->begin(), mDmcFIFOPtr->end(), buffer.begin());
-                    offset = getScopeTriggerOffset(buffer);
-                    ImPlot::PlotLine("DMC", mTimeArray.data(), buffer.data() + offset, (int)mTimeArray.size());
+                    offset = getScopeTriggerOffset(samples.data(), SoundTaps::SNAPSHOT_SIZE);
+                    ImPlot::PlotLine("DMC", mTimeArray.data(), samples.data() + offset, (int)mTimeArray.size());
                 }
                 ImPlot::EndPlot();
             }
@@ -624,14 +722,12 @@ void GlfwApp::drawSpectrumWindow()
 {
     if (ImGui::Begin("Spectrum"))
     {
-        if (mSoundFIFOPtr != nullptr)
+        soundBufferF32_t samples;
+        if (mSoundTapsPtr != nullptr && mSoundTapsPtr->copySnapshot(SoundTap::OUTPUT, samples))
         {
             // Compute FFT
-            soundBufferF32_t signal;
-            std::copy(mSoundFIFOPtr->begin(), mSoundFIFOPtr->end(), signal.begin());
-            
             soundBufferF32_t spectrum;
-            fftMagnitude<BUFFER_SIZE>(signal, spectrum);
+            fftMagnitude<BUFFER_SIZE>(samples.data(), spectrum);
 
             ImGui::TextUnformatted("Scale: ");
             ImGui::SameLine();
@@ -672,6 +768,30 @@ void GlfwApp::drawAudioSettingsWindow()
             ImGui::EndTooltip();
         }
 
+        // Stream buffers (smaller & fewer: lower latency, more underruns)
+        ImGui::SeparatorText("Stream");
+        if (ImGui::BeginCombo("Buffer size", SOUND_BUFFER_SIZE_ITEMS[mSoundBufferSizeIdx]))
+        {
+            for (uint8_t i = 0; i < IM_ARRAYSIZE(SOUND_BUFFER_SIZE_ITEMS); i++)
+            {
+                bool isSelected = (mSoundBufferSizeIdx == i);
+                if (ImGui::Selectable(SOUND_BUFFER_SIZE_ITEMS[i], isSelected))
+                    mSoundBufferSizeIdx = i;
+
+                if (isSelected)
+                    ImGui::SetItemDefaultFocus();
+            }
+            
+            ImGui::EndCombo();
+        }
+        ImGui::SliderInt("Buffers", &mSoundBufferCount, SoundManager::MIN_STREAM_BUFFER_COUNT, SoundManager::MAX_STREAM_BUFFER_COUNT);
+
+        constexpr float MS_PER_SAMPLE = 1000.0f / BUFFER_SAMPLE_RATE;
+        ImGui::Text("Queue: %u samples (%.1f ms)", mSoundQueueDepth, mSoundQueueDepth * MS_PER_SAMPLE);
+        ImGui::Text("Latency: %.1f ms", mSoundLatency * MS_PER_SAMPLE);
+        ImGui::Text("Underruns: %u", mSoundUnderrunCount);
+        ImGui::Text("Rate control: %+.0f ppm", (mSoundSampleRateRatio - 1.0) * 1e6);
+
         if (ImGui::Button("Close"))
             mIsAudioSettingsWindowOpen = false;
     }
@@ -724,6 +844,48 @@ void GlfwApp::drawVideoSettingsWindow()
             ImGui::EndCombo();
         }
 
+        // Output format (indexed: palette & emphasis applied by the GPU)
+        if (ImGui::BeginCombo("Output", OUTPUT_ITEMS[(int)mPictureFormat]))
+        {
+            for (uint8_t i = 0; i < IM_ARRAYSIZE(OUTPUT_ITEMS); i++)
+            {
+                bool isSelected = ((int)mPictureFormat == i);
+                if (ImGui::Selectable(OUTPUT_ITEMS[i], isSelected))
+                    mPictureFormat = (PictureFormat)i;
+
+                if (isSelected)
+                    ImGui::SetItemDefaultFocus();
+            }
+            
+            ImGui::EndCombo();
+        }
+
+        // Frame pacing (VSync: the buffer swap waits for the display)
+        if (ImGui::BeginCombo("Frame pacing", PACING_ITEMS[(int)mPacingSource]))
+        {
+            for (uint8_t i = 0; i < IM_ARRAYSIZE(PACING_ITEMS); i++)
+            {
+                bool isSelected = ((int)mPacingSource == i);
+                if (ImGui::Selectable(PACING_ITEMS[i], isSelected))
+                {
+                    mPacingSource = (PacingSource)i;
+                    glfwSwapInterval(mPacingSource == PacingSource::VSYNC ? 1 : 0);
+                }
+
+                if (isSelected)
+                    ImGui::SetItemDefaultFocus();
+            }
+            
+            ImGui::EndCombo();
+        }
+
+        // Rendering threads (0: the picture is rendered by the emulation, one frame late otherwise)
+        int maxRenderingThreadCount = std::max((int)std::thread::hardware_concurrency() - 1, 1);
+        ImGui::SliderInt("Rendering threads", &mRenderingThreadCount, 0, maxRenderingThreadCount);
+
+        // Run-ahead: hides the lag frames of the game (the frames are emulated 1 + N times)
+        ImGui::SliderInt("Run-ahead frames", &mRunAheadFrameCount, 0, MAX_RUN_AHEAD_FRAMES);
+
         // Recompile
         if (mCurrentShaderStr == SHADER_ITEMS[1])
         {
@@ -865,6 +1027,20 @@ void GlfwApp::drawInputSettingsWindow()
             ImGui::EndTabBar();
         }
 
+        // Late polling: the inputs are polled until the game reads them (instead of once per drawn frame)
+        ImGui::Checkbox("Late input polling", &mIsLateInputPollingEnabled);
+        ImGui::Text("Input to strobe: %.2f ms (average: %.2f ms)", 
+                    mInputLatencyMs.load(std::memory_order_relaxed), 
+                    mInputLatencyAverageMs.load(std::memory_order_relaxed));
+
+        // Rewind: a compressed snapshot per frame, within the memory budget
+        ImGui::Checkbox("Rewind (hold Backspace)", &mIsRewindEnabled);
+        ImGui::SliderInt("Rewind memory (MB)", &mRewindMemoryBudgetMB, MIN_REWIND_MEMORY_BUDGET_MB, MAX_REWIND_MEMORY_BUDGET_MB);
+        ImGui::Text("Rewind: %.1f s, %.2f MB (compression: %.0fx)", 
+                    mRewindStats.durationS, 
+                    mRewindStats.storedBytes / (1024.0 * 1024.0), 
+                    mRewindStats.compressionRatio);
+
         if (ImGui::Button("Close"))
             mIsInputSettingsWindowOpen = false;
     }
@@ -1086,6 +1262,37 @@ void GlfwApp::updateControllersState()
 {
     mController1Ref.updateControllerState(mController1State);
     mController2Ref.updateControllerState(mController2State);
+
+    // Snapshot for the strobe callbacks (the inputs changed between the last poll & this one)
+    s64 pollTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    bool isChanged = (mController1State != mController1Snapshot.load(std::memory_order_relaxed)) ||
+                     (mController2State != mController2Snapshot.load(std::memory_order_relaxed));
+    if (isChanged)
+    {
+        mController1Snapshot.store(mController1State, std::memory_order_relaxed);
+        mController2Snapshot.store(mController2State, std::memory_order_relaxed);
+        mInputChangeTime.store((mLastInputPollTime + pollTime) / 2, std::memory_order_relaxed);
+        mInputChangeCount.fetch_add(1, std::memory_order_release);
+    }
+    mLastInputPollTime = pollTime;
+}
+
+u8 GlfwApp::getLatestControllerState(bool isPlayer1)
+{
+    // Input to strobe latency: first strobe after an input change
+    u32 inputChangeCount = mInputChangeCount.load(std::memory_order_acquire);
+    if (inputChangeCount != mStrobedInputChangeCount)
+    {
+        mStrobedInputChangeCount = inputChangeCount;
+
+        s64 strobeTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        float latencyMs = (strobeTime - mInputChangeTime.load(std::memory_order_relaxed)) * 1e-6f;
+        float latencyAverageMs = mInputLatencyAverageMs.load(std::memory_order_relaxed);
+        mInputLatencyMs.store(latencyMs, std::memory_order_relaxed);
+        mInputLatencyAverageMs.store(latencyAverageMs + INPUT_LATENCY_SMOOTHING * (latencyMs - latencyAverageMs), std::memory_order_relaxed);
+    }
+
+    return isPlayer1 ? mController1Snapshot.load(std::memory_order_relaxed) : mController2Snapshot.load(std::memory_order_relaxed);
 }
 
 void GlfwApp::openFile()
@@ -3,6 +3,8 @@
 #include <al.h>
 #include <alc.h>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 
 #ifdef _MSC_VER
 #define ASSERT(x) if (!(x)) __debugbreak()
@@ -35,6 +37,22 @@ static bool alCheckError(const char* function, const char* file, int line)
 	return isNotError;
 }
 
+SoundManager::SoundManager()
+	: mQueue(QUEUE_CAPACITY_LOG2)
+{
+	mBufferSize = 512;
+	mBufferCount = 3;
+	mSource = 0;
+	mIsInitialised = false;
+	mIsStreaming = false;
+	mUnderrunCount = 0;
+
+	mIsRateControlEnabled = true;
+	mSampleRateRatio = 1.0;
+	mRateDeviationIntegral = 0.0;
+	mQueueDepthAverage = 0.0;
+}
+
 int SoundManager::initialise()
 {
 	// Reset
@@ -55,10 +73,6 @@ int SoundManager::initialise()
 	// Clear error
 	alClearError();
 
-	// Create sound buffers
-	alGenBuffers(NUM_BUFFERS, mBuffers.data());
-	alCheckError(__FUNCTION__, __FILE__, __LINE__);
-
 	// Create sound source
 	alGenSources(1, &mSource);
 	alCheckError(__FUNCTION__, __FILE__, __LINE__);
@@ -66,17 +80,21 @@ int SoundManager::initialise()
 	AL_CALL(alSourcef(mSource, AL_PITCH, 1.0f));
 	AL_CALL(alSourcef(mSource, AL_GAIN, 1.0f));
 
+	mIsInitialised = true;
+	startStream();
+
 	return EXIT_SUCCESS;
 }
 
 SoundManager::~SoundManager()
 {
-	// Unbind buffers
-	AL_CALL(alSourcei(mSource, AL_BUFFER, 0));
+	if (!mIsInitialised)
+		return;
 
-	// Delete source & buffers
+	stopStream();
+
+	// Delete source
 	AL_CALL(alDeleteSources(1, &mSource));
-	AL_CALL(alDeleteBuffers(NUM_BUFFERS, mBuffers.data()));
 
 	// I think it is not OK not to check for nullptrs
 	// I guess I'll find out if it's an issue while testing the code -\_('U')_/-
@@ -87,56 +105,117 @@ SoundManager::~SoundManager()
 	alcCloseDevice(devicePtr);
 }
 
-StreamStatus SoundManager::streamSound(const soundBufferF32_t& soundBuffer)
+u32 SoundManager::pushSamples(const float* samples, u32 sampleCount)
+{
+	u32 pushedSampleCount = mQueue.push(samples, sampleCount);
+	updateSampleRateRatio();
+
+	return pushedSampleCount;
+}
+
+void SoundManager::updateSampleRateRatio()
+{
+	// Queue too deep -> fewer samples per emulated second (& more if not deep enough),
+	// the integral cancels the steady clock drift
+	double targetDepth = getTargetQueueDepth();
+	mQueueDepthAverage += QUEUE_DEPTH_SMOOTHING * (mQueue.getDepth() - mQueueDepthAverage);
+	double depthError = std::clamp((targetDepth - mQueueDepthAverage) / targetDepth, -1.0, 1.0);
+	mRateDeviationIntegral = std::clamp(mRateDeviationIntegral + RATE_INTEGRAL_GAIN * depthError, -MAX_RATE_DEVIATION, MAX_RATE_DEVIATION);
+	double rateDeviation = MAX_RATE_DEVIATION * depthError + mRateDeviationIntegral;
+	mSampleRateRatio = 1.0 + std::clamp(rateDeviation, -MAX_RATE_DEVIATION, MAX_RATE_DEVIATION);
+}
+
+void SoundManager::setStreamBuffers(u32 bufferSize, u32 bufferCount)
 {
-	ALint numProcessed, numQueued;
-	StreamStatus streamStatus;
+	bufferSize = std::clamp(bufferSize, MIN_STREAM_BUFFER_SIZE, MAX_STREAM_BUFFER_SIZE);
+	bufferCount = std::clamp(bufferCount, MIN_STREAM_BUFFER_COUNT, MAX_STREAM_BUFFER_COUNT);
+	if (bufferSize == mBufferSize && bufferCount == mBufferCount)
+		return;
 
-	// Get number of QUEUED, PROCESSED & TOTAL buffer
-	AL_CALL(alGetSourcei(mSource, AL_BUFFERS_QUEUED, &numQueued));
-	AL_CALL(alGetSourcei(mSource, AL_BUFFERS_PROCESSED, &numProcessed));
+	if (mIsInitialised)
+		stopStream();
 
-	if (numQueued < NUM_BUFFERS)
-	{
-		// Start of the stream
-		// Transform data
-		soundBuffer_t byteBuffer;
-		convertBuffer(soundBuffer, byteBuffer);
-		
-		// Fill the source with buffers
-		AL_CALL(alBufferData(mBuffers[numQueued], BUFFER_FORMAT, byteBuffer.data(), BUFFER_SIZE, BUFFER_SAMPLE_RATE));
-		AL_CALL(alSourceQueueBuffers(mSource, 1, &mBuffers[numQueued]));
-
-		streamStatus = StreamStatus::QUEUED;
-	}
-	else if (numProcessed <= 0)
-	{
-		// Not finished playing buffers
-		streamStatus = StreamStatus::NOT_QUEUED;
-	}
-	else
+	mBufferSize = bufferSize;
+	mBufferCount = bufferCount;
+
+	if (mIsInitialised)
+		startStream();
+}
+
+void SoundManager::startStream()
+{
+	// Create sound buffers
+	mBuffers.resize(mBufferCount);
+	alGenBuffers(mBufferCount, mBuffers.data());
+	alCheckError(__FUNCTION__, __FILE__, __LINE__);
+	mStreamSamples.resize(mBufferSize);
+	mStreamBytes.resize(mBufferSize);
+
+	mIsStreaming = true;
+	mStreamThread = std::thread(&SoundManager::runStream, this);
+}
+
+void SoundManager::stopStream()
+{
+	mIsStreaming = false;
+	mStreamThread.join();
+
+	// Unbind & delete buffers
+	AL_CALL(alSourceStop(mSource));
+	AL_CALL(alSourcei(mSource, AL_BUFFER, 0));
+	AL_CALL(alDeleteBuffers(mBufferCount, mBuffers.data()));
+}
+
+void SoundManager::runStream()
+{
+	// Free buffers are checked 4 times per buffer
+	const auto pollPeriod = std::chrono::microseconds(250'000 * mBufferSize / BUFFER_SAMPLE_RATE);
+
+	std::vector<ALuint> freeBuffers = mBuffers;
+	bool isPlaying = false;
+	while (mIsStreaming.load(std::memory_order_relaxed))
 	{
-		// Finished playing some buffers
-		// Transform data
-		soundBuffer_t byteBuffer;
-		convertBuffer(soundBuffer, byteBuffer);
-
-		// Unqueue a buffer, modify it's data and requeue it
-		ALuint buffer;
-		AL_CALL(alSourceUnqueueBuffers(mSource, 1, &buffer));
-		AL_CALL(alBufferData(buffer, BUFFER_FORMAT, byteBuffer.data(), BUFFER_SIZE, BUFFER_SAMPLE_RATE));
-		AL_CALL(alSourceQueueBuffers(mSource, 1, &buffer));
-
-		streamStatus = StreamStatus::QUEUED;
+		// Played buffers are free again
+		ALint numProcessed;
+		AL_CALL(alGetSourcei(mSource, AL_BUFFERS_PROCESSED, &numProcessed));
+		for (ALint i = 0; i < numProcessed; i++)
+		{
+			ALuint buffer;
+			AL_CALL(alSourceUnqueueBuffers(mSource, 1, &buffer));
+			freeBuffers.push_back(buffer);
+		}
+
+		// Refill them with complete buffers of samples
+		while (!freeBuffers.empty() && mQueue.getDepth() >= mBufferSize)
+		{
+			fillBuffer(freeBuffers.back());
+			AL_CALL(alSourceQueueBuffers(mSource, 1, &freeBuffers.back()));
+			freeBuffers.pop_back();
+		}
+
+		// A source stops when it has played all its buffers: underrun,
+		// playing starts again once every buffer is queued
+		ALint sourceState;
+		AL_CALL(alGetSourcei(mSource, AL_SOURCE_STATE, &sourceState));
+		if (sourceState != AL_PLAYING)
+		{
+			if (isPlaying)
+				mUnderrunCount.fetch_add(1, std::memory_order_relaxed);
+
+			isPlaying = freeBuffers.empty();
+			if (isPlaying)
+				AL_CALL(alSourcePlay(mSource));
+		}
+
+		std::this_thread::sleep_for(pollPeriod);
 	}
+}
 
-	// Play source
-	ALint sourceState;
-	AL_CALL(alGetSourcei(mSource, AL_SOURCE_STATE, &sourceState));
-	if (sourceState != AL_PLAYING)
-		AL_CALL(alSourcePlay(mSource));
-	
-	return streamStatus;
+void SoundManager::fillBuffer(ALuint buffer)
+{
+	mQueue.pop(mStreamSamples.data(), mBufferSize);
+	convertBuffer(mStreamSamples.data(), mStreamBytes.data(), mBufferSize);
+	AL_CALL(alBufferData(buffer, BUFFER_FORMAT, mStreamBytes.data(), mBufferSize, BUFFER_SAMPLE_RATE));
 }
 
 void SoundManager::checkError()
@@ -149,8 +228,8 @@ void SoundManager::checkError()
 	}
 }
 
-void SoundManager::convertBuffer(const soundBufferF32_t &buffer, soundBuffer_t& byteBuffer)
+void SoundManager::convertBuffer(const float* buffer, u8* byteBuffer, u32 sampleCount)
 {
-	for (u32 i = 0; i < BUFFER_SIZE; i++)
+	for (u32 i = 0; i < sampleCount; i++)
 		byteBuffer[i] = (u8)(0.5f * 255.0f * (buffer[i] + 1));
-}
\ No newline at end of file
+}
@@ -0,0 +1,43 @@
+#include "IO/SoundQueue.hpp"
+
+#include <algorithm>
+
+SoundQueue::SoundQueue(u32 capacityLog2)
+{
+	mCapacity = 1 << capacityLog2;
+	mIdxMask = mCapacity - 1;
+	mSamples = std::make_unique<float[]>(mCapacity);
+	mWriteIdx.store(0, std::memory_order_relaxed);
+	mReadIdx.store(0, std::memory_order_relaxed);
+}
+
+u32 SoundQueue::push(const float* samples, u32 sampleCount)
+{
+	u32 writeIdx = mWriteIdx.load(std::memory_order_relaxed);
+	u32 readIdx = mReadIdx.load(std::memory_order_acquire);
+	sampleCount = std::min(sampleCount, mCapacity - (writeIdx - readIdx));
+
+	// Two copies when the samples wrap around the end of the queue
+	u32 startIdx = writeIdx & mIdxMask;
+	u32 firstChunkSize = std::min(sampleCount, mCapacity - startIdx);
+	std::copy(samples, samples + firstChunkSize, &mSamples[startIdx]);
+	std::copy(samples + firstChunkSize, samples + sampleCount, &mSamples[0]);
+
+	mWriteIdx.store(writeIdx + sampleCount, std::memory_order_release);
+	return sampleCount;
+}
+
+u32 SoundQueue::pop(float* samples, u32 sampleCount)
+{
+	u32 readIdx = mReadIdx.load(std::memory_order_relaxed);
+	u32 writeIdx = mWriteIdx.load(std::memory_order_acquire);
+	sampleCount = std::min(sampleCount, writeIdx - readIdx);
+
+	u32 startIdx = readIdx & mIdxMask;
+	u32 firstChunkSize = std::min(sampleCount, mCapacity - startIdx);
+	std::copy(&mSamples[startIdx], &mSamples[startIdx] + firstChunkSize, samples);
+	std::copy(&mSamples[0], &mSamples[0] + (sampleCount - firstChunkSize), samples + firstChunkSize);
+
+	mReadIdx.store(readIdx + sampleCount, std::memory_order_release);
+	return sampleCount;
+}
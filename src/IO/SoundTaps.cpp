@@ -0,0 +1,77 @@
+#include "IO/SoundTaps.hpp"
+
+SoundTaps::SoundTaps()
+{
+	mSamples = std::make_unique<std::atomic<float>[]>(TAP_COUNT * RING_SIZE);
+	for (u32 tap = 0; tap < TAP_COUNT; tap++)
+	{
+		mIsSubscribed[tap].store(false, std::memory_order_relaxed);
+		mReservedCount[tap].store(0, std::memory_order_relaxed);
+		mWrittenCount[tap].store(0, std::memory_order_relaxed);
+	}
+
+	clear();
+}
+
+void SoundTaps::clear()
+{
+	// Seen by the consumer as CAPACITY pushed silent samples
+	for (u32 tap = 0; tap < TAP_COUNT; tap++)
+	{
+		u32 writtenCount = mWrittenCount[tap].load(std::memory_order_relaxed);
+		mReservedCount[tap].store(writtenCount + CAPACITY, std::memory_order_relaxed);
+
+		std::atomic<float>* ring = getRing((SoundTap)tap);
+		for (u32 i = 0; i < RING_SIZE; i++)
+			ring[i].store(0.0f, std::memory_order_release);
+
+		mWrittenCount[tap].store(writtenCount + CAPACITY, std::memory_order_release);
+	}
+}
+
+void SoundTaps::setSubscribed(SoundTap tap, bool isSubscribed)
+{
+	mIsSubscribed[(u8)tap].store(isSubscribed, std::memory_order_relaxed);
+}
+
+bool SoundTaps::copySnapshot(SoundTap tap, soundBufferF32_t& snapshot) const
+{
+	const std::atomic<float>* ring = getRing(tap);
+	for (u32 attempt = 0; attempt < SNAPSHOT_ATTEMPTS; attempt++)
+	{
+		u32 writtenCount = mWrittenCount[(u8)tap].load(std::memory_order_acquire);
+		const std::atomic<float>* firstSample = ring + writtenCount % CAPACITY + CAPACITY - SNAPSHOT_SIZE;
+		for (u32 i = 0; i < SNAPSHOT_SIZE; i++)
+			snapshot[i] = firstSample[i].load(std::memory_order_acquire);
+
+		// The oldest copied sample is overwritten by the (CAPACITY - SNAPSHOT_SIZE + 1)th next one
+		u32 reservedCount = mReservedCount[(u8)tap].load(std::memory_order_relaxed);
+		if (reservedCount - writtenCount <= CAPACITY - SNAPSHOT_SIZE)
+			return true;
+	}
+
+	return false;
+}
+
+void SoundTaps::push(SoundTap tap, const float* samples, u32 sampleCount)
+{
+	// Only the last CAPACITY samples are kept
+	if (sampleCount > CAPACITY)
+	{
+		samples += sampleCount - CAPACITY;
+		sampleCount = CAPACITY;
+	}
+
+	std::atomic<float>* ring = getRing(tap);
+	u32 writtenCount = mWrittenCount[(u8)tap].load(std::memory_order_relaxed);
+	mReservedCount[(u8)tap].store(writtenCount + sampleCount, std::memory_order_relaxed);
+
+	u32 writeIdx = writtenCount % CAPACITY;
+	for (u32 i = 0; i < sampleCount; i++)
+	{
+		ring[writeIdx].store(samples[i], std::memory_order_release);
+		ring[writeIdx + CAPACITY].store(samples[i], std::memory_order_release);
+		writeIdx = (writeIdx + 1) % CAPACITY;
+	}
+	mWrittenCount[(u8)tap].store(writtenCount + sampleCount, std::memory_order_release);
+}
@@ -1,5 +1,6 @@
 #include "NES/APU.hpp"
 
+#include <algorithm>
 #include <sstream>
 #include "NES/Toolbox.hpp"
 
@@ -67,6 +68,51 @@ s32 APU::executeOneCpuCycle(Memory& memory, bool isGetCycle)
 	return extraCycles;
 }
 
+s32 APU::getIdleCpuCycles() const
+{
+	s32 cpuCycles = mFrameCounter.getCpuCyclesToNextStep();
+
+	// DMC is clocked on odd cycles
+	s32 dmcCycles = mDmcChannel.getCyclesToMemoryRead();
+	if (dmcCycles < (INT32_MAX / 2))
+		cpuCycles = std::min(cpuCycles, 2 * dmcCycles + (mFrameCounter.isNextCycleEven() ? 1 : 0));
+
+	return cpuCycles;
+}
+
+void APU::executeIdleCpuCycles(s32 cpuCycles)
+{
+	// Triangle is clocked on every cycle, the other channels on odd cycles
+	u32 apuCycles = mFrameCounter.executeIdleCpuCycles(cpuCycles);
+
+	mTriangleChannel.executeIdleCycles(cpuCycles);
+	mPulse1Channel.executeIdleCycles(apuCycles);
+	mPulse2Channel.executeIdleCycles(apuCycles);
+	mNoiseChannel.executeIdleCycles(apuCycles);
+	mDmcChannel.executeIdleCycles(apuCycles);
+}
+
+s32 APU::getCpuCyclesToOutputChange() const
+{
+	// Triangle is clocked on every cycle
+	s32 cpuCycles = mTriangleChannel.getCyclesToOutputChange();
+
+	// The other channels on odd cycles
+	s32 apuCycles = std::min({ mPulse1Channel.getCyclesToOutputChange(),
+	                           mPulse2Channel.getCyclesToOutputChange(),
+	                           mNoiseChannel.getCyclesToOutputChange(),
+	                           mDmcChannel.getCyclesToOutputChange() });
+	if (apuCycles < (INT32_MAX / 2))
+		cpuCycles = std::min(cpuCycles, 2 * apuCycles - (mFrameCounter.isNextCycleEven() ? 0 : 1));
+
+	return cpuCycles;
+}
+
+s32 APU::getCpuCyclesToIrq() const
+{
+	return std::min(mFrameCounter.getCpuCyclesToIrq(), mDmcChannel.getCpuCyclesToIrq());
+}
+
 float APU::getOutput()
 {
 	u8 pulse1 = mPulse1Channel.getOutput();
@@ -0,0 +1,157 @@
+#include "NES/APUBlipBuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+APUBlipBuffer::APUBlipBuffer(u32 clockRate, u32 sampleRate, u32 sampleCapacity)
+{
+	mClockRate = clockRate;
+	mSampleRate = sampleRate;
+	mSamplesPerClock = (((u64)sampleRate << TIME_BITS) + clockRate / 2) / clockRate;
+	mNextSamplesPerClock = mSamplesPerClock;
+	mDeltas.resize(sampleCapacity + KERNEL_WIDTH);
+
+	// First order filters: y[n] = a.(y[n-1] + x[n] - x[n-1]) (HP), y[n] = y[n-1] + a.(x[n] - y[n-1]) (LP)
+	constexpr float PI = 3.14159265f;
+	float samplePeriod = 1.0f / sampleRate;
+	float highPass1Rc = 1.0f / (2 * PI * HIGH_PASS_1_FREQUENCY);
+	float highPass2Rc = 1.0f / (2 * PI * HIGH_PASS_2_FREQUENCY);
+	float lowPassRc = 1.0f / (2 * PI * LOW_PASS_FREQUENCY);
+	mHighPass1Coef = highPass1Rc / (highPass1Rc + samplePeriod);
+	mHighPass2Coef = highPass2Rc / (highPass2Rc + samplePeriod);
+	mLowPassCoef = samplePeriod / (lowPassRc + samplePeriod);
+
+	computeKernel();
+	clear();
+}
+
+void APUBlipBuffer::clear()
+{
+	mOffset = 0;
+	mSamplesAvailable = 0;
+	std::fill(mDeltas.begin(), mDeltas.end(), 0.0f);
+
+	mIntegrator = 0.0f;
+	mHighPass1PreviousInput = 0.0f;
+	mHighPass1PreviousOutput = 0.0f;
+	mHighPass2PreviousInput = 0.0f;
+	mHighPass2PreviousOutput = 0.0f;
+	mLowPassPreviousOutput = 0.0f;
+}
+
+void APUBlipBuffer::saveState(blipBufferState_t& state) const
+{
+	state.samplesPerClock = mSamplesPerClock;
+	state.nextSamplesPerClock = mNextSamplesPerClock;
+	state.offset = mOffset;
+	state.samplesAvailable = mSamplesAvailable;
+	state.deltas = mDeltas;
+	state.integrator = mIntegrator;
+	state.highPass1PreviousInput = mHighPass1PreviousInput;
+	state.highPass1PreviousOutput = mHighPass1PreviousOutput;
+	state.highPass2PreviousInput = mHighPass2PreviousInput;
+	state.highPass2PreviousOutput = mHighPass2PreviousOutput;
+	state.lowPassPreviousOutput = mLowPassPreviousOutput;
+}
+
+void APUBlipBuffer::loadState(const blipBufferState_t& state)
+{
+	mSamplesPerClock = state.samplesPerClock;
+	mNextSamplesPerClock = state.nextSamplesPerClock;
+	mOffset = state.offset;
+	mSamplesAvailable = state.samplesAvailable;
+	mDeltas = state.deltas;
+	mIntegrator = state.integrator;
+	mHighPass1PreviousInput = state.highPass1PreviousInput;
+	mHighPass1PreviousOutput = state.highPass1PreviousOutput;
+	mHighPass2PreviousInput = state.highPass2PreviousInput;
+	mHighPass2PreviousOutput = state.highPass2PreviousOutput;
+	mLowPassPreviousOutput = state.lowPassPreviousOutput;
+}
+
+void APUBlipBuffer::setSampleRateRatio(double ratio)
+{
+	// Samples positions of a frame are computed with the same ratio
+	mNextSamplesPerClock = (u64)std::llround(std::ldexp(mSampleRate * ratio, TIME_BITS) / mClockRate);
+}
+
+void APUBlipBuffer::addDelta(u32 clockTime, float delta)
+{
+	u64 time = mOffset + clockTime * mSamplesPerClock;
+	u64 sampleIdx = time >> TIME_BITS;
+	u32 phase = (u32)(time >> (TIME_BITS - PHASE_BITS)) & (PHASE_COUNT - 1);
+
+	// Frame too long for the buffer
+	if (sampleIdx + KERNEL_WIDTH > mDeltas.size())
+		return;
+
+	const std::array<float, KERNEL_WIDTH>& kernel = mKernel[phase];
+	float* deltas = &mDeltas[sampleIdx];
+	for (u32 i = 0; i < KERNEL_WIDTH; i++)
+		deltas[i] += delta * kernel[i];
+}
+
+void APUBlipBuffer::endFrame(u32 clockDuration)
+{
+	mOffset += clockDuration * mSamplesPerClock;
+	mSamplesPerClock = mNextSamplesPerClock;
+	mSamplesAvailable = std::min((u32)(mOffset >> TIME_BITS), (u32)(mDeltas.size() - KERNEL_WIDTH));
+}
+
+u32 APUBlipBuffer::readSamples(float* samples, u32 maxSampleCount)
+{
+	u32 sampleCount = std::min(maxSampleCount, mSamplesAvailable);
+	for (u32 i = 0; i < sampleCount; i++)
+	{
+		// Steps
+		mIntegrator += mDeltas[i];
+		float sample = mIntegrator;
+
+		// High-pass (90 Hz)
+		float highPass1Output = mHighPass1Coef * (mHighPass1PreviousOutput + sample - mHighPass1PreviousInput);
+		mHighPass1PreviousInput = sample;
+		mHighPass1PreviousOutput = highPass1Output;
+
+		// High-pass (440 Hz)
+		float highPass2Output = mHighPass2Coef * (mHighPass2PreviousOutput + highPass1Output - mHighPass2PreviousInput);
+		mHighPass2PreviousInput = highPass1Output;
+		mHighPass2PreviousOutput = highPass2Output;
+
+		// Low-pass (14 kHz)
+		mLowPassPreviousOutput += mLowPassCoef * (highPass2Output - mLowPassPreviousOutput);
+		samples[i] = mLowPassPreviousOutput;
+	}
+
+	// Remove the samples read (the impulses of the next samples are kept)
+	std::copy(mDeltas.begin() + sampleCount, mDeltas.begin() + mSamplesAvailable + KERNEL_WIDTH, mDeltas.begin());
+	std::fill(mDeltas.begin() + mSamplesAvailable + KERNEL_WIDTH - sampleCount, mDeltas.begin() + mSamplesAvailable + KERNEL_WIDTH, 0.0f);
+	mSamplesAvailable -= sampleCount;
+	mOffset -= (u64)sampleCount << TIME_BITS;
+
+	return sampleCount;
+}
+
+void APUBlipBuffer::computeKernel()
+{
+	// Windowed sinc (Blackman), cut a bit below Nyquist frequency, centered on the step
+	constexpr double PI = 3.14159265358979323846;
+	constexpr double CUTOFF = 0.45; // Relative to the sample rate
+	for (u32 phase = 0; phase < PHASE_COUNT; phase++)
+	{
+		double stepPosition = (KERNEL_HALF_WIDTH - 1) + (double)phase / PHASE_COUNT;
+		double sum = 0.0;
+		std::array<double, KERNEL_WIDTH> impulse;
+		for (u32 i = 0; i < KERNEL_WIDTH; i++)
+		{
+			double x = i - stepPosition;
+			double sinc = (x == 0.0) ? 2 * CUTOFF : std::sin(2 * PI * CUTOFF * x) / (PI * x);
+			double window = 0.42 + 0.5 * std::cos(PI * x / KERNEL_HALF_WIDTH) + 0.08 * std::cos(2 * PI * x / KERNEL_HALF_WIDTH);
+			impulse[i] = sinc * window;
+			sum += impulse[i];
+		}
+
+		// A step of 1 gives an output of 1
+		for (u32 i = 0; i < KERNEL_WIDTH; i++)
+			mKernel[phase][i] = (float)(impulse[i] / sum);
+	}
+}
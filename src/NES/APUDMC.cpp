@@ -19,6 +19,7 @@ void APUDMC::reset()
 	mShiftRegister = 0;
 	mShifterBitsRemaining = 0;
 	mOutput = 0;
+	mIsSilenced = true;
 }
 
 s32 APUDMC::update(Memory& memory, bool isGetCycle)
@@ -51,46 +52,70 @@ s32 APUDMC::update(Memory& memory, bool isGetCycle)
 		}
 	}
 	
-	// Timer
+	// Timer -> Output unit
 	bool isTimerClocking = mTimer.countDown();
-	
-	// Output unit
 	if (isTimerClocking)
-	{
-		// In/Decrement output by 2
-		// only when limits are not crossed [0, 127]
-		if (!mIsSilenced)
-		{
-			s8 increment = ((mShiftRegister & 1) != 0) ? 2 : -2;
-			s16 tempOutput = (s16)mOutput + increment;
-			if (0 <= tempOutput  && tempOutput <= 127)
-				mOutput = (u8)tempOutput;
-		}
+		clockOutputUnit();
 
-		// Shift right
-		mShiftRegister >>= 1;
+	return extraCycles;
+}
 
-		// Decrement bit count
-		mShifterBitsRemaining--;
-		if (mShifterBitsRemaining == 0)
-		{
-			// Restart cycle
-			mShifterBitsRemaining = 8;
-
-			if (!mIsBufferFull)
-			{
-				mIsSilenced = true;
-			}
-			else
-			{
-				mIsSilenced = false;
-				mShiftRegister = mSampleBuffer;
-				mIsBufferFull = false;
-			}
-		}
-	}
+void APUDMC::executeIdleCycles(u32 cycles)
+{
+	// Same as calling update() "cycles" times, when the memory reader does nothing (see getCyclesToMemoryRead())
+	u32 outputUnitClocks = mTimer.countDown(cycles);
+	for (u32 i = 0; i < outputUnitClocks; i++)
+		clockOutputUnit();
+}
 
-	return extraCycles;
+s32 APUDMC::getCyclesToOutputChange() const
+{
+	// Silenced until a sample byte is read
+	if (mIsSilenced && !mIsBufferFull)
+		return INT32_MAX;
+
+	// Next output unit clock
+	return mTimer.getCounter() + 1;
+}
+
+s32 APUDMC::getCyclesToMemoryRead() const
+{
+	// Nothing to read (a register write is needed to restart)
+	if (mMemReaderCount == 0)
+		return INT32_MAX;
+
+	// Buffer empty -> read right away
+	if (!mIsBufferFull)
+		return 0;
+
+	// The buffer is emptied by the output unit when its bit count reaches 0,
+	// then it is filled on the next cycle
+	s32 bitsRemaining = (mShifterBitsRemaining == 0) ? 256 : mShifterBitsRemaining;
+	return (mTimer.getCounter() + 1) + (bitsRemaining - 1) * (mTimer.getPeriod() + 1);
+}
+
+s32 APUDMC::getCpuCyclesToIrq() const
+{
+	// No IRQ can be raised
+	if (!mIsIRQSet || mIsLooping || mMemReaderCount == 0 || mIsIRQSignalSet)
+		return INT32_MAX;
+
+	if (mMemReaderCount < 2)
+		return 0;
+
+	// One byte may be fetched right away, then at most one every 8 timer clocks
+	// (the timer is clocked every other CPU cycle)
+	return (mMemReaderCount - 2) * getCpuCyclesPerSampleByte();
+}
+
+s32 APUDMC::getMaxDmaExtraCycles(s32 cpuCycles) const
+{
+	if (mMemReaderCount == 0)
+		return 0;
+
+	// Each fetch stalls the CPU for 4 cycles at most
+	s32 fetchCount = 2 + cpuCycles / getCpuCyclesPerSampleByte();
+	return 4 * fetchCount;
 }
 
 void APUDMC::setReg0(u8 value)
@@ -158,6 +183,41 @@ u8 APUDMC::dmaRead(Memory &memory, bool isGetCycle, s32& extraCycles)
 	return sample;
 }
 
+void APUDMC::clockOutputUnit()
+{
+	// In/Decrement output by 2
+	// only when limits are not crossed [0, 127]
+	if (!mIsSilenced)
+	{
+		s8 increment = ((mShiftRegister & 1) != 0) ? 2 : -2;
+		s16 tempOutput = (s16)mOutput + increment;
+		if (0 <= tempOutput  && tempOutput <= 127)
+			mOutput = (u8)tempOutput;
+	}
+
+	// Shift right
+	mShiftRegister >>= 1;
+
+	// Decrement bit count
+	mShifterBitsRemaining--;
+	if (mShifterBitsRemaining == 0)
+	{
+		// Restart cycle
+		mShifterBitsRemaining = 8;
+
+		if (!mIsBufferFull)
+		{
+			mIsSilenced = true;
+		}
+		else
+		{
+			mIsSilenced = false;
+			mShiftRegister = mSampleBuffer;
+			mIsBufferFull = false;
+		}
+	}
+}
+
 inline void APUDMC::incrementReaderAddress()
 {
 	if (mMemReaderAddress != 0xFFFF)
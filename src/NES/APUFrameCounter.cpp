@@ -79,6 +79,60 @@ APUFrameCounterState APUFrameCounter::executeOneCpuCycle()
 	return fcState;
 }
 
+u32 APUFrameCounter::executeIdleCpuCycles(u32 cpuCycles)
+{
+	// Same as executeOneCpuCycle() on cycles without step (see getCpuCyclesToNextStep())
+	// Returns the number of odd cycles (APU cycles)
+	if (cpuCycles == 0)
+		return 0;
+
+	u32 evenCycleCount = mApuClockDivider.countDown(cpuCycles);
+	mCycleCount += (s16)evenCycleCount;
+	mIsEvenCycle = mApuClockDivider.getCounter() != 0;
+
+	return cpuCycles - evenCycleCount;
+}
+
+s32 APUFrameCounter::getCpuCyclesToNextStep() const
+{
+	// Register write or sequence end pending
+	if (mIsRegBit7Set || mIsEndReached)
+		return 0;
+
+	// First cycle count checked by an odd cycle
+	s16 checkedCycleCount = isNextCycleEven() ? mCycleCount + 1 : mCycleCount;
+
+	s16 stepCycleCount;
+	if (checkedCycleCount <= FC_STEP1_CYCLE_COUNT)
+		stepCycleCount = FC_STEP1_CYCLE_COUNT;
+	else if (checkedCycleCount <= FC_STEP2_CYCLE_COUNT)
+		stepCycleCount = FC_STEP2_CYCLE_COUNT;
+	else if (checkedCycleCount <= FC_STEP3_CYCLE_COUNT)
+		stepCycleCount = FC_STEP3_CYCLE_COUNT;
+	else if (checkedCycleCount <= FC_STEP4_CYCLE_COUNT && !mIs5StepsMode)
+		stepCycleCount = FC_STEP4_CYCLE_COUNT;
+	else if (checkedCycleCount <= FC_STEP5_CYCLE_COUNT)
+		stepCycleCount = FC_STEP5_CYCLE_COUNT;
+	else
+		return INT32_MAX;
+
+	// The sequence progresses every 2 CPU cycles, steps are made on odd cycles
+	return 2 * (stepCycleCount - checkedCycleCount) + (isNextCycleEven() ? 1 : 0);
+}
+
+s32 APUFrameCounter::getCpuCyclesToIrq() const
+{
+	// No IRQ can be raised
+	if (mIs5StepsMode || mIsInterruptInhibited || mIsIRQSignalSet)
+		return INT32_MAX;
+
+	if (mCycleCount >= FC_STEP4_CYCLE_COUNT)
+		return 0;
+
+	// The sequence progresses every 2 CPU cycles, IRQ is raised on the odd cycle of step 4
+	return 2 * (FC_STEP4_CYCLE_COUNT - mCycleCount) - 1;
+}
+
 void APUFrameCounter::writeRegister(u8 reg)
 {
 	mIs5StepsMode = (reg & 0b1000'0000) != 0;
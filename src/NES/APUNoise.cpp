@@ -21,22 +21,53 @@ void APUNoise::update(APUFrameCounterState fcState)
 	// Timer -> Shift register
 	bool isTimerClocking = mTimer.countDown();
 	if (isTimerClocking)
-	{
-		// Shift & feedback
-		u8 feedbackBit = mIsModeFlagSet ? 6 : 1;
-		u16 msb = (mShiftRegister & 1) ^ 
-		          ((mShiftRegister & (1 << feedbackBit)) >> feedbackBit);
-		mShiftRegister |= msb << 15; // Feedback
-		mShiftRegister >>= 1;        // Shift
-	}
+		shiftRegister();
 
 	// Length counter
 	if (fcState == APUFrameCounterState::HALF)
 		mLengthCounter.update();
-	u8 lengthCount = mLengthCounter.getCounter();
 	
+	updateOutput();
+}
+
+void APUNoise::executeIdleCycles(u32 cycles)
+{
+	// Same as calling update() without frame counter step "cycles" times
+	u32 shiftCount = mTimer.countDown(cycles);
+	for (u32 i = 0; i < shiftCount; i++)
+		shiftRegister();
+
+	updateOutput();
+}
+
+s32 APUNoise::getCyclesToOutputChange() const
+{
+	// Envelope or length counter changed by a register write
+	u8 output = (((mShiftRegister & 1) != 0) || isSilenced()) ? 0 : mEnvelope.getOutput();
+	if (output != mOutput)
+		return 1;
+
+	if (isSilenced())
+		return INT32_MAX;
+
+	// Next shift
+	return mTimer.getCounter() + 1;
+}
+
+void APUNoise::shiftRegister()
+{
+	// Shift & feedback
+	u8 feedbackBit = mIsModeFlagSet ? 6 : 1;
+	u16 msb = (mShiftRegister & 1) ^ 
+	          ((mShiftRegister & (1 << feedbackBit)) >> feedbackBit);
+	mShiftRegister |= msb << 15; // Feedback
+	mShiftRegister >>= 1;        // Shift
+}
+
+void APUNoise::updateOutput()
+{
 	// Gates (shift reg  & length counter)
-	if (((mShiftRegister & 1) != 0) || (lengthCount == 0))
+	if (((mShiftRegister & 1) != 0) || (mLengthCounter.getCounter() == 0))
 		mOutput = 0;
 	else
 		mOutput = mEnvelope.getOutput();
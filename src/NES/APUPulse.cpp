@@ -57,6 +57,53 @@ void APUPulse::update(APUFrameCounterState fcState)
 		mOutput = mEnvelope.getOutput();
 }
 
+void APUPulse::executeIdleCycles(u32 cycles)
+{
+	// Same as calling update() without frame counter step "cycles" times:
+	// only the sequencer moves, the output is the one of the last cycle
+	if (cycles == 0)
+		return;
+
+	u32 sequencerClocks = mTimer.countDown(cycles - 1);
+	mSequenceIndex = (u8)((mSequenceIndex + sequencerClocks) % 8);
+	update(APUFrameCounterState::IDLE);
+}
+
+s32 APUPulse::getCyclesToOutputChange() const
+{
+	// The output of a cycle is the sequencer value before its timer clock:
+	// it changes on the cycle after a clock
+	if (computeOutput(mSequenceIndex) != mOutput)
+		return 1;
+
+	// Can't change without frame counter step or register write
+	if (isSilenced())
+		return INT32_MAX;
+
+	return mTimer.getCounter() + 2;
+}
+
+bool APUPulse::isSilenced() const
+{
+	u16 timerPeriod = mTimer.getPeriod();
+	u16 targetPeriod = mIsPulse1 ?
+	                   mSweep.calculateTargetPeriod1(timerPeriod) :
+	                   mSweep.calculateTargetPeriod2(timerPeriod);
+
+	// Gates (Sweep, length counter & envelope)
+	return mSweep.isMuting(timerPeriod, targetPeriod) || 
+	       (mLengthCounter.getCounter() == 0)          ||
+	       (mEnvelope.getOutput() == 0);
+}
+
+u8 APUPulse::computeOutput(u8 sequenceIndex) const
+{
+	if (isSilenced() || (SEQUENCER_LUT[mDutyCycle][sequenceIndex] == 0))
+		return 0;
+	else
+		return mEnvelope.getOutput();
+}
+
 void APUPulse::setReg0(u8 value)
 {
 	// reg0: DDlc vvvv
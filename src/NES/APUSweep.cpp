@@ -30,7 +30,7 @@ bool APUSweep::update(u16 timerPeriod, u16 targetPeriod)
 	return needsToUpdateTimer;
 }
 
-u16 APUSweep::calculateTargetPeriod1(u16 timerPeriod)
+u16 APUSweep::calculateTargetPeriod1(u16 timerPeriod) const
 {
 	u16 targetPeriod = timerPeriod;
 	
@@ -47,7 +47,7 @@ u16 APUSweep::calculateTargetPeriod1(u16 timerPeriod)
 	return targetPeriod;
 }
 
-u16 APUSweep::calculateTargetPeriod2(u16 timerPeriod)
+u16 APUSweep::calculateTargetPeriod2(u16 timerPeriod) const
 {
 	u16 targetPeriod = timerPeriod;
 	
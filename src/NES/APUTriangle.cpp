@@ -45,6 +45,31 @@ void APUTriangle::update(APUFrameCounterState fcState)
 	mOutput = SEQUENCER_LUT[mSequenceIndex];
 }
 
+void APUTriangle::executeIdleCycles(u32 cycles)
+{
+	// Same as calling update() without frame counter step "cycles" times
+	u32 sequencerClocks = mTimer.countDown(cycles);
+	bool isUltraSonic = mTimer.getPeriod() < 2;
+
+	if (!isUltraSonic             &&
+	    mLinearCounterValue != 0  &&
+	    mLengthCounter.getCounter() != 0)
+		mSequenceIndex = (u8)((mSequenceIndex + sequencerClocks) % 32);
+
+	mOutput = SEQUENCER_LUT[mSequenceIndex];
+}
+
+s32 APUTriangle::getCyclesToOutputChange() const
+{
+	// The sequencer is stopped
+	bool isUltraSonic = mTimer.getPeriod() < 2;
+	if (isUltraSonic || mLinearCounterValue == 0 || mLengthCounter.getCounter() == 0)
+		return INT32_MAX;
+
+	// Next timer clock
+	return mTimer.getCounter() + 1;
+}
+
 void APUTriangle::setReg0(u8 value)
 {
 	// reg0: CRRR RRRR
@@ -30,6 +30,8 @@ s32 CPU::reset(Memory& memory)
 	mPreviousI = 1;
 	mIsIDelayed = false;
 
+	mPredecodedInstruction = { false, 0, 0 };
+
 	// Push stack 2 times
 	mSp -= 2;
 
@@ -41,6 +43,8 @@ s32 CPU::reset(Memory& memory)
 
 s32 CPU::predictCyclesToRun(Memory &memory, bool isProcessingOamDma, bool isIrqSet, bool isNmiSet)
 {
+	mPredecodedInstruction.isValid = false;
+
 	// One cycle for OAM DMA
 	if (isProcessingOamDma)
 		return 1;
@@ -64,7 +68,12 @@ s32 CPU::predictCyclesToRun(Memory &memory, bool isProcessingOamDma, bool isIrqS
 	}
 
 	// Regular instruction, get its informations
-    return getInstructionCycleCount(memory);
+	// (cycle count expected without additionnal cycles)
+	predecode(memory);
+	if (!mPredecodedInstruction.isValid)
+		return 0;
+
+	return INSTRUCTION_LUT[mPredecodedInstruction.opcode].cycles;
 }
 
 s32 CPU::irq(Memory &memory)
@@ -147,7 +156,6 @@ s32 CPU::nmi(Memory &memory)
 s32 CPU::execute(s32 cycles, Memory &memory)
 {
 	s32 cyclesRequested = cycles;
-	bool hasPageCrossed;
 	while (cycles > 0)
 	{
 		// Log start state
@@ -157,18 +165,13 @@ s32 CPU::execute(s32 cycles, Memory &memory)
 		mIsIDelayed = false;
 		
 		// Fetch 
-		u8 instructionOpcode = fetchByte(cycles, memory);
-		instruction_t instruction = INSTRUCTION_LUT[instructionOpcode];
+		u8 opcode = fetchOpcode(cycles, memory);
 
 		// Log disassembled instruction
-		cpuLogDisassembly(instruction.str);
+		cpuLogDisassembly(INSTRUCTION_LUT[opcode].str);
 
-		// Get address
-		u16 dummyAddress;
-		u16 address = fetchAddr(cycles, memory, instruction.addrMode, dummyAddress, hasPageCrossed);
-		
-		// Execute
-		executeInstruction(cycles, memory, instruction, address, dummyAddress, hasPageCrossed);
+		// Get address & execute
+		(this->*OPCODE_HANDLER_LUT[opcode])(cycles, memory);
 
 		// Log end
 		cpuLogEnd();
@@ -244,56 +247,74 @@ u8 CPU::stackPull(s32 &cycles, Memory &memory)
 	return value;
 }
 
-s32 CPU::getInstructionCycleCount(Memory & memory)
+void CPU::predecode(const Memory &memory)
 {
-	s32 dummyCycles = 0;
+	// Peek the opcode: no side effect on the bus (mapper, registers, logs)
+	u8 instructionOpcode;
+	if (!memory.cpuPeek(mPc, instructionOpcode))
+		return;
 
-	// Prevent logging address & value
-	bool oldCpuTraceFlag = gIsTraceLogCpuEnabled;
-	gIsTraceLogCpuEnabled = false;
+	mPredecodedInstruction = { true, mPc, instructionOpcode };
+}
 
-	// Get instruction informations
-	instruction_t instruction = INSTRUCTION_LUT[readByte(dummyCycles, memory, mPc)];
+u8 CPU::fetchOpcode(s32 &cycles, Memory &memory)
+{
+	bool isPredecoded = mPredecodedInstruction.isValid;
+	mPredecodedInstruction.isValid = false;
 
-	// Retrieve logging flag
-	gIsTraceLogCpuEnabled = oldCpuTraceFlag;
+	// Use the predecoded opcode if it is still relevant
+	// (the bus fetch is kept when tracing so that the mapped address is logged)
+	if (isPredecoded && mPredecodedInstruction.pc == mPc && !gIsTraceLogCpuEnabled)
+	{
+		mPc++;
+		cycles--;
+		return mPredecodedInstruction.opcode;
+	}
 
-	// Return the cycle count expected without additionnal cycles.
-	return instruction.cycles;
+	return fetchByte(cycles, memory);
 }
 
-u16 CPU::fetchAddr(s32 &cycles, Memory &memory, AddressingMode addrMode, u16& dummyAddress, bool &hasPageCrossed)
+template<u8 opcode>
+void CPU::executeOpcode(s32 &cycles, Memory &memory)
 {
-	u16 address;
-	hasPageCrossed = false;
-	switch (addrMode)
-	{
-	case AddressingMode::Implicit:
+	constexpr Operation operation = INSTRUCTION_LUT[opcode].operation;
+	constexpr AddressingMode addrMode = INSTRUCTION_LUT[opcode].addrMode;
+
+	// Get address
+	u16 dummyAddress = 0x0000;
+	bool hasPageCrossed = false;
+	u16 address = fetchAddr<addrMode>(cycles, memory, dummyAddress, hasPageCrossed);
+
+	// Execute
+	executeInstruction<opcode, operation, addrMode>(cycles, memory, address, dummyAddress, hasPageCrossed);
+}
+
+template<AddressingMode addrMode>
+u16 CPU::fetchAddr([[maybe_unused]] s32 &cycles, [[maybe_unused]] Memory &memory, [[maybe_unused]] u16& dummyAddress, [[maybe_unused]] bool &hasPageCrossed)
+{
+	u16 address = 0x0000;
+	if constexpr (addrMode == AddressingMode::Implicit)
 	{
 		// Nothing to do... 
 		address = 0x0000;
-	} break;
-
-	case AddressingMode::Accumulator:
+	}
+	else if constexpr (addrMode == AddressingMode::Accumulator)
 	{
 		// Nothing to do... 
 		address = 0x0000;
-	} break;
-
-	case AddressingMode::Immediate:
+	}
+	else if constexpr (addrMode == AddressingMode::Immediate)
 	{
 		// Just return PC and increment 
 		address = mPc;
 		mPc++;
-	} break;
-
-	case AddressingMode::ZeroPage:
+	}
+	else if constexpr (addrMode == AddressingMode::ZeroPage)
 	{
 		// Fetch zero page address 
 		address = fetchByte(cycles, memory);
-	} break;
-
-	case AddressingMode::ZeroPageX:
+	}
+	else if constexpr (addrMode == AddressingMode::ZeroPageX)
 	{
 		// Fetch zero page address 
 		address = fetchByte(cycles, memory);
@@ -301,9 +322,8 @@ u16 CPU::fetchAddr(s32 &cycles, Memory &memory, AddressingMode addrMode, u16& du
 		// Add the value of register X to address, wraps in case of overflow
 		address = (address + mX) & 0x00FF;
 		cycles--;
-	} break;
-
-	case AddressingMode::ZeroPageY:
+	}
+	else if constexpr (addrMode == AddressingMode::ZeroPageY)
 	{
 		// Fetch zero page address 
 		address = fetchByte(cycles, memory);
@@ -311,9 +331,8 @@ u16 CPU::fetchAddr(s32 &cycles, Memory &memory, AddressingMode addrMode, u16& du
 		// Add the value of register Y to address, wraps in case of overflow
 		address = (address + mY) & 0x00FF;
 		cycles--;
-	} break;
-
-	case AddressingMode::Relative:
+	}
+	else if constexpr (addrMode == AddressingMode::Relative)
 	{
 		// Fetch address offset
 		// WARNING: the offset is signed, byte is a 8 bits unsigned data type
@@ -325,15 +344,13 @@ u16 CPU::fetchAddr(s32 &cycles, Memory &memory, AddressingMode addrMode, u16& du
 
 		// Branch to another page => additionnal cycles (XOR magic, too lazy to store MSBs)
 		hasPageCrossed = ((mPc ^ address) & 0xFF00) != 0;
-	} break;
-
-	case AddressingMode::Absolute:
+	}
+	else if constexpr (addrMode == AddressingMode::Absolute)
 	{
 		// Fetch absolute address
 		address = fetchWord(cycles, memory);
-	} break;
-
-	case AddressingMode::AbsoluteX:
+	}
+	else if constexpr (addrMode == AddressingMode::AbsoluteX)
 	{
 		// Fetch absolute address
 		dummyAddress = fetchWord(cycles, memory);
@@ -346,9 +363,8 @@ u16 CPU::fetchAddr(s32 &cycles, Memory &memory, AddressingMode addrMode, u16& du
 
 		// If we go to the next page, some instruction will add one more cycle
 		hasPageCrossed = msb != prevMsb;
-	} break;
-
-	case AddressingMode::AbsoluteY:
+	}
+	else if constexpr (addrMode == AddressingMode::AbsoluteY)
 	{
 		// Fetch absolute address
 		dummyAddress = fetchWord(cycles, memory);
@@ -361,9 +377,8 @@ u16 CPU::fetchAddr(s32 &cycles, Memory &memory, AddressingMode addrMode, u16& du
 
 		// If we go to the next page, some instruction will add one more cycle
 		hasPageCrossed = msb != prevMsb;
-	} break;
-
-	case AddressingMode::Indirect:
+	}
+	else if constexpr (addrMode == AddressingMode::Indirect)
 	{
 		// Fetch indirect address
 		u16 indirectAddress = fetchWord(cycles, memory);
@@ -378,9 +393,8 @@ u16 CPU::fetchAddr(s32 &cycles, Memory &memory, AddressingMode addrMode, u16& du
 		u8 targetAddressLsb = readByte(cycles, memory, indirectAddress);
 		u8 targetAddressMsb = readByte(cycles, memory, indirectAddressToMsb);
 		address = ((u16)targetAddressMsb << 8) | targetAddressLsb;
-	} break;
-
-	case AddressingMode::IndirectX:
+	}
+	else if constexpr (addrMode == AddressingMode::IndirectX)
 	{
 		// Fetch zero page address
 		address = fetchByte(cycles, memory);
@@ -397,9 +411,8 @@ u16 CPU::fetchAddr(s32 &cycles, Memory &memory, AddressingMode addrMode, u16& du
 
 		// Combine LSB & MSB
 		address = ((u16)targetAddressMsb << 8) | targetAddressLsb;
-	} break;
-
-	case AddressingMode::IndirectY:
+	}
+	else if constexpr (addrMode == AddressingMode::IndirectY)
 	{
 		// Fetch zero page address
 		u16 zpAddress = fetchByte(cycles, memory);
@@ -419,260 +432,142 @@ u16 CPU::fetchAddr(s32 &cycles, Memory &memory, AddressingMode addrMode, u16& du
 		
 		// If we go to the next page, some instruction will add one more cycle
 		hasPageCrossed = targetAddressMsb != ((address & 0xFF00) >> 8);
-	} break;
-	
-	default:
-		// This can't happen... just crash the program if it access this case
-		std::cout << __FILE__ 
-				  << ':' 
-				  << __LINE__ 
-				  << ": error: accessed impossible default case. Just tell the programmer he's dumb if it occurs..."; 
-		exit(EXIT_FAILURE);
-		break;
 	}
 
 	return address;
 }
 
-void CPU::executeInstruction(s32 &cycles, Memory &memory, instruction_t instruction, u16 address, u16 dummyAddress, bool hasPageCrossed)
+template<u8 opcode, Operation operation, AddressingMode addrMode>
+void CPU::executeInstruction(s32 &cycles, [[maybe_unused]] Memory &memory, [[maybe_unused]] u16 address, [[maybe_unused]] u16 dummyAddress, [[maybe_unused]] bool hasPageCrossed)
 {
-	Operation operation = instruction.operation;
-	AddressingMode addrMode = instruction.addrMode;
-	u8 opcode = instruction.opcode;
-
-	switch (operation)
-	{
-	case Operation::ADC:
+	if constexpr (operation == Operation::ADC)
 		adc(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::AND:
+	else if constexpr (operation == Operation::AND)
 		and_(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::ASL:
+	else if constexpr (operation == Operation::ASL)
 		asl(cycles, memory, address, dummyAddress, addrMode);
-		break;
-
-	case Operation::BCC:
+	else if constexpr (operation == Operation::BCC)
 		bcc(cycles, address, hasPageCrossed);
-		break;
-
-	case Operation::BCS:
+	else if constexpr (operation == Operation::BCS)
 		bcs(cycles, address, hasPageCrossed);
-		break;
-
-	case Operation::BEQ:
+	else if constexpr (operation == Operation::BEQ)
 		beq(cycles, address, hasPageCrossed);
-		break;
-
-	case Operation::BIT:
+	else if constexpr (operation == Operation::BIT)
 		bit(cycles, memory, address);
-		break;
-
-	case Operation::BRK:
+	else if constexpr (operation == Operation::BRK)
 		brk(cycles, memory);
-		break;
-
-	case Operation::BMI:
+	else if constexpr (operation == Operation::BMI)
 		bmi(cycles, address, hasPageCrossed);
-		break;
-
-	case Operation::BNE:
+	else if constexpr (operation == Operation::BNE)
 		bne(cycles, address, hasPageCrossed);
-		break;
-
-	case Operation::BPL:
+	else if constexpr (operation == Operation::BPL)
 		bpl(cycles, address, hasPageCrossed);
-		break;
-
-	case Operation::BVC:
+	else if constexpr (operation == Operation::BVC)
 		bvc(cycles, address, hasPageCrossed);
-		break;
-
-	case Operation::BVS:
+	else if constexpr (operation == Operation::BVS)
 		bvs(cycles, address, hasPageCrossed);
-		break;
-
-	case Operation::CLC:
+	else if constexpr (operation == Operation::CLC)
 		clc(cycles);
-		break;
-
-	case Operation::CLD:
+	else if constexpr (operation == Operation::CLD)
 		cld(cycles);
-		break;
-
-	case Operation::CLI:
+	else if constexpr (operation == Operation::CLI)
 		cli(cycles);
-		break;
-
-	case Operation::CLV:
+	else if constexpr (operation == Operation::CLV)
 		clv(cycles);
-		break;
-
-	case Operation::CMP:
+	else if constexpr (operation == Operation::CMP)
 		cmp(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::CPX:
+	else if constexpr (operation == Operation::CPX)
 		cpx(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::CPY:
+	else if constexpr (operation == Operation::CPY)
 		cpy(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::DEX:
+	else if constexpr (operation == Operation::DEX)
 		dex(cycles);
-		break;
-
-	case Operation::DEY:
+	else if constexpr (operation == Operation::DEY)
 		dey(cycles);
-		break;
-
-	case Operation::DEC:
+	else if constexpr (operation == Operation::DEC)
 		dec(cycles, memory, address, dummyAddress, addrMode);
-		break;
-
-	case Operation::EOR:
+	else if constexpr (operation == Operation::EOR)
 		eor(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::INC:
+	else if constexpr (operation == Operation::INC)
 		inc(cycles, memory, address, dummyAddress, addrMode);
-		break;
-
-	case Operation::INX:
+	else if constexpr (operation == Operation::INX)
 		inx(cycles);
-		break;
-
-	case Operation::INY:
+	else if constexpr (operation == Operation::INY)
 		iny(cycles);
-		break;
-
-	case Operation::JMP:
+	else if constexpr (operation == Operation::JMP)
 		jmp(address);
-		break;
-
-	case Operation::JSR:
+	else if constexpr (operation == Operation::JSR)
 		jsr(cycles, memory, address);
-		break;
-
-	case Operation::LDA:
+	else if constexpr (operation == Operation::LDA)
 		lda(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::LDX:
+	else if constexpr (operation == Operation::LDX)
 		ldx(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::LDY:
+	else if constexpr (operation == Operation::LDY)
 		ldy(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::LSR:
+	else if constexpr (operation == Operation::LSR)
 		lsr(cycles, memory, address, dummyAddress, addrMode);
-		break;
-
-	case Operation::NOP:
+	else if constexpr (operation == Operation::NOP)
 		nop(cycles);
-		break;
-
-	case Operation::ORA:
+	else if constexpr (operation == Operation::ORA)
 		ora(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::PHA:
+	else if constexpr (operation == Operation::PHA)
 		pha(cycles, memory);
-		break;
-
-	case Operation::PHP:
+	else if constexpr (operation == Operation::PHP)
 		php(cycles, memory);
-		break;
-
-	case Operation::PLA:
+	else if constexpr (operation == Operation::PLA)
 		pla(cycles, memory);
-		break;
-
-	case Operation::PLP:
+	else if constexpr (operation == Operation::PLP)
 		plp(cycles, memory);
-		break;
-
-	case Operation::ROL:
+	else if constexpr (operation == Operation::ROL)
 		rol(cycles, memory, address, dummyAddress, addrMode);
-		break;
-
-	case Operation::ROR:
+	else if constexpr (operation == Operation::ROR)
 		ror(cycles, memory, address, dummyAddress, addrMode);
-		break;
-
-	case Operation::RTI:
+	else if constexpr (operation == Operation::RTI)
 		rti(cycles, memory);
-		break;
-
-	case Operation::RTS:
+	else if constexpr (operation == Operation::RTS)
 		rts(cycles, memory);
-		break;
-
-	case Operation::SBC:
+	else if constexpr (operation == Operation::SBC)
 		sbc(cycles, memory, address, dummyAddress, hasPageCrossed);
-		break;
-
-	case Operation::SEC:
+	else if constexpr (operation == Operation::SEC)
 		sec(cycles);
-		break;
-
-	case Operation::SED:
+	else if constexpr (operation == Operation::SED)
 		sed(cycles);
-		break;
-
-	case Operation::SEI:
+	else if constexpr (operation == Operation::SEI)
 		sei(cycles);
-		break;
-
-	case Operation::STA:
+	else if constexpr (operation == Operation::STA)
 		sta(cycles, memory, address, dummyAddress, addrMode);
-		break;
-
-	case Operation::STX:
+	else if constexpr (operation == Operation::STX)
 		stx(cycles, memory, address);
-		break;
-
-	case Operation::STY:
+	else if constexpr (operation == Operation::STY)
 		sty(cycles, memory, address);
-		break;
-
-	case Operation::TAX:
+	else if constexpr (operation == Operation::TAX)
 		tax(cycles);
-		break;
-
-	case Operation::TAY:
+	else if constexpr (operation == Operation::TAY)
 		tay(cycles);
-		break;
-
-	case Operation::TSX:
+	else if constexpr (operation == Operation::TSX)
 		tsx(cycles);
-		break;
-
-	case Operation::TXA:
+	else if constexpr (operation == Operation::TXA)
 		txa(cycles);
-		break;
-
-	case Operation::TXS:
+	else if constexpr (operation == Operation::TXS)
 		txs(cycles);
-		break;
-
-	case Operation::TYA:
+	else if constexpr (operation == Operation::TYA)
 		tya(cycles);
-		break;
-
-	default:
+	else
+	{
 		std::cout << "Operation not handled: 0x" << std::hex << std::uppercase << (int)opcode << std::dec << std::endl;
 		cycles--;
-		break;
 	}
 }
 
+template<std::size_t... opcodes>
+constexpr std::array<CPU::OpcodeHandler, sizeof...(opcodes)> CPU::makeOpcodeHandlerLut(std::index_sequence<opcodes...>)
+{
+	// Specialize a handler on the operation & addressing mode of each opcode
+	return {{ &CPU::executeOpcode<(u8)opcodes>... }};
+}
+
+const std::array<CPU::OpcodeHandler, 256> CPU::OPCODE_HANDLER_LUT = CPU::makeOpcodeHandlerLut(std::make_index_sequence<256>());
+
 void CPU::adc(s32 &cycles, Memory &memory, u16 address, u16 dummyAddress, bool hasPageCrossed)
 {
 	// Save previous Accumulator state, for status update
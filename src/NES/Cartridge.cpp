@@ -1,15 +1,11 @@
 #include "NES/Cartridge.hpp"
 
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
 #include "NES/Config.hpp"
-#include "NES/Mapper000.hpp"
-#include "NES/Mapper001.hpp"
-#include "NES/Mapper002.hpp"
-#include "NES/Mapper003.hpp"
-#include "NES/Mapper004.hpp"
 #include "NES/Toolbox.hpp"
 
 Cartridge::Cartridge(const std::string& romFilename)
@@ -29,6 +25,8 @@ Cartridge::Cartridge(const std::string& romFilename)
 
 	// Optimism :)
 	mIsRomPlayable = true;
+	mRomHash = 0;
+	mIsMonitoringPpuBus = false;
 
 	// Open file 
 	std::filesystem::path romPath = romFilename;
@@ -89,39 +87,42 @@ Cartridge::Cartridge(const std::string& romFilename)
 	// Set error flag on unwanted header
 	testAndSetErrorFlag(!isINesHeader, "ROM file is not iNES.");
 	testAndSetErrorFlag(hasTrainer, "Trainer not implemented.");
-	testAndSetErrorFlag(hasAltNtLayout, "Alternative Nametable Layout not implemented.");
 	testAndSetErrorFlag(isVsUnisystem, "VS Unisystem not implemented.");
 	testAndSetErrorFlag(isPlaychoice10, "PlayChoice-10 not implemented.");
 	testAndSetErrorFlag(isNes2Header, "NES 2.0 not implemented.");
 	if (!mIsRomPlayable)
 		return;
 
+	// Four-screen VRAM
+	if (hasAltNtLayout)
+		ntArr = NametableArrangement::FOUR_SCREEN;
+
 	// Create a mapper object
 	u32 chrRamSize = 0x2000;
 	std::stringstream mapperErrorMsg;
 	switch (mapperNum)
 	{
 		case 0:
-			mMapper = std::make_unique<Mapper000>(header.prgNumBanks, header.chrNumBanks, ntArr);
+			mMapper.emplace<Mapper000>(header.prgNumBanks, header.chrNumBanks, ntArr);
 			break;
 
 		case 1:
-			mMapper = std::make_unique<Mapper001>(header.prgNumBanks, header.chrNumBanks);
+			mMapper.emplace<Mapper001>(header.prgNumBanks, header.chrNumBanks);
 			
 			// Assume PRG-RAM 8 KB
 			mPrgRam.resize(0x2000);
 			break;
 
 		case 2:
-			mMapper = std::make_unique<Mapper002>(header.prgNumBanks, header.chrNumBanks, ntArr);
+			mMapper.emplace<Mapper002>(header.prgNumBanks, header.chrNumBanks, ntArr);
 			break;
 
 		case 3:
-			mMapper = std::make_unique<Mapper003>(header.prgNumBanks, header.chrNumBanks, ntArr);
+			mMapper.emplace<Mapper003>(header.prgNumBanks, header.chrNumBanks, ntArr);
 			break;
 
 		case 4:
-			mMapper = std::make_unique<Mapper004>(header.prgNumBanks, header.chrNumBanks, ntArr);
+			mMapper.emplace<Mapper004>(header.prgNumBanks, header.chrNumBanks, ntArr);
 			mPrgRam.resize(0x2000);
 			break;
 		
@@ -133,6 +134,9 @@ Cartridge::Cartridge(const std::string& romFilename)
 	if (!mIsRomPlayable)
 		return;
 
+	// Constant for a given mapper, checked on every PPU access
+	mIsMonitoringPpuBus = visitMapper([](const auto& mapper) { return mapper.isMonitoringPpuBus(); });
+
 	// Initialise save PRG-RAM file
 	if (hasBatteryPrgRam)
 	{
@@ -172,6 +176,16 @@ Cartridge::Cartridge(const std::string& romFilename)
 		// but only for 2 games -> will likely not be implemented)
 		mChrRam.resize(chrRamSize);
 	}
+	decodeTileRows(mChrRom, mChrRomTileRows);
+	decodeTileRows(mChrRam, mChrRamTileRows);
+
+	// FNV-1a
+	mRomHash = 0xCBF2'9CE4'8422'2325;
+	for (const std::vector<u8>* rom : { &mPrgRom, &mChrRom })
+	{
+		for (u8 byte : *rom)
+			mRomHash = (mRomHash ^ byte) * 0x0000'0100'0000'01B3;
+	}
 
 	// ******** Read PlayChoice INST-ROM (if present (WTF????? (Not implemented))) ******** //
 	// ******** Read PlayChoice PROM (if present (WTF????? (Not Implemented))) ******** //
@@ -179,93 +193,155 @@ Cartridge::Cartridge(const std::string& romFilename)
 
 void Cartridge::reset()
 {
-	if (mMapper != nullptr)
-		mMapper->reset();
+	visitMapper([](auto& mapper) { mapper.reset(); });
 	
 	savePrgRam();
 }
 
-bool Cartridge::readPrg(u16 cpuAddress, u8 &output)
+void Cartridge::saveState(cartridgeState_t& state) const
 {
-	u32 prgAddr;
-	if (!mMapper->mapCpuRead(cpuAddress, prgAddr))
-		return false;
+	// Same sizes from a save to the next: no allocation
+	state.prgRam = mPrgRam;
+	state.chrRam = mChrRam;
+	state.chrRamTileRows = mChrRamTileRows;
+	// Whole bytes: the padding of the binary save states does not depend on the previous content of the state
+	std::memcpy((void*)&state.mapper, (const void*)&mMapper, sizeof(mapper_t));
+}
 
-	logMappedAddress(prgAddr);
+void Cartridge::loadState(const cartridgeState_t& state)
+{
+	mPrgRam = state.prgRam;
+	mChrRam = state.chrRam;
+	mChrRamTileRows = state.chrRamTileRows;
+	mMapper = state.mapper;
+}
 
-	// Check if target is PRG RAM or ROM
-	output = mMapper->isPrgRamRead() ?
-	         mPrgRam[prgAddr] :
-			 mPrgRom[prgAddr];
+bool Cartridge::peekPrg(u16 cpuAddress, u8& output) const
+{
+	// Same as readPrg, without logging
+	u32 prgAddr;
+	if (!visitMapper([&](const auto& mapper) { return mapper.mapCpuRead(cpuAddress, prgAddr); }))
+		return false;
 
-	logValue(output);
+	const std::vector<u8>& prgMemory = isPrgRamAddress(cpuAddress) ? mPrgRam : mPrgRom;
+	if (prgMemory.empty())
+		return false;
+	output = prgMemory[prgAddr % prgMemory.size()];
 
 	return true;
 }
 
-bool Cartridge::writePrg(u16 cpuAddress, u8 input)
+void Cartridge::mapPrgPages(std::array<const u8*, 256>& readPages, std::array<u8*, 256>& writePages)
 {
-	// Write into the PRG-RAM
-	u32 prgRamAddr = 0xFFFFFFFF;
-	if (!mMapper->mapCpuWrite(cpuAddress, prgRamAddr, input))
-		return false;
+	// Cartridge space starts at $4020, the first complete page is $4100
+	for (u32 page = 0x41; page < 0x100; page++)
+	{
+		readPages[page] = nullptr;
+		writePages[page] = nullptr;
+	}
 
-	if (prgRamAddr < mPrgRam.size())
-		mPrgRam[prgRamAddr] = input;
-		
-	return true;
+	visitMapper([&](const auto& mapper)
+	{
+		for (u32 page = 0x41; page < 0x100; page++)
+		{
+			// Banks are at least 8 kB: a page is mapped to contiguous memory
+			u16 pageAddress = (u16)(page << 8);
+			u32 prgAddr;
+			if (!mapper.mapCpuRead(pageAddress, prgAddr))
+				continue;
+
+			// Banks out of the memory are left to the mapper
+			std::vector<u8>& prgMemory = isPrgRamAddress(pageAddress) ? mPrgRam : mPrgRom;
+			if (prgAddr + 0xFF >= prgMemory.size())
+				continue;
+
+			// PRG-RAM is written where it is read
+			readPages[page] = &prgMemory[prgAddr];
+			if (isPrgRamAddress(pageAddress))
+				writePages[page] = &prgMemory[prgAddr];
+		}
+	});
 }
 
-bool Cartridge::readChr(u16 ppuAddress, u8& output, u16& mappedNtAddress, u16 ppuCycleCount)
+void Cartridge::mapChrPages(std::array<const u8*, 8>& readPages, std::array<u8*, 8>& writePages, std::array<u64*, 8>& tileRowPages)
 {
-	u32 chrAddr;
-	if (!mMapper->mapPpuRead(ppuAddress, chrAddr, ppuCycleCount))
+	// Unplayable ROM (no mapper) or no CHR memory: nothing is mapped
+	readPages.fill(nullptr);
+	writePages.fill(nullptr);
+	tileRowPages.fill(nullptr);
+
+	visitMapper([&](const auto& mapper)
 	{
-		mappedNtAddress = mapNtAddress(ppuAddress);
-		return false;
-	}
+		// Pattern tables: 1 kB pages ($0000-$1FFF)
+		std::vector<u8>& chrMemory = mapper.isChrRamSelected() ? mChrRam : mChrRom;
+		std::vector<u64>& chrTileRows = mapper.isChrRamSelected() ? mChrRamTileRows : mChrRomTileRows;
+		if (chrMemory.empty())
+			return;
 
-	output = mMapper->isChrRamSelected() ?
-	         mChrRam[chrAddr] :
-			 mChrRom[chrAddr];
-	return true;
+		for (u32 page = 0; page < 8; page++)
+		{
+			u32 chrAddr;
+			mapper.mapPpuAddress((u16)(page << 10), chrAddr);
+
+			// Banks out of the memory are mirrored
+			chrAddr %= chrMemory.size();
+
+			// Writing to CHR-ROM does nothing
+			readPages[page] = &chrMemory[chrAddr];
+			writePages[page] = mapper.isChrRamSelected() ? &chrMemory[chrAddr] : nullptr;
+			tileRowPages[page] = &chrTileRows[getTileRowIdx(chrAddr)];
+		}
+	});
 }
 
-bool Cartridge::writeChr(u16 ppuAddress, u8 input, u16& mappedNtAddress, u16 ppuCycleCount)
+// Bits of a pattern table byte spread to the bit 0 of the pixels bytes (leftmost pixel first)
+static constexpr std::array<u64, 256> makeTilePlaneLut()
 {
-	u32 chrRamAddr;
-	if (!mMapper->mapPpuWrite(ppuAddress, chrRamAddr, ppuCycleCount))
+	std::array<u64, 256> lut = {};
+	for (u32 planeByte = 0; planeByte < 256; planeByte++)
 	{
-		mappedNtAddress = mapNtAddress(ppuAddress);
-		return false;
+		for (u32 xIdx = 0; xIdx < 8; xIdx++)
+			lut[planeByte] |= (u64)((planeByte >> (7 - xIdx)) & 0x01) << (xIdx * 8);
 	}
+	return lut;
+}
+static constexpr std::array<u64, 256> TILE_PLANE_LUT = makeTilePlaneLut();
+
+u64 Cartridge::decodeTileRow(u8 ptLsb, u8 ptMsb)
+{
+	// Whole CHR-RAM decoded by save state loads: no loop per pixel
+	return TILE_PLANE_LUT[ptLsb] | (TILE_PLANE_LUT[ptMsb] << 1);
+}
 
-	if (mMapper->isChrRamSelected())
+void Cartridge::decodeTileRows(const std::vector<u8>& chrMemory, std::vector<u64>& tileRows)
+{
+	// 16 bytes per tile: 8 rows of LSB plane, then 8 rows of MSB plane
+	tileRows.resize(chrMemory.size() / 2);
+	for (u32 chrAddr = 0; chrAddr + 0x000F < chrMemory.size(); chrAddr += 0x0010)
 	{
-		mChrRam[chrRamAddr] = input;
+		for (u32 fineY = 0; fineY < 8; fineY++)
+			tileRows[getTileRowIdx(chrAddr | fineY)] = decodeTileRow(chrMemory[chrAddr | fineY], chrMemory[chrAddr | 0x0008 | fineY]);
 	}
-	// No else:
-	// Apparently it's OK to "try" writing to CHR-ROM, as long as it does not modify it
-
-    return true;
 }
 
-u16 Cartridge::mapNtAddress(u16 ppuAddress)
+void Cartridge::mapNametables(std::array<u16, 4>& vramOffsets) const
 {
-	u16 mappedNtAddress;
-	NametableArrangement ntArr = mMapper->getNtArragenement();
-
-	// Map address to VRAM address (Nametable)
-	if (ntArr == NametableArrangement::VERT)
-		mappedNtAddress = (ppuAddress & 0b0000'0011'1111'1111) | ((ppuAddress >> 1) & 0b0000'0100'0000'0000);
-	else if (ntArr == NametableArrangement::HOR)
-		mappedNtAddress = ppuAddress & 0b0000'0111'1111'1111;
-	else // if (ntArr == NametableArrangement::ONE_SCREEN)
-		mappedNtAddress = (ppuAddress & 0b0000'0011'1111'1111) + mMapper->getVramBankAddressOffset();
-	// else 
-	// Not implemented 4-screen mirroring
-
-	return mappedNtAddress;
+	constexpr u16 NT_SIZE = 0x0400;
+	NametableArrangement ntArr = visitMapper([](const auto& mapper) { return mapper.getNtArragenement(); });
+	u16 vramBankAddressOffset = visitMapper([](const auto& mapper) { return mapper.getVramBankAddressOffset(); });
+
+	// Map each nametable to a VRAM bank
+	for (u16 ntIdx = 0; ntIdx < 4; ntIdx++)
+	{
+		if (ntArr == NametableArrangement::VERT)
+			vramOffsets[ntIdx] = (ntIdx >> 1) * NT_SIZE;
+		else if (ntArr == NametableArrangement::HOR)
+			vramOffsets[ntIdx] = (ntIdx & 0x01) * NT_SIZE;
+		else if (ntArr == NametableArrangement::ONE_SCREEN)
+			vramOffsets[ntIdx] = vramBankAddressOffset;
+		else // if (ntArr == NametableArrangement::FOUR_SCREEN)
+			vramOffsets[ntIdx] = ntIdx * NT_SIZE;
+	}
 }
 
 inline void Cartridge::savePrgRam()
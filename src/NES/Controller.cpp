@@ -4,12 +4,14 @@
 
 u8 Controller::getStateBitAndShift()
 {
+    // Strobe high: the buttons state is reloaded continuously
+    if (mIsUpdatingState)
+        mControllerShiftRegister = mControllerState.load(std::memory_order_relaxed);
+
     // Get button state and shift buttons register
     u8 buttonBit = mControllerShiftRegister & 0b0000'0001;
 
-    if (mIsUpdatingState)
-        mControllerShiftRegister = mControllerState;
-    else
+    if (!mIsUpdatingState)
         mControllerShiftRegister = (mControllerShiftRegister >> 1) | 0b1000'0000;
 
     return buttonBit;
@@ -18,14 +20,15 @@ u8 Controller::getStateBitAndShift()
 void Controller::setStrobe(u8 value)
 {
     mIsUpdatingState = (value & 0b0000'0001) != 0;
+    if (mIsUpdatingState && mStrobeCallback)
+        mControllerState.store(mStrobeCallback(), std::memory_order_relaxed);
+
     if (mIsUpdatingState)
-        mControllerShiftRegister = mControllerState;
+        mControllerShiftRegister = mControllerState.load(std::memory_order_relaxed);
 }
 
 void Controller::updateControllerState(u8 state)
 {
-    mControllerState = state;
-
-    if (mIsUpdatingState)
-        mControllerShiftRegister = mControllerState;
+    // Snapshot of the buttons (latched by the next strobe or read)
+    mControllerState.store(state, std::memory_order_relaxed);
 }
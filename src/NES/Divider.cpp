@@ -19,4 +19,21 @@ bool Divider::countDown()
 		mCounter--;
 	
 	return hasFinishedCycle;
+}
+
+u32 Divider::countDown(u32 cycles)
+{
+	// Same as calling countDown() "cycles" times, returns the number of finished cycles
+	if (cycles <= mCounter)
+	{
+		mCounter -= (u16)cycles;
+		return 0;
+	}
+
+	// First cycle finishes when the counter reaches 0, then every (period + 1) cycles
+	u32 cyclesAfterFirst = cycles - mCounter - 1;
+	u32 dividerCycleLength = (u32)mPeriod + 1;
+	mCounter = (u16)(mPeriod - (cyclesAfterFirst % dividerCycleLength));
+
+	return 1 + cyclesAfterFirst / dividerCycleLength;
 }
\ No newline at end of file
@@ -6,7 +6,9 @@ Mapper::Mapper(u8 prgNumBanks, u8 chrNumBanks, NametableArrangement ntArr)
 	mVramBankAddressOffset = 0;
 
 	mIsChrRamSelected = false;
-	mIsPrgRamRead = false;
+	mIsMonitoringPpuBus = false;
+	mIsMappingChanged = false;
 
+	mIsIrqEnabled = false;
 	mIsIrqSignalSet = false;
 }
\ No newline at end of file
@@ -21,7 +21,7 @@ bool Mapper000::mapCpuWrite(u16 address, u32 &mappedAddress, u8 value)
 	return false;
 }
 
-bool Mapper000::mapCpuRead(u16 address, u32 &mappedAddress)
+bool Mapper000::mapCpuRead(u16 address, u32 &mappedAddress) const
 {
 	if (0x8000 <= address)
 	{
@@ -36,19 +36,7 @@ bool Mapper000::mapCpuRead(u16 address, u32 &mappedAddress)
 	return false;
 }
 
-bool Mapper000::mapPpuWrite(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
-{
-	(void)ppuCycleCount;
-	return mapPpuAddress(address, mappedAddress);
-}
-
-bool Mapper000::mapPpuRead(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
-{
-	(void)ppuCycleCount;
-	return mapPpuAddress(address, mappedAddress);
-}
-
-bool Mapper000::mapPpuAddress(u16 address, u32 &mappedAddress)
+bool Mapper000::mapPpuAddress(u16 address, u32 &mappedAddress) const
 {
 	// No mapping required
 	if (address <= 0x1FFF)
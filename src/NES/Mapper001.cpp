@@ -48,6 +48,7 @@ bool Mapper001::mapCpuWrite(u16 address, u32 &mappedAddress, u8 value)
 	if (isResetTriggered)
 	{
 		reset();
+		mIsMappingChanged = true;
 		return false;
 	}
 	
@@ -62,7 +63,7 @@ bool Mapper001::mapCpuWrite(u16 address, u32 &mappedAddress, u8 value)
 	return false;
 }
 
-bool Mapper001::mapCpuRead(u16 address, u32 &mappedAddress)
+bool Mapper001::mapCpuRead(u16 address, u32 &mappedAddress) const
 {
 	// Is the cartridge targeted ?
 	if (address < 0x6000)
@@ -73,7 +74,6 @@ bool Mapper001::mapCpuRead(u16 address, u32 &mappedAddress)
 	{
 		// PRG-RAM
 		mappedAddress = address & 0x1FFF;
-		mIsPrgRamRead = true;
 		return true;
 	}
 
@@ -113,22 +113,9 @@ bool Mapper001::mapCpuRead(u16 address, u32 &mappedAddress)
 			break;
 	}
 
-	mIsPrgRamRead = false;
 	return true;
 }
 
-bool Mapper001::mapPpuWrite(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
-{
-	(void)ppuCycleCount;
-	return mapPpuAddress(address, mappedAddress);
-}
-
-bool Mapper001::mapPpuRead(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
-{
-	(void)ppuCycleCount;
-	return mapPpuAddress(address, mappedAddress);
-}
-
 void Mapper001::processShiftRegister(u16 address)
 {
 	constexpr u16 ADDRESS_MASK    = 0x6000;
@@ -145,6 +132,12 @@ void Mapper001::processShiftRegister(u16 address)
 		{	
 			u8 control = mCpuShiftRegister;
 
+			// Only a new bank or mirroring remaps the bus
+			u8 previousPrgBankMode = mPrgBankMode;
+			u8 previousChrBankMode = mChrBankMode;
+			NametableArrangement previousNtArrangement = mNtArrangement;
+			u16 previousVramBankAddressOffset = mVramBankAddressOffset;
+
 			// Set nametable arrangement
 			mChrBankMode = (control & 0b1'0000) >> 4;
 			mPrgBankMode = (control & 0b0'1100) >> 2;
@@ -171,18 +164,26 @@ void Mapper001::processShiftRegister(u16 address)
 					mNtArrangement = NametableArrangement::VERT;
 					break;
 			}
+
+			mIsMappingChanged |= (mPrgBankMode != previousPrgBankMode)                     ||
+			                     (mChrBankMode != previousChrBankMode)                     ||
+			                     (mNtArrangement != previousNtArrangement)                 ||
+			                     (mVramBankAddressOffset != previousVramBankAddressOffset);
 		} break;
 			
 		case CHR0_ADDRESS:
+			mIsMappingChanged |= (mChrBank0Idx != mCpuShiftRegister);
 			mChrBank0Idx = mCpuShiftRegister;
 			break;
 			
 		case CHR1_ADDRESS:
+			mIsMappingChanged |= (mChrBank1Idx != mCpuShiftRegister);
 			mChrBank1Idx = mCpuShiftRegister;
 			break;
 			
 		case PRG_ADDRESS:
 			// TODO: bit 4
+			mIsMappingChanged |= (mPrgBankIdx != (mCpuShiftRegister & 0b1111));
 			mPrgBankIdx = mCpuShiftRegister & 0b1111;
 			break;
 	}
@@ -191,7 +192,7 @@ void Mapper001::processShiftRegister(u16 address)
 	resetShiftRegister();
 }
 
-bool Mapper001::mapPpuAddress(u16 address, u32 &mappedAddress)
+bool Mapper001::mapPpuAddress(u16 address, u32 &mappedAddress) const
 {
 	// Mapping for CHR-ROM/RAM (pattern tables)
 	if (address <= 0x1FFF)
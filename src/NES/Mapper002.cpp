@@ -18,12 +18,15 @@ bool Mapper002::mapCpuWrite(u16 address, u32 &mappedAddress, u8 value)
 
 	// Bank select register
 	if (0x8000 <= address)
+	{
+		mIsMappingChanged |= (mPrgBankIdx != value);
 		mPrgBankIdx = value;
+	}
 
 	return false;
 }
 
-bool Mapper002::mapCpuRead(u16 address, u32 &mappedAddress)
+bool Mapper002::mapCpuRead(u16 address, u32 &mappedAddress) const
 {
 	// Is address targetting the cartridge ?
 	if (address < 0x8000)
@@ -48,19 +51,7 @@ bool Mapper002::mapCpuRead(u16 address, u32 &mappedAddress)
 	return true;
 }
 
-bool Mapper002::mapPpuWrite(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
-{
-	(void)ppuCycleCount;
-	return mapPpuAddress(address, mappedAddress);
-}
-
-bool Mapper002::mapPpuRead(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
-{
-	(void)ppuCycleCount;
-	return mapPpuAddress(address, mappedAddress);
-}
-
-bool Mapper002::mapPpuAddress(u16 address, u32 &mappedAddress)
+bool Mapper002::mapPpuAddress(u16 address, u32 &mappedAddress) const
 {
 	// No mapping required
 	if (address <= 0x1FFF)
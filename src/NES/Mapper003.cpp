@@ -18,12 +18,15 @@ bool Mapper003::mapCpuWrite(u16 address, u32 &mappedAddress, u8 value)
 
 	// Bank select register
 	if (0x8000 <= address)
+	{
+		mIsMappingChanged |= (mChrBankIdx != value);
 		mChrBankIdx = value;
+	}
 
 	return false;
 }
 
-bool Mapper003::mapCpuRead(u16 address, u32 &mappedAddress)
+bool Mapper003::mapCpuRead(u16 address, u32 &mappedAddress) const
 {
 	if (0x8000 <= address)
 	{
@@ -38,19 +41,7 @@ bool Mapper003::mapCpuRead(u16 address, u32 &mappedAddress)
 	return false;
 }
 
-bool Mapper003::mapPpuWrite(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
-{
-	(void)ppuCycleCount;
-	return mapPpuAddress(address, mappedAddress);
-}
-
-bool Mapper003::mapPpuRead(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
-{
-	(void)ppuCycleCount;
-	return mapPpuAddress(address, mappedAddress);
-}
-
-bool Mapper003::mapPpuAddress(u16 address, u32 &mappedAddress)
+bool Mapper003::mapPpuAddress(u16 address, u32 &mappedAddress) const
 {
 	if (address <= 0x1FFF)
 	{
@@ -6,6 +6,7 @@ Mapper004::Mapper004(u8 prgNumBanks, u8 chrNumBanks, NametableArrangement ntArr)
 	: Mapper(prgNumBanks, chrNumBanks, ntArr)
 {
 	mIsChrRamSelected = (chrNumBanks == 0);
+	mIsMonitoringPpuBus = true;
 }
 
 void Mapper004::reset()
@@ -43,7 +44,7 @@ bool Mapper004::mapCpuWrite(u16 address, u32 &mappedAddress, u8 value)
 	return false;
 }
 
-bool Mapper004::mapCpuRead(u16 address, u32 &mappedAddress)
+bool Mapper004::mapCpuRead(u16 address, u32 &mappedAddress) const
 {
 	// Is the cartridge targeted ?
 	if (address < 0x6000)
@@ -54,7 +55,6 @@ bool Mapper004::mapCpuRead(u16 address, u32 &mappedAddress)
 	{
 		// PRG-RAM
 		mappedAddress = address & 0x1FFF;
-		mIsPrgRamRead = true;
 		return true;
 	}
 
@@ -112,20 +112,9 @@ bool Mapper004::mapCpuRead(u16 address, u32 &mappedAddress)
 			break;
 	}
 
-	mIsPrgRamRead = false;
 	return true;
 }
 
-bool Mapper004::mapPpuWrite(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
-{
-	return mapPpuAddress(address, mappedAddress, ppuCycleCount);
-}
-
-bool Mapper004::mapPpuRead(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
-{
-	return mapPpuAddress(address, mappedAddress, ppuCycleCount);
-}
-
 void Mapper004::processRegisterWrite(u16 address, u8 value)
 {
 	constexpr u16 ADDRESS_MASK    = 0x6001;
@@ -141,20 +130,31 @@ void Mapper004::processRegisterWrite(u16 address, u8 value)
 	switch (address & ADDRESS_MASK)
 	{
 		case BANK_SELECT:
+		{
+			// Selecting a register remaps nothing, the bank modes do
+			u8 prgBankMode = (value & 0b0100'0000) >> 6;
+			u8 chrBankMode = (value & 0b1000'0000) >> 7;
+			mIsMappingChanged |= (mPrgBankMode != prgBankMode) || (mChrBankMode != chrBankMode);
+
 			mBankSelected = value & 0b0000'0111;
-			mPrgBankMode = (value & 0b0100'0000) >> 6;
-			mChrBankMode = (value & 0b1000'0000) >> 7;
-			break;
+			mPrgBankMode = prgBankMode;
+			mChrBankMode = chrBankMode;
+		} break;
 			
 		case BANK_DATA:
+			mIsMappingChanged |= (mBankRegisters[mBankSelected] != value);
 			mBankRegisters[mBankSelected] = value;
 			break;
 			
 		case MIRRORING:
 			if (mNtArrangement != NametableArrangement::FOUR_SCREEN)
-				mNtArrangement = (value & 0x01) == 0 ?
-				                 NametableArrangement::HOR :
-								 NametableArrangement::VERT;
+			{
+				NametableArrangement ntArrangement = (value & 0x01) == 0 ?
+				                                     NametableArrangement::HOR :
+				                                     NametableArrangement::VERT;
+				mIsMappingChanged |= (mNtArrangement != ntArrangement);
+				mNtArrangement = ntArrangement;
+			}
 			break;
 			
 		case PRG_RAM_PROTECT:
@@ -182,10 +182,8 @@ void Mapper004::processRegisterWrite(u16 address, u8 value)
 	}
 }
 
-bool Mapper004::mapPpuAddress(u16 address, u32 &mappedAddress, u16 ppuCycleCount)
+bool Mapper004::mapPpuAddress(u16 address, u32 &mappedAddress) const
 {
-	processIrqCounter(address, ppuCycleCount);
-
 	// Mapping for CHR-ROM/RAM (pattern tables)
 	if (address <= 0x1FFF)
 	{
@@ -231,6 +229,12 @@ bool Mapper004::mapPpuAddress(u16 address, u32 &mappedAddress, u16 ppuCycleCount
 	return false;
 }
 
+void Mapper004::processPpuAccess(u16 address, u16 ppuCycleCount)
+{
+	// The IRQ counter is clocked by PPU A12
+	processIrqCounter(address, ppuCycleCount);
+}
+
 void Mapper004::processIrqCounter(u16 address, u16 ppuCycleCount)
 {
 	// Check for a toggle in PPU A12
@@ -1,14 +1,34 @@
 #include "NES/MemoryNES.hpp"
 
+#include "NES/NES.hpp"
 #include "NES/PPU.hpp"
 #include "NES/APU.hpp"
+#include "NES/Toolbox.hpp"
 
 #include <random>
 #include <iostream>
 
-MemoryNES::MemoryNES(const std::string &romFilename, APU& apuRef, PPU& ppuRef, Controller& controller1Ref, Controller& controller2Ref)
-	: mCartridge(romFilename), mApuRef(apuRef), mPpuRef(ppuRef), mController1Ref(controller1Ref), mController2Ref(controller2Ref)
+MemoryNES::MemoryNES(const std::string &romFilename, NES& nesRef, APU& apuRef, PPU& ppuRef, Controller& controller1Ref, Controller& controller2Ref)
+	: mCartridge(romFilename), mNesRef(nesRef), mApuRef(apuRef), mPpuRef(ppuRef), mController1Ref(controller1Ref), mController2Ref(controller2Ref)
 {
+	// The mapper does not change until the next ROM: its bus paths are chosen once
+	std::visit([&](const auto& mapper)
+	{
+		using mapperType_t = std::decay_t<decltype(mapper)>;
+		mBusPaths.cpuRead = &MemoryNES::cpuReadMapped<mapperType_t>;
+		mBusPaths.cpuWrite = &MemoryNES::cpuWriteMapped<mapperType_t>;
+		mBusPaths.ppuRead = &MemoryNES::ppuReadMapped<mapperType_t>;
+		mBusPaths.ppuReadTileRow = &MemoryNES::ppuReadTileRowMapped<mapperType_t>;
+		mBusPaths.ppuWrite = &MemoryNES::ppuWriteMapped<mapperType_t>;
+	}, mCartridge.getMapper());
+
+	// Every access goes through the handlers until the first reset
+	mCpuReadPages.fill(nullptr);
+	mCpuWritePages.fill(nullptr);
+	mChrReadPages.fill(nullptr);
+	mChrWritePages.fill(nullptr);
+	mChrTileRowPages.fill(nullptr);
+	mNtPages.fill(nullptr);
 }
 
 void MemoryNES::reset()
@@ -26,16 +46,63 @@ void MemoryNES::reset()
 		mPpuVram[i] = (u8)distribution(generator);
 
 	mCartridge.reset();
+	mapCpuPages();
+	mapPpuPages();
 
 	mIsOamDmaStarted = false;
 	mIsCpuHalt = false;
 	mPreviousIsGetCycle = false;
 }
 
+void MemoryNES::saveState(memoryState_t& state) const
+{
+	state.cpuRam = mCpuRam;
+	state.ppuVram = mPpuVram;
+	state.oamDma = mOamDma;
+	state.oamDmaBuffer = mOamDmaBuffer;
+	state.oamDmaIdx = mOamDmaIdx;
+	state.isOamDmaStarted = mIsOamDmaStarted;
+	state.isCpuHalt = mIsCpuHalt;
+	state.previousIsGetCycle = mPreviousIsGetCycle;
+	mController1Ref.saveState(state.controller1);
+	mController2Ref.saveState(state.controller2);
+	mCartridge.saveState(state.cartridge);
+}
+
+void MemoryNES::loadState(const memoryState_t& state)
+{
+	mCpuRam = state.cpuRam;
+	mPpuVram = state.ppuVram;
+	mOamDma = state.oamDma;
+	mOamDmaBuffer = state.oamDmaBuffer;
+	mOamDmaIdx = state.oamDmaIdx;
+	mIsOamDmaStarted = state.isOamDmaStarted;
+	mIsCpuHalt = state.isCpuHalt;
+	mPreviousIsGetCycle = state.previousIsGetCycle;
+	mController1Ref.loadState(state.controller1);
+	mController2Ref.loadState(state.controller2);
+	mCartridge.loadState(state.cartridge);
+
+	// The banks & mirroring come with the mapper
+	mapCpuPages();
+	mapPpuPages();
+}
+
 u8 MemoryNES::cpuRead(u16 address)
+{
+	// RAM, PRG-RAM & PRG-ROM: direct access (the trace log needs the mapped address)
+	const u8* page = mCpuReadPages[address >> 8];
+	if (page != nullptr && !gIsTraceLogCpuEnabled)
+		return page[address & 0x00FF];
+
+	return (this->*mBusPaths.cpuRead)(address);
+}
+
+template<typename MapperType>
+u8 MemoryNES::cpuReadMapped(u16 address)
 {
 	u8 value = 0;
-	bool isInCartridgeMemory= mCartridge.readPrg(address, value);
+	bool isInCartridgeMemory= mCartridge.readPrg<MapperType>(address, value);
 	if (isInCartridgeMemory)
 		return value;
 	
@@ -47,14 +114,20 @@ u8 MemoryNES::cpuRead(u16 address)
 	else if (0x2000 <= address && address < 0x4000)
 	{
 		// PPU Registers
+		mNesRef.runPendingCycles();
 		value = mPpuRef.readRegister(*this, address & 0x2007);
+		mNesRef.invalidateNextEvent();
 	}
 	else if (0x4000 <= address && address < 0x4018)
 	{
 		// APU & IO Registers
 		if (address == APU_STATUS_CPU_ADDR)
-			 // APU status
+		{
+			// APU status
+			mNesRef.runPendingCycles();
 			value = mApuRef.readRegister(address);
+			mNesRef.invalidateNextEvent();
+		}
 
 		else if (address == CONTROLLER_1_STATE_ADDR)
 			// Controller 1
@@ -72,10 +145,64 @@ u8 MemoryNES::cpuRead(u16 address)
 	return value;
 }
 
+bool MemoryNES::cpuPeek(u16 address, u8& value) const
+{
+	// Side-effect free read (no mapper state, no log):
+	// registers cannot be peeked
+	const u8* page = mCpuReadPages[address >> 8];
+	if (page != nullptr)
+	{
+		value = page[address & 0x00FF];
+		return true;
+	}
+
+	if (mCartridge.peekPrg(address, value))
+		return true;
+
+	if (address < 0x2000)
+	{
+		// CPU RAM, mirrored 4 times
+		value = mCpuRam[address & 0x07FF];
+		return true;
+	}
+
+	return false;
+}
+
 void MemoryNES::cpuWrite(u16 address, u8 value)
+{
+	// RAM & PRG-RAM: direct access
+	u8* page = mCpuWritePages[address >> 8];
+	if (page != nullptr)
+	{
+		page[address & 0x00FF] = value;
+		return;
+	}
+
+	(this->*mBusPaths.cpuWrite)(address, value);
+}
+
+template<typename MapperType>
+void MemoryNES::cpuWriteMapped(u16 address, u8 value)
 {
 	// 0x4020 - 0xFFFF
-	bool isInCartridgeMemory= mCartridge.writePrg(address, value);
+	if (address >= 0x8000)
+	{
+		// Mapper registers: bank switching & IRQ
+		mNesRef.runPendingCycles();
+		mCartridge.writePrg<MapperType>(address, value);
+		// The MMC1 serial bits & the MMC3 IRQ registers leave the bus as it is
+		if (mCartridge.isMappingChanged())
+		{
+			mCartridge.clearMappingChanged();
+			mapCpuPages();
+			mapPpuPages();
+		}
+		mNesRef.invalidateNextEvent();
+		return;
+	}
+
+	bool isInCartridgeMemory= mCartridge.writePrg<MapperType>(address, value);
 	if (isInCartridgeMemory)
 		return;
 	
@@ -87,7 +214,9 @@ void MemoryNES::cpuWrite(u16 address, u8 value)
 	else if ((0x2000 <= address && address < 0x4000))
 	{
 		// PPU Registers
+		mNesRef.runPendingCycles();
 		mPpuRef.writeRegister(*this, address & 0x2007, value);
+		mNesRef.invalidateNextEvent();
 	}
 	else if (0x4000 <= address && address < 0x4018)
 	{
@@ -97,7 +226,9 @@ void MemoryNES::cpuWrite(u16 address, u8 value)
 			address == APU_FRAME_COUNTER_CPU_ADDR)
 		{
 			// APU
+			mNesRef.runPendingCycles();
 			mApuRef.writeRegister(address, value);
+			mNesRef.invalidateNextEvent();
 		}
 		else if (address == OAMDMA_CPU_ADDR)
 		{
@@ -117,21 +248,26 @@ void MemoryNES::cpuWrite(u16 address, u8 value)
 	}
 }
 
-u8 MemoryNES::ppuRead(u16 address, u16 ppuCycleCount)
+template<typename MapperType>
+u8 MemoryNES::ppuReadMapped(u16 address, u16 ppuCycleCount)
 {
 	address &= 0x3FFF;
-	u16 mappedNtAddress;
 
-	u8 value = 0;
-	bool isInCartridgeMemory = mCartridge.readChr(address, value, mappedNtAddress, ppuCycleCount);
-	if (isInCartridgeMemory)
-		return value;
+	// Some mappers watch the PPU address bus
+	mCartridge.processPpuAccess<MapperType>(address, ppuCycleCount);
 
-	if (0x2000 <= address && address < 0x3F00)
+	u8 value;
+	if (address < 0x2000)
 	{
-		value = mPpuVram[mappedNtAddress];
+		// Pattern tables (CHR-ROM/RAM)
+		value = mChrReadPages[address >> 10][address & 0x03FF];
 	}
-	else if (0x3F00 <= address && address < 0x4000)
+	else if (address < 0x3F00)
+	{
+		// Nametables (mirrored from $3000)
+		value = mNtPages[(address >> 10) & 0x03][address & 0x03FF];
+	}
+	else
 	{
 		value = mPpuRef.readPaletteRam(address);
 	}
@@ -139,25 +275,87 @@ u8 MemoryNES::ppuRead(u16 address, u16 ppuCycleCount)
     return value;
 }
 
-void MemoryNES::ppuWrite(u16 address, u8 value, u16 ppuCycleCount)
+template<typename MapperType>
+u64 MemoryNES::ppuReadTileRowMapped(u16 address, u16 ppuCycleCount)
+{
+	// Pattern table fetch ($0000-$1FFF): same as ppuRead,
+	// but the byte is returned as the plane of the decoded tile row it belongs to
+	address &= 0x1FFF;
+
+	// Some mappers watch the PPU address bus
+	mCartridge.processPpuAccess<MapperType>(address, ppuCycleCount);
+
+	u64 tileRow = mChrTileRowPages[address >> 10][Cartridge::getTileRowIdx(address & 0x03FF)];
+	return ((address & 0x0008) == 0) ? 
+	       tileRow & TILE_ROW_LSB_PLANE : 
+	       tileRow & TILE_ROW_MSB_PLANE;
+}
+
+template<typename MapperType>
+void MemoryNES::ppuWriteMapped(u16 address, u8 value, u16 ppuCycleCount)
 {
 	address &= 0x3FFF;
-	u16 mappedNtAddress = 0;
-	
-	bool isInCartridgeMemory = mCartridge.writeChr(address, value, mappedNtAddress, ppuCycleCount);
-	if (isInCartridgeMemory)
-		return;
 
-	if (0x2000 <= address && address < 0x3F00)
+	// Some mappers watch the PPU address bus
+	mCartridge.processPpuAccess<MapperType>(address, ppuCycleCount);
+
+	if (address < 0x2000)
 	{
-		mPpuVram[mappedNtAddress] = value;
+		// Pattern tables (CHR-RAM only)
+		u8* page = mChrWritePages[address >> 10];
+		if (page != nullptr)
+		{
+			page[address & 0x03FF] = value;
+
+			// Keep the decoded tile row up to date
+			u16 ptLsbOffset = address & 0x03F7;
+			u64 tileRow = Cartridge::decodeTileRow(page[ptLsbOffset], page[ptLsbOffset | 0x0008]);
+			mChrTileRowPages[address >> 10][Cartridge::getTileRowIdx(address & 0x03FF)] = tileRow;
+		}
+	}
+	else if (address < 0x3F00)
+	{
+		// Nametables (mirrored from $3000)
+		mNtPages[(address >> 10) & 0x03][address & 0x03FF] = value;
 	}
-	else if (0x3F00 <= address && address < 0x4000)
+	else
 	{
 		mPpuRef.writePaletteRam(address, value);
 	}
 }
 
+void MemoryNES::mapCpuPages()
+{
+	// CPU RAM, mirrored 4 times
+	for (u32 page = 0x00; page < 0x20; page++)
+	{
+		mCpuReadPages[page] = &mCpuRam[(page & 0x07) << 8];
+		mCpuWritePages[page] = &mCpuRam[(page & 0x07) << 8];
+	}
+
+	// PPU, APU & IO registers
+	for (u32 page = 0x20; page < 0x41; page++)
+	{
+		mCpuReadPages[page] = nullptr;
+		mCpuWritePages[page] = nullptr;
+	}
+
+	// Cartridge (depends on the mapper banks)
+	mCartridge.mapPrgPages(mCpuReadPages, mCpuWritePages);
+}
+
+void MemoryNES::mapPpuPages()
+{
+	// Pattern tables (depends on the mapper banks)
+	mCartridge.mapChrPages(mChrReadPages, mChrWritePages, mChrTileRowPages);
+
+	// Nametables (depends on the mapper mirroring)
+	std::array<u16, PPU_NT_COUNT> vramOffsets;
+	mCartridge.mapNametables(vramOffsets);
+	for (u32 ntIdx = 0; ntIdx < PPU_NT_COUNT; ntIdx++)
+		mNtPages[ntIdx] = &mPpuVram[vramOffsets[ntIdx]];
+}
+
 s32 MemoryNES::executeOamDma(bool isGetCycle)
 {
 	s32 elapsedCycles = 1;
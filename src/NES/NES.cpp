@@ -1,20 +1,24 @@
 #include "NES/NES.hpp"
 
+#include <algorithm>
+#include <cstdint>
+
 #include "NES/Toolbox.hpp"
 
 NES::NES(Controller& controller1, Controller& controller2, const std::string &romFilename)
-    : mMemory(romFilename, mApu, mPpu, controller1, controller2)
+    : mMemory(romFilename, *this, mApu, mPpu, controller1, controller2),
+      mBlipBuffer(CPU_FREQUENCY, BUFFER_SAMPLE_RATE, BLIP_BUFFER_CAPACITY)
 {
+	mRunAheadFrameCount = 0;
+	mIsRunningAhead = false;
+	mIsPictureAhead = false;
+	mIsFrameAheadRenderingSkipped = false;
+	mIsNextFrameRenderingSkipped = false;
+	mBandRenderingThreadCount = 0;
+
     // Power up == Reset
     reset();
 
-	mSoundFIFO    = soundFIFO_t(BUFFER_SIZE);
-	mP1FIFO       = soundFIFO_t(BUFFER_SIZE);
-	mP2FIFO       = soundFIFO_t(BUFFER_SIZE);
-	mTriangleFIFO = soundFIFO_t(BUFFER_SIZE);
-	mNoiseFIFO    = soundFIFO_t(BUFFER_SIZE);
-	mDmcFIFO      = soundFIFO_t(BUFFER_SIZE);
-
 	mMasterVolume = 1.0f;
 }
 
@@ -29,51 +33,214 @@ void NES::reset()
 	mCpuCyclesElapsed = mCpu.reset(mMemory);
 	mCpuCyclesPredicted = mCpuCyclesElapsed;
 
+	mPendingCpuCycles = mCpuCyclesElapsed;
+	mCpuCyclesToNextEvent = 0;
 
-	mDmcDmaExtraCycles = 0;
 	mIsDmaGetCycle = false;
-	mApuTimestamp = 0.0f;
-	mSoundSamplesCount = 0;
-	mIsUsingSoundBuffer0 = true;
-    mIsSoundBufferReady = false;
+	mApuSampleClock = 0;
+	mSoundTaps.clear();
+	mBlipBuffer.clear();
+	mBlipClock = 0;
+	mApuOutput = 0.0f;
+	mSoundSampleCount = 0;
+	mAreSoundSamplesReady = false;
 
 	mIsIrqSet = false;
 	mIsNmiSet = false;
 
 	// Run APU & PPU to keep up with CPU
-	runApu();
-	runPpu();
+	runPendingCycles();
 }
 
-void NES::runOneCpuInstruction()
+void NES::saveState(nesState_t& state) const
 {
-	// Run APU and PPU if they have to keep up
-	if (mCpuCyclesElapsed > mCpuCyclesPredicted)
+	state.cpu = mCpu;
+	state.apu = mApu;
+	mPpu.saveState(state.ppu);
+	mMemory.saveState(state.memory);
+
+	state.cpuCyclesPredicted = mCpuCyclesPredicted;
+	state.cpuCyclesElapsed = mCpuCyclesElapsed;
+	state.pendingCpuCycles = mPendingCpuCycles;
+	state.cpuCyclesToNextEvent = mCpuCyclesToNextEvent;
+	state.isDmaGetCycle = mIsDmaGetCycle;
+	state.isNmiSet = mIsNmiSet;
+	state.isIrqSet = mIsIrqSet;
+
+	mBlipBuffer.saveState(state.blipBuffer);
+	state.blipClock = mBlipClock;
+	state.apuOutput = mApuOutput;
+	state.apuSampleClock = mApuSampleClock;
+}
+
+void NES::loadState(const nesState_t& state)
+{
+	mCpu = state.cpu;
+	mApu = state.apu;
+	mPpu.loadState(state.ppu);
+	mMemory.loadState(state.memory);
+
+	mCpuCyclesPredicted = state.cpuCyclesPredicted;
+	mCpuCyclesElapsed = state.cpuCyclesElapsed;
+	mPendingCpuCycles = state.pendingCpuCycles;
+	mCpuCyclesToNextEvent = state.cpuCyclesToNextEvent;
+	mIsDmaGetCycle = state.isDmaGetCycle;
+	mIsNmiSet = state.isNmiSet;
+	mIsIrqSet = state.isIrqSet;
+
+	mBlipBuffer.loadState(state.blipBuffer);
+	mBlipClock = state.blipClock;
+	mApuOutput = state.apuOutput;
+	mApuSampleClock = state.apuSampleClock;
+}
+
+void NES::serializeState(std::vector<u8>& buffer)
+{
+	saveState(mSerializedState);
+	serializeNesState(mSerializedState, mMemory.getRomHash(), buffer);
+}
+
+bool NES::deserializeState(const std::vector<u8>& buffer)
+{
+	// The console is only loaded from a valid buffer
+	saveStateShape_t shape = { mMemory.getRomHash(), 
+	                           mMemory.getPrgRamSize(), 
+	                           mMemory.getChrRamSize(), 
+	                           mMemory.getMapperIdx(), 
+	                           mBlipBuffer.getDeltasSize(), 
+	                           mBlipBuffer.getSampleCapacity() };
+	// The fields that are not saved (ROM shape, tables) come from the console itself
+	saveState(mSerializedState);
+	if (!deserializeNesState(buffer, shape, mSerializedState))
+		return false;
+
+	loadState(mSerializedState);
+	return true;
+}
+
+void NES::runCpuBurst()
+{
+	// Run instructions until there is a picture or sound samples to process
+	do
+	{
+		runOneCpuInstruction();
+	} while (!isImageReady() && !mAreSoundSamplesReady);
+
+	// Run-ahead: the picture of the real frame is replaced by the one of the frames ahead
+	if (isImageReady())
+	{
+		mIsPictureAhead = mRunAheadFrameCount > 0;
+		if (mIsPictureAhead)
+			runAhead();
+	}
+}
+
+void NES::runAhead()
+{
+	// Real timeline: end of the frame & the samples the app has not taken yet
+	saveState(mRunAheadState);
+	u32 soundSampleCount = mSoundSampleCount;
+	mIsRunningAhead = true;
+
+	// Frames ahead, only the last one is rendered (unless the app skips it)
+	for (u32 frameIdx = 1; frameIdx <= mRunAheadFrameCount; frameIdx++)
 	{
-		mCpuCyclesPredicted = mCpuCyclesElapsed - mCpuCyclesPredicted;
-		runApu();
-		runPpu();
+		mPpu.setNextFrameRenderingSkipped(frameIdx < mRunAheadFrameCount || mIsNextFrameRenderingSkipped);
+		mPpu.clearIsImageReady();
+		do
+		{
+			runOneCpuInstruction();
+		} while (!isImageReady());
 	}
+	mIsFrameAheadRenderingSkipped = mPpu.isFrameRenderingSkipped();
+
+	// Back to the real timeline: its picture flag is set again, the picture ahead stays displayed,
+	// the sound of the frames ahead is dropped
+	loadState(mRunAheadState);
+	mIsRunningAhead = false;
+	mSoundSampleCount = soundSampleCount;
+	mAreSoundSamplesReady = soundSampleCount > 0;
+	applyRenderingSettings();
+}
+
+void NES::applyRenderingSettings()
+{
+	// Run-ahead: the real frames are never displayed & the picture ahead is needed right away
+	// (band rendering displays a frame one frame late)
+	bool isRunningAhead = mRunAheadFrameCount > 0;
+	mPpu.setNextFrameRenderingSkipped(mIsNextFrameRenderingSkipped || isRunningAhead);
+	mPpu.setBandRenderingThreadCount(isRunningAhead ? 0 : mBandRenderingThreadCount);
+}
+
+void NES::runOneCpuInstruction()
+{
+	// APU and PPU have to keep up with the cycles the previous instruction took
+	if (mCpuCyclesElapsed > mCpuCyclesPredicted)
+		mPendingCpuCycles += mCpuCyclesElapsed - mCpuCyclesPredicted;
+
+	// Catch up only when an event (NMI, IRQ, VBlank) may have occured
+	if (mPendingCpuCycles > mCpuCyclesToNextEvent)
+		runPendingCycles();
 
 	// Poll NMI/IRQ
 	pollIrqAndNmi();
 
 	// Predict CPU cycles to go 
 	mCpuCyclesPredicted = getCpuCyclesPrediction();
+	mPendingCpuCycles += mCpuCyclesPredicted;
 
-	// Run APU & PPU
-	runApu();
-	runPpu();
+	// Run APU & PPU right away when an event is imminent
+	// or during OAM DMA (alignment depends on the APU get/put cycle)
+	if (mCpuCyclesToNextEvent == 0 || mMemory.isOamDmaStarted())
+		runPendingCycles();
 
 	// Run CPU
 	runCpu();
 }
 
+void NES::runPendingCycles()
+{
+	if (mPendingCpuCycles == 0)
+		return;
+
+	// Cleared first: the APU & PPU may access the bus while running
+	s32 cpuCycles = mPendingCpuCycles;
+	mPendingCpuCycles = 0;
+
+	// Run APU & PPU
+	s32 dmcDmaExtraCycles = runApu(cpuCycles);
+	runPpu(cpuCycles + dmcDmaExtraCycles);
+
+	mCpuCyclesToNextEvent = getCpuCyclesToNextEvent();
+}
+
 s32 NES::getCpuCyclesPrediction()
 {
 	return mCpu.predictCyclesToRun(mMemory, mMemory.isOamDmaStarted(), mIsIrqSet, mIsNmiSet);
 }
 
+s32 NES::getCpuCyclesToNextEvent()
+{
+	// Keep the chips in lockstep while tracing, so that logs are interleaved
+	if (gIsTraceLogCpuEnabled || gIsTraceLogPpuEnabled || gIsTraceLogMMC3IrqEnabled)
+		return 0;
+
+	// Next VBlank (NMI & picture ready)
+	u32 ppuDots = mPpu.getDotsToVBlank();
+
+	// Next mapper IRQ (clocked by the PPU fetches)
+	if (mMemory.isCartridgeIrqEnabled())
+		ppuDots = std::min(ppuDots, mPpu.getDotsToRenderingFetches());
+
+	// Next APU IRQ (frame counter, DMC)
+	s32 cpuCycles = std::min((s32)(ppuDots / 3), mApu.getCpuCyclesToIrq());
+
+	// DMC DMA stalls the CPU while the APU & PPU keep running
+	cpuCycles -= mApu.getMaxDmcDmaExtraCycles(cpuCycles);
+
+	return std::max(cpuCycles, 0);
+}
+
 void NES::pollIrqAndNmi()
 {
 	mIsNmiSet = mPpu.getVBlankNMISignal();
@@ -82,45 +249,93 @@ void NES::pollIrqAndNmi()
 				mApu.getDMCIRQSignal();
 }
 
-void NES::runApu()
+s32 NES::runApu(s32 cpuCycles)
 {
-	mDmcDmaExtraCycles = 0;
-	for (int i = 0; i < mCpuCyclesPredicted + mDmcDmaExtraCycles; i++)
+	// Output changed by a register write
+	addApuOutputStep();
+
+	// Channel samples are only taken while a visualizer subscribes to them (real timeline only)
+	bool isChannelTapped = mSoundTaps.isAnyChannelSubscribed() && !mIsRunningAhead;
+
+	s32 dmcDmaExtraCycles = 0;
+	s32 cyclesDone = 0;
+	while (cyclesDone < cpuCycles + dmcDmaExtraCycles)
 	{
-		// Execute APU + get extra cycles due to DMC DMA
-		mIsDmaGetCycle = !mIsDmaGetCycle;
-		mDmcDmaExtraCycles += mApu.executeOneCpuCycle(mMemory, mIsDmaGetCycle);
+		// Channels run at once until their output changes, the next scope sample 
+		// or an APU event (frame counter step, DMC memory read)
+		s32 cyclesToNextSample = isChannelTapped ? (s32)((CPU_FREQUENCY - mApuSampleClock) / BUFFER_SAMPLE_RATE) + 1 : INT32_MAX;
+		s32 cycles = std::min({ cpuCycles + dmcDmaExtraCycles - cyclesDone, 
+		                        cyclesToNextSample, 
+		                        mApu.getCpuCyclesToOutputChange(), 
+		                        mApu.getIdleCpuCycles() });
+		if (cycles > 0)
+		{
+			mApu.executeIdleCpuCycles(cycles);
+			if ((cycles % 2) != 0)
+				mIsDmaGetCycle = !mIsDmaGetCycle;
+		}
+		else
+		{
+			// Execute APU + get extra cycles due to DMC DMA
+			cycles = 1;
+			mIsDmaGetCycle = !mIsDmaGetCycle;
+			dmcDmaExtraCycles += mApu.executeOneCpuCycle(mMemory, mIsDmaGetCycle);
+		}
+		cyclesDone += cycles;
+		mBlipClock += cycles;
+
+		// Output changes on the last cycle -> band-limited step
+		addApuOutputStep();
 
-		mApuTimestamp += TIME_PER_CYCLE;
-		if (mApuTimestamp > BUFFER_SAMPLE_PERIOD)
+		// Channel sample clock: CPU_FREQUENCY per sample, BUFFER_SAMPLE_RATE per CPU cycle
+		if (isChannelTapped)
 		{
-			// Get sample & substract sample period to time stamp
-			soundBufferF32_t* soundBuffer = mIsUsingSoundBuffer0 ? &mSoundBuffer0 : &mSoundBuffer1;
-			
-			float apuOutput = limitToInterval(mMasterVolume * mApu.getOutput(), 0.0f, 1.0f);
-			(*soundBuffer)[mSoundSamplesCount] = apuOutput;
-
-			// Get sample per channel (TODO: fix caches misses ?)
-			popAndPush(mSoundFIFO, apuOutput);
-			popAndPush(mP1FIFO, mApu.getPulse1Output());
-			popAndPush(mP2FIFO, mApu.getPulse2Output());
-			popAndPush(mTriangleFIFO, mApu.getTriangleOutput());
-			popAndPush(mNoiseFIFO, mApu.getNoiseOutput());
-			popAndPush(mDmcFIFO, mApu.getDMCOutput());
-
-			mSoundSamplesCount++;
-			mApuTimestamp -= BUFFER_SAMPLE_PERIOD;
-
-			// Prepare buffer to be sent to the sound manager
-			if (mSoundSamplesCount >= BUFFER_SIZE)
+			mApuSampleClock += cycles * BUFFER_SAMPLE_RATE;
+			if (mApuSampleClock > CPU_FREQUENCY)
 			{
-				mSoundSamplesCount = 0;
-				mIsUsingSoundBuffer0 = !mIsUsingSoundBuffer0;
-				mSoundBufferToSubmit = soundBuffer;
-                mIsSoundBufferReady = true;
+				mSoundTaps.push(SoundTap::PULSE1, mApu.getPulse1Output());
+				mSoundTaps.push(SoundTap::PULSE2, mApu.getPulse2Output());
+				mSoundTaps.push(SoundTap::TRIANGLE, mApu.getTriangleOutput());
+				mSoundTaps.push(SoundTap::NOISE, mApu.getNoiseOutput());
+				mSoundTaps.push(SoundTap::DMC, mApu.getDMCOutput());
+
+				mApuSampleClock -= CPU_FREQUENCY;
 			}
 		}
 	}
+
+	// Output samples are made by frames
+	if (mBlipClock >= SOUND_FRAME_CPU_CYCLES)
+		readSoundSamples();
+
+	return dmcDmaExtraCycles;
+}
+
+void NES::addApuOutputStep()
+{
+	float apuOutput = mApu.getOutput();
+	if (apuOutput != mApuOutput)
+	{
+		mBlipBuffer.addDelta(mBlipClock, apuOutput - mApuOutput);
+		mApuOutput = apuOutput;
+	}
+}
+
+void NES::readSoundSamples()
+{
+	mBlipBuffer.endFrame(mBlipClock);
+	mBlipClock = 0;
+
+	// Samples are appended to the ones the app has not taken yet
+	float* samples = &mSoundSamples[mSoundSampleCount];
+	u32 sampleCount = mBlipBuffer.readSamples(samples, BLIP_BUFFER_CAPACITY - mSoundSampleCount);
+	for (u32 i = 0; i < sampleCount; i++)
+		samples[i] = limitToInterval(mMasterVolume * samples[i], -1.0f, 1.0f);
+	if (mSoundTaps.isSubscribed(SoundTap::OUTPUT) && !mIsRunningAhead)
+		mSoundTaps.push(SoundTap::OUTPUT, samples, sampleCount);
+
+	mSoundSampleCount += sampleCount;
+	mAreSoundSamplesReady = mSoundSampleCount > 0;
 }
 
 void NES::runCpu()
@@ -133,7 +348,11 @@ void NES::runCpu()
 	else if(mIsNmiSet)
 	{
 		mCpuCyclesElapsed = mCpu.nmi(mMemory);
-		mPpu.clearNMISignal();	
+
+		// The PPU has to reach the NMI cycle before the signal is cleared
+		runPendingCycles();
+		mPpu.clearNMISignal();
+		invalidateNextEvent();
 	}
 	else if (mIsIrqSet)
 	{
@@ -148,9 +367,8 @@ void NES::runCpu()
 	}
 }
 
-void NES::runPpu()
+void NES::runPpu(s32 cpuCycles)
 {
 	// PPU
-	for (int i = 0; i < 3 * (mCpuCyclesPredicted + mDmcDmaExtraCycles); i++)
-		mPpu.executeOneCycle(mMemory);
+	mPpu.executeCycles(mMemory, 3 * cpuCycles);
 }
@@ -3,7 +3,18 @@
 #include <random>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include "NES/Toolbox.hpp"
+#include "NES/PPUBandRenderer.hpp"
+
+PPU::PPU()
+{
+    mDisplayedPicture = &mPicture;
+    mDisplayedIndexedPicture = &mIndexedPicture;
+    mFrameLog = nullptr;
+}
+
+PPU::~PPU() = default;
 
 void PPU::reset()
 {
@@ -12,6 +23,8 @@ void PPU::reset()
         for (auto& pixel : line)
             for (u8& color : pixel)
                 color = 0;
+    for (auto& line : mIndexedPicture)
+        line.fill(0);
 
     // Palette RAM reset
 	for (u32 i = 0; i < PALETTE_RAM_SIZE; i++)
@@ -20,6 +33,7 @@ void PPU::reset()
     // Registers reset
     mPpuCtrl    = 0b0000'0000;
     mPpuMask    = 0b0000'0000;
+    updatePaletteTables();
     mPpuStatus  = 0b1010'0000;
     mOamAddr    = 0b0000'0000;
     mPpuScrollX = 0b0000'0000; 
@@ -30,15 +44,21 @@ void PPU::reset()
     mW = 0;
     mV = 0;
 
-    mBgData = { 0, 0, 0, 0 };
-
-    mIsOddFrame = false;
+    mBgData = { 0, 0, 0 };
 
     mOamSpriteIdx = 0;
     mOamByteIdx = 0;
     mIsStoringOamSprite = false;
     mIsNextLineSprite0InRenderBuffer = false;
     mIsSprite0InRenderBuffer = false;
+    mSpriteLineBufferRow = SPRITE_LINE_BUFFER_INVALID;
+    mIsCompositionDeferred = false;
+    mIsFrameRenderingSkipped = false;
+    mIsNextFrameRenderingSkipped = false;
+    mIsFrameRenderingDeferred = false;
+    mFrameLog = nullptr;
+    mDisplayedPicture = &mPicture;
+    mDisplayedIndexedPicture = &mIndexedPicture;
 
     mVBlankNMISignal = false;
     mNMICanOccur = false;
@@ -50,20 +70,113 @@ void PPU::reset()
     mIsFirstPrerenderPassed = false;
 }
 
+void PPU::saveState(ppuState_t& state) const
+{
+    state.scanlineCount = mScanlineCount;
+    state.cycleCount = mCycleCount;
+    state.isFirstPrerenderPassed = mIsFirstPrerenderPassed;
+    state.isFrameRenderingSkipped = mIsFrameRenderingSkipped;
+    state.isImageReady = mIsImageReady;
+
+    state.ppuCtrl = mPpuCtrl;
+    state.ppuMask = mPpuMask;
+    state.ppuStatus = mPpuStatus;
+    state.oamAddr = mOamAddr;
+    state.oamData = mOamData;
+    state.ppuScrollX = mPpuScrollX;
+    state.ppuScrollY = mPpuScrollY;
+    state.ppuAddr = mPpuAddr;
+    state.ppuData = mPpuData;
+    state.v = mV;
+    state.t = mT;
+    state.x = mX;
+    state.w = mW;
+
+    state.bgNt = mBgData.nt;
+    state.bgAt = mBgData.at;
+    state.bgTileRow = mBgData.tileRow;
+    state.bgLinePixels = mBgLinePixels;
+    state.spriteLinePixels = mSpriteLinePixels;
+
+    state.oam = mOam;
+    state.oamSecondary = mOamSecondary;
+    state.spriteRenderBuffer = mSpriteRenderBuffer;
+    state.spritePatternBuffer = mSpritePatternBuffer;
+    state.oamTransfertBuffer = mOamTransfertBuffer;
+    state.oamSpriteIdx = mOamSpriteIdx;
+    state.oamByteIdx = mOamByteIdx;
+    state.secOamIdx = mSecOamIdx;
+    state.isStoringOamSprite = mIsStoringOamSprite;
+    state.isNextLineSprite0InRenderBuffer = mIsNextLineSprite0InRenderBuffer;
+    state.isSprite0InRenderBuffer = mIsSprite0InRenderBuffer;
+
+    state.paletteRam = mPaletteRam;
+
+    state.vBlankNMISignal = mVBlankNMISignal;
+    state.nmiCanOccur = mNMICanOccur;
+}
+
+void PPU::loadState(const ppuState_t& state)
+{
+    mScanlineCount = state.scanlineCount;
+    mCycleCount = state.cycleCount;
+    mIsFirstPrerenderPassed = state.isFirstPrerenderPassed;
+    mIsFrameRenderingSkipped = state.isFrameRenderingSkipped;
+    mIsImageReady = state.isImageReady;
+
+    mPpuCtrl = state.ppuCtrl;
+    mPpuMask = state.ppuMask;
+    mPpuStatus = state.ppuStatus;
+    mOamAddr = state.oamAddr;
+    mOamData = state.oamData;
+    mPpuScrollX = state.ppuScrollX;
+    mPpuScrollY = state.ppuScrollY;
+    mPpuAddr = state.ppuAddr;
+    mPpuData = state.ppuData;
+    mV = state.v;
+    mT = state.t;
+    mX = state.x;
+    mW = state.w;
+
+    mBgData = { state.bgNt, state.bgAt, state.bgTileRow };
+    mBgLinePixels = state.bgLinePixels;
+    mSpriteLinePixels = state.spriteLinePixels;
+
+    mOam = state.oam;
+    mOamSecondary = state.oamSecondary;
+    mSpriteRenderBuffer = state.spriteRenderBuffer;
+    mSpritePatternBuffer = state.spritePatternBuffer;
+    mOamTransfertBuffer = state.oamTransfertBuffer;
+    mOamSpriteIdx = state.oamSpriteIdx;
+    mOamByteIdx = state.oamByteIdx;
+    mSecOamIdx = state.secOamIdx;
+    mIsStoringOamSprite = state.isStoringOamSprite;
+    mIsNextLineSprite0InRenderBuffer = state.isNextLineSprite0InRenderBuffer;
+    mIsSprite0InRenderBuffer = state.isSprite0InRenderBuffer;
+
+    mPaletteRam = state.paletteRam;
+
+    mVBlankNMISignal = state.vBlankNMISignal;
+    mNMICanOccur = state.nmiCanOccur;
+
+    // Caches
+    updatePaletteTables();
+    mSpriteLineBufferRow = SPRITE_LINE_BUFFER_INVALID;
+
+    // The frame being logged is dropped: the emulation renders the rest of it
+    mFrameLog = nullptr;
+    mIsFrameRenderingDeferred = false;
+}
+
 void PPU::executeOneCycle(Memory &memory)
 {
     // Log PPU internals
     logPpu();
 
-    // Execute one cycle
-    if (mScanlineCount < 240)
-        executeVisibleScanline(memory);
-
-    else if (mScanlineCount < 261)
-        executeVBlankScanline();
-
-    else // if (mScanlineCount == 261)
-        executePreRenderScanline(memory);
+    // Execute one cycle (precomputed actions of the dot)
+    dotActions_t actions = getScanlineDotActions(mScanlineCount)[mCycleCount];
+    if (actions != 0)
+        executeDotActions(memory, actions);
 
     if (((mPpuCtrl & 0x80) != 0) && mNMICanOccur)
         mVBlankNMISignal = true;
@@ -80,6 +193,42 @@ void PPU::executeOneCycle(Memory &memory)
     }
 }
 
+void PPU::executeCycles(Memory &memory, u32 cycles)
+{
+    while (cycles > 0)
+    {
+        // Whole scanlines when possible, dot by dot otherwise
+        if (mCycleCount == 0 && cycles >= DOTS_PER_SCANLINE && canExecuteWholeScanline(memory))
+        {
+            executeWholeScanline(memory);
+            cycles -= DOTS_PER_SCANLINE;
+        }
+        else
+        {
+            executeOneCycle(memory);
+            cycles--;
+        }
+    }
+}
+
+u32 PPU::getDotsToVBlank() const
+{
+    // VBlank flag is set on scanline 241, dot 1
+    constexpr u32 VBLANK_DOT = 241 * DOTS_PER_SCANLINE + 1;
+    u32 currentDot = mScanlineCount * DOTS_PER_SCANLINE + mCycleCount;
+    return (VBLANK_DOT + DOTS_PER_FRAME - currentDot) % DOTS_PER_FRAME;
+}
+
+u32 PPU::getDotsToRenderingFetches() const
+{
+    // No memory fetch from post-render to the end of VBlank
+    if (mScanlineCount < 240 || mScanlineCount == 261)
+        return 0;
+
+    constexpr u32 PRE_RENDER_DOT = 261 * DOTS_PER_SCANLINE;
+    return PRE_RENDER_DOT - (mScanlineCount * DOTS_PER_SCANLINE + mCycleCount);
+}
+
 void PPU::writeRegister(Memory& memory, u16 address, u8 value)
 {
     switch (address)
@@ -97,6 +246,7 @@ void PPU::writeRegister(Memory& memory, u16 address, u8 value)
             if (!mIsFirstPrerenderPassed)
                 break;
             mPpuMask = value;
+            updatePaletteTables();
             break;
 
         case OAMADDR_CPU_ADDR:
@@ -218,6 +368,17 @@ void PPU::writePaletteRam(u16 address, u8 value)
     u16 paletteRamAddress = address;
     paletteRamAddress &= ((paletteRamAddress & 0x0003) == 0) ? 0x000F : 0x001F;
     mPaletteRam[paletteRamAddress] = value;
+    updatePaletteTables();
+
+    // Band rendering: next tiles use the new palette
+    if (mFrameLog != nullptr)
+    {
+        u32 firstTileIdx = (u32)mFrameLog->tiles.size();
+        if (mFrameLog->palettes.back().firstTileIdx != firstTileIdx)
+            mFrameLog->palettes.push_back({ firstTileIdx, mPaletteRam });
+        else
+            mFrameLog->palettes.back().paletteRam = mPaletteRam;
+    }
 }
 
 u8 PPU::readByte(Memory &memory, u16 address) 
@@ -225,154 +386,155 @@ u8 PPU::readByte(Memory &memory, u16 address)
     return memory.ppuRead(address, mCycleCount);
 }
 
+u64 PPU::readTileRow(Memory &memory, u16 address) 
+{
+    return memory.ppuReadTileRow(address, mCycleCount);
+}
+
 void PPU::writeByte(Memory &memory, u16 address, u8 value)
 {
     memory.ppuWrite(address, value, mCycleCount);
 }
 
-void PPU::executeVisibleScanline(Memory &memory)
+void PPU::executeDotActions(Memory& memory, dotActions_t actions)
 {
-    if (mCycleCount == 0)
-    {
-        // Dummy pattern table LSB fetch
-        u16 address = (((u16)(mPpuCtrl & 0b0001'0000) << 8) |
-                      ((u16)mBgData.nt << 4)                |
-                      ((mV & 0x7000) >> 12))                &
-                      0xFFF7; 
-        mBgData.ptLsb = readByte(memory, address);
-    }
-    else if ((1 <= mCycleCount && mCycleCount <= 256) || (321 <= mCycleCount && mCycleCount <= 336))
+    if ((actions & DOT_PRE_RENDER_START) != 0)
+        mIsFirstPrerenderPassed = true;
+
+    if ((actions & DOT_FRAME_START) != 0)
     {
-        // Get background pixels
-        processPixelData(memory);
-    
-        // Increment reg.v: Y
-        if (mCycleCount == 256)
-            incrementY();
+        mNMICanOccur = false;
+        mPpuStatus &= ~0b1110'0000;
+        mIsSprite0InRenderBuffer = false;
+        mIsNextLineSprite0InRenderBuffer = false;
+        mIsFrameRenderingSkipped = mIsNextFrameRenderingSkipped;
+        startFrameLog();
     }
-    else if (257 <= mCycleCount && mCycleCount <= 320)
-    {
-        if (mCycleCount == 257)
-        {
-            // Load temp horizontal address
-            loadX();
-        }
-        
-        mOamAddr = 0;
 
-        if (((mCycleCount % 2) == 0) && (((mCycleCount - 1) % 8) < 4))
-        {
-            u16 address = 0x2000 | (mV & 0x0FFF);
-            mBgData.nt = readByte(memory, address);
-        }
-    }
-    else if (mCycleCount > 336)
-    {
-        // Skip odd cycles
-        if (mCycleCount % 2 != 0)
-            return;
+    // Get background pixels
+    if ((actions & DOT_BG_FETCH_ACTIONS) != 0)
+        processPixelData(memory, actions);
 
-        // Dummy nametable fetches
-        u16 address = 0x2000 | (mV & 0x0FFF);
-        mBgData.nt = readByte(memory, address);
-    }
+    // Increment reg.v: Y
+    if ((actions & DOT_INC_Y) != 0)
+        incrementY();
 
-    processSpriteEvaluation(memory);
-}
+    // Load temp horizontal/vertical address
+    if ((actions & DOT_COPY_X) != 0)
+        loadX();
+    if ((actions & DOT_COPY_Y) != 0)
+        loadY();
+
+    if ((actions & DOT_RESET_OAM_ADDR) != 0)
+        mOamAddr = 0;
+
+    if ((actions & DOT_SPRITE_ACTIONS) != 0)
+        processSpriteEvaluation(memory, actions);
 
-void PPU::executeVBlankScanline()
-{
     // Set VBlank flag & NMI
-    if (mScanlineCount == 241 && mCycleCount == 1)
+    if ((actions & DOT_VBLANK_START) != 0)
     {
         mNMICanOccur = true;
         mIsImageReady = true;
         mPpuStatus |= 0b1000'0000;
+
+        // Band rendering: the frame is rendered by the workers, the previous one is displayed
+        if (mFrameLog != nullptr)
+            submitFrameLog();
     }
 }
 
-void PPU::executePreRenderScanline(Memory &memory)
+bool PPU::canExecuteWholeScanline(const Memory& memory) const
 {
-    mIsFirstPrerenderPassed = true;
-    if (mCycleCount == 1)
-    {
-        mNMICanOccur = false;
-        mPpuStatus &= ~0b1110'0000;
-        mIsSprite0InRenderBuffer = false;
-        mIsNextLineSprite0InRenderBuffer = false;
-    }
-    
-    if (1 <= mCycleCount && mCycleCount <= 256)
-    {
-        // Dummy scanline fetches
-        processPixelData(memory);
+    // The pre-render scanline is run dot by dot (flags cleared, Y copied)
+    if (mScanlineCount == 261)
+        return false;
 
-        // Increment reg.v: Y
-        if (mCycleCount == 256)
-            incrementY();
-    }
-    else if (mCycleCount == 257)
-    {
-        loadX();
-    }
-    else if (280 <= mCycleCount && mCycleCount <= 304)
+    // CPU accesses to the PPU catch it up first, so nothing can change
+    // during the scanline... except for mappers watching the PPU bus 
+    // (accesses are not made in the hardware order). Logs are made per dot.
+    return !memory.isCartridgeMonitoringPpuBus() && !gIsTraceLogPpuEnabled;
+}
+
+void PPU::executeWholeScanline(Memory& memory)
+{
+    // Same result as 341 calls to executeOneCycle (from dot 0)
+    if (mScanlineCount < 240)
     {
-        loadY();
+        executeWholeVisibleScanline(memory);
     }
-    else if (321 <= mCycleCount && mCycleCount <= 336)
+    else if (mScanlineCount == 241)
     {
-        // Get background pixels
-        processPixelData(memory);
+        mCycleCount = 1;
+        executeDotActions(memory, DOT_VBLANK_START);
     }
-    else if (mCycleCount > 336)
-    {
-        // Skip odd cycles
-        if (mCycleCount % 2 != 0)
-            return;
 
-        // Dummy nametable fetches
-        u16 address = 0x2000 | (mV & 0x0FFF);
-        mBgData.nt = readByte(memory, address);
-    }
+    if (((mPpuCtrl & 0x80) != 0) && mNMICanOccur)
+        mVBlankNMISignal = true;
 
-    if (mCycleCount == 339)
-    {
-        if (mIsOddFrame && ((mPpuMask & 0b0001'1000) != 0))
-            mCycleCount++;
+    // Next scanline
+    mCycleCount = 0;
+    mScanlineCount++;
+}
 
-        mIsOddFrame = !mIsOddFrame;
-    }
+void PPU::executeWholeVisibleScanline(Memory& memory)
+{
+    const scanlineDotActions_t& dotActions = getScanlineDotActions(mScanlineCount);
 
-    if (257 <= mCycleCount && mCycleCount <= 320)
+    // Dot 0: dummy pattern table LSB fetch & sprite evaluation reset
+    mCycleCount = 0;
+    executeDotActions(memory, dotActions[0]);
+
+    // Dots 1-64: clear secondary OAM
+    mOamSecondary.fill(0xFF);
+
+    // Dots 65-256: sprite evaluation (secondary OAM is not used by the rendering)
+    for (mCycleCount = 65; mCycleCount <= 256; mCycleCount++)
+        processSpriteEvaluation(memory, dotActions[mCycleCount]);
+
+    // Dots 1-256: background fetches & rendering (odd dots do nothing)
+    // The pixels are composited at once (first ones were drawn by the previous scanline)
+    mIsCompositionDeferred = true;
+    for (mCycleCount = 2; mCycleCount <= 256; mCycleCount += 2)
+        processPixelData(memory, dotActions[mCycleCount]);
+    mIsCompositionDeferred = false;
+    if (isPictureRenderedByEmulation())
+        composeLinePixels(mScanlineCount, 16 - mX, PPU_OUTPUT_WIDTH);
+    incrementY();
+
+    // Dots 257-320: sprite fetches & garbage nametable fetches (odd dots do nothing but at 257)
+    mCycleCount = 257;
+    loadX();
+    processSpriteEvaluation(memory, dotActions[mCycleCount]);
+    for (mCycleCount = 258; mCycleCount <= 320; mCycleCount += 2)
     {
-        mOamAddr = 0;
-
-        if (((mCycleCount % 2) == 0) && (((mCycleCount - 1) % 8) < 4))
-        {
-            u16 address = 0x2000 | (mV & 0x0FFF);
-            mBgData.nt = readByte(memory, address);
-        }
+        if ((dotActions[mCycleCount] & DOT_FETCH_NT) != 0)
+            mBgData.nt = readByte(memory, 0x2000 | (mV & 0x0FFF));
+        else
+            processSpriteEvaluation(memory, dotActions[mCycleCount]);
     }
+    mOamAddr = 0;
 
-    processSpriteEvaluation(memory);
+    // Dots 321-336: first two tiles of the next scanline
+    for (mCycleCount = 322; mCycleCount <= 336; mCycleCount += 2)
+        processPixelData(memory, dotActions[mCycleCount]);
+
+    // Dots 337-340: dummy nametable fetches
+    mBgData.nt = readByte(memory, 0x2000 | (mV & 0x0FFF));
 }
 
-void PPU::processPixelData(Memory& memory)
+void PPU::processPixelData(Memory& memory, dotActions_t actions)
 {
     // Fetch background data
     // (HW use two cycles but emulation will just fake it)
-    if (((mCycleCount - 1) % 2) == 0)
-        return;
-
     u16 address;
-    u8 fetchCycle = (mCycleCount - 1) % 8;
-    if (fetchCycle < 2)
+    if ((actions & DOT_FETCH_NT) != 0)
     {
         // Get Nametable byte (aka tile index)
         address = 0x2000 | (mV & 0x0FFF);
         mBgData.nt = readByte(memory, address);
     }
-    else if (fetchCycle < 4)
+    else if ((actions & DOT_FETCH_AT) != 0)
     {
         // Get Attribute table byte (aka palettes indices)
         // reg.v is:      yyy'NNYY'YYYX'XXXX
@@ -380,7 +542,7 @@ void PPU::processPixelData(Memory& memory)
         address = 0x23C0 | (mV & 0x0C00) | ((mV >> 4) & 0x0038) | ((mV >> 2) & 0x0007);
         mBgData.at = readByte(memory, address);
     }
-    else if (fetchCycle < 6)
+    else if ((actions & DOT_FETCH_PT_LO) != 0)
     {
         // Get tile LSB
         // Tile address is: H'NNNN'NNNN'0yyy
@@ -388,9 +550,9 @@ void PPU::processPixelData(Memory& memory)
                   ((u16)mBgData.nt << 4)                |
                   ((mV & 0x7000) >> 12))                &
                   0xFFF7; 
-        mBgData.ptLsb = readByte(memory, address);
+        mBgData.tileRow = readTileRow(memory, address);
     }
-    else
+    else if ((actions & DOT_FETCH_PT_HI) != 0)
     {
         // Get tile MSB
         // Tile address is: H'NNNN'NNNN'1yyy
@@ -398,101 +560,21 @@ void PPU::processPixelData(Memory& memory)
                   ((u16)mBgData.nt << 4)               |
                   ((mV & 0x7000) >> 12)                |
                   0x0008; 
-        mBgData.ptMsb = readByte(memory, address);
+        mBgData.tileRow |= readTileRow(memory, address);
 
         // Update picture color (background & sprites)
-        // For each pixel:
-        // Get color index (using pattern table bytes)
-        // Get Palette (using AT byte & reg.v)
-        // Get color code = palette[color_index]
-        // Calculate real color
-        // Magic (I hope...)
-        for (u8 i = 0; i < 8; i++)
-        {
-            if (248 < mCycleCount && mCycleCount <= 256)
-                // Unused tile fetch
-                break;
-
-            if (mScanlineCount == 239 && mCycleCount > 256)
-                // Unused tile fetch
-                break;
-            
-            u16 row = 0;
-            if (mScanlineCount != 261)
-                row = mCycleCount > 256 ? mScanlineCount + 1 : mScanlineCount;
-            u16 col = i + (mCycleCount > 256 ? mCycleCount - 321 - 7 : mCycleCount + 8) - mX;
-
-            bool hasSpritePriority = false;
-            u16 bgColorAddress = getColorAddressFromBGData(i, col);
-            u16 spriteColorAddress = getColorAddressFromSecOam((u8)col, (u8)row, hasSpritePriority);
-
-            // Sprite 0 hit
-            if (!(((mPpuMask & 0b0001'1000) != 0b0001'1000) ||
-                  (col < 8 && ((mPpuMask & 0b0000'0110) != 0b0000'0110)) ||
-                  (col == 255)))
-            {
-                // Sprite 0 hit is possible
-                u16 sprite0ColorAddress;
-                bool isSprite0Detected = isSprite0OnPixel((u8)col, (u8)row, sprite0ColorAddress);
-                if (isSprite0Detected)
-                {
-                    // Check BG presence
-                    if ((bgColorAddress & 0x0003) != 0)
-                    {
-                        // Sprite 0 hit detected
-                        mPpuStatus |= 0b0100'0000;
-                    }
-                }
-            }
-
-            u16 colorAddress = 0x3F00;
-            if (((bgColorAddress | spriteColorAddress) & 0x0003) == 0)
-            {
-                // No BG or sprite color -> Backdrop color
-                colorAddress = 0x3F00;
-            }
-            else if ((bgColorAddress & 0x0003) == 0)
-            {
-                // No BG color -> Sprite color
-                colorAddress = spriteColorAddress;
-            }
-            else if ((spriteColorAddress & 0x0003) == 0)
-            {
-                // No sprite color -> BG color
-                colorAddress = bgColorAddress;
-            }
-            else 
-            {
-                // BG & sprite have a color
-                if (hasSpritePriority)
-                {
-                    // Sprite has priority over BG -> Sprite color
-                    colorAddress = spriteColorAddress;
-                }
-                else
-                {
-                    // BG has priority over sprite -> BG color
-                    colorAddress = bgColorAddress;
-                }
-            }
-
-            u8 colorCode = readPaletteRam(colorAddress);
-            setPictureColor(colorCode, row, col);
-        }
+        if ((actions & DOT_RENDER_TILE) != 0)
+            renderTilePixels();
 
         // Increment reg.v: Coarse X 
-        incrementCoarseX();
+        if ((actions & DOT_INC_X) != 0)
+            incrementCoarseX();
     }
 }
 
-void PPU::processSpriteEvaluation(Memory &memory)
+void PPU::processSpriteEvaluation(Memory &memory, dotActions_t actions)
 {
-    // No sprite evaluation in pre-render scanline
-    if ((mCycleCount < 257) && (mScanlineCount == 261))
-        return;
-     
-    bool isOddCycle = (mCycleCount % 2) == 1;
-    if (mCycleCount == 0)
+    if ((actions & DOT_SPRITE_RESET) != 0)
     {
         // Reset counters
         mSecOamIdx = 0;
@@ -501,22 +583,19 @@ void PPU::processSpriteEvaluation(Memory &memory)
         mIsStoringOamSprite = false;
         mIsNextLineSprite0InRenderBuffer = false;
     }
-    else if (1 <= mCycleCount && mCycleCount <= 64)
+    else if ((actions & DOT_SPRITE_CLEAR) != 0)
     {
         // Clear secondary OAM
-        if (!isOddCycle)
-            return;
-        
         u8 soamIdx = (u8)mCycleCount / 2;
         mOamSecondary[soamIdx] = 0xFF;
     }
-    else if (65 <= mCycleCount && mCycleCount <= 256)
+    else if ((actions & (DOT_SPRITE_EVAL_READ | DOT_SPRITE_EVAL_WRITE)) != 0)
     {
         if (mOamSpriteIdx == 64)
             // No reading or writing if all sprites are read
             return;
 
-        if (isOddCycle)
+        if ((actions & DOT_SPRITE_EVAL_READ) != 0)
         {
             // Read from primary OAM
             u8 oamIdx = 4 * mOamSpriteIdx + mOamByteIdx;
@@ -601,27 +680,22 @@ void PPU::processSpriteEvaluation(Memory &memory)
             }
         }
     }
-    else if (257 <= mCycleCount && mCycleCount <= 320)
+    else if ((actions & (DOT_SPRITE_LOAD | DOT_SPRITE_FETCH)) != 0)
     {
-        if (mCycleCount == 257)
+        if ((actions & DOT_SPRITE_LOAD) != 0)
         {
             mIsSprite0InRenderBuffer = mIsNextLineSprite0InRenderBuffer;
             mSpriteRenderBuffer = mOamSecondary;
+            mSpriteLineBufferRow = SPRITE_LINE_BUFFER_INVALID;
+            mIsSpriteRecordOutdated = true;
         }
 
-        mOamAddr = 0;
-
-        // Fetch Sprite patterns
-        // Skip odd cycles
-        if (isOddCycle)
+        // Fetch Sprite patterns (dummy fetches are garbage nametable fetches)
+        if ((actions & DOT_SPRITE_FETCH) == 0)
             return;
         
         u16 spriteCycleCount = mCycleCount - 257;
 
-        // Skip dummy fetches
-        if ((spriteCycleCount % 8) < 4)
-            return;
-        
         // Calculate pattern buffer index
         u16 patternBufferIdx = 2 * (spriteCycleCount / 8) + ((spriteCycleCount % 4) / 2);
 
@@ -655,162 +729,310 @@ void PPU::processSpriteEvaluation(Memory &memory)
         else
             address |= ((spriteYPos & 0b0000'1000) << 1) | (spriteYPos & 0b0000'0111); 
         
-        // Get pattern table byte
-        u8 spritePattern = ((patternBufferIdx % 2) == 0) ?
-                           readByte(memory, address) :
-                           readByte(memory, address | 0b0000'0000'0000'1000);
-        mSpritePatternBuffer[patternBufferIdx] = spritePattern;
+        // Get pattern table byte (as a decoded tile row plane, horizontal flip included)
+        u64 spritePattern = ((patternBufferIdx % 2) == 0) ?
+                            readTileRow(memory, address) :
+                            readTileRow(memory, address | 0b0000'0000'0000'1000);
+        if ((attribute & 0b0100'0000) != 0)
+            spritePattern = flipTileRow(spritePattern);
+
+        if ((patternBufferIdx % 2) == 0)
+            mSpritePatternBuffer[patternBufferIdx / 2] = spritePattern;
+        else
+            mSpritePatternBuffer[patternBufferIdx / 2] |= spritePattern;
+        mIsSpriteRecordOutdated = true;
+
+        // All patterns fetched: composite the sprites of the next scanline
+        // (only needed by sprite 0 hit when the picture is not rendered here)
+        bool isSpriteLineBufferUsed = isPictureRenderedByEmulation() || mIsSprite0InRenderBuffer;
+        if (patternBufferIdx == 15 && isSpriteLineBufferUsed)
+            buildSpriteLineBuffer(mScanlineCount == 261 ? 0 : (u8)(mScanlineCount + 1));
     }
 }
 
-void PPU::setPictureColor(u8 colorCode, u16 row, u16 col) 
+void PPU::renderTilePixels()
 {
-    if (col >= PPU_OUTPUT_WIDTH)
+    // For each pixel:
+    // Get BG color address (using pattern, AT byte & reg.v)
+    // Get sprite pixel (using sprite line buffer)
+    // Detect sprite 0 hit
+    // Then BG/sprite priority & palette lookup are done on the whole run of pixels
+    u16 row = 0;
+    if (mScanlineCount != 261)
+        row = mCycleCount > 256 ? mScanlineCount + 1 : mScanlineCount;
+    s32 firstCol = (mCycleCount > 256 ? mCycleCount - 321 - 7 : mCycleCount + 8) - mX;
+
+    // Band rendering: the tile is rendered later by the workers
+    if (mFrameLog != nullptr)
+        recordTile(row, firstCol);
+
+    // Render skip (or band rendering): only sprite 0 hit affects the emulation
+    if (!isPictureRenderedByEmulation() && !mIsSprite0InRenderBuffer)
         return;
 
-    mPicture[row][col][0] = LUT[colorCode][0];
-    mPicture[row][col][1] = LUT[colorCode][1];
-    mPicture[row][col][2] = LUT[colorCode][2];
+    for (u8 i = 0; i < 8; i++)
+    {
+        u16 col = (u16)(firstCol + i);
+
+        u8 bgPixel = getBgPixel(mBgData.tileRow, mBgData.at, mV, mPpuMask, i, col);
+        u8 spritePixel = getSpritePixel((u8)col, (u8)row);
+
+        // Sprite 0 hit
+        if (!(((mPpuMask & 0b0001'1000) != 0b0001'1000) ||
+              (col < 8 && ((mPpuMask & 0b0000'0110) != 0b0000'0110)) ||
+              (col == 255)))
+        {
+            // Sprite 0 hit is possible
+            bool isSprite0Detected = mIsSprite0InRenderBuffer && ((spritePixel & SPRITE_PIXEL_SPRITE_0) != 0);
+            if (isSprite0Detected)
+            {
+                // Check BG presence
+                if ((bgPixel & 0x03) != 0)
+                {
+                    // Sprite 0 hit detected
+                    mPpuStatus |= 0b0100'0000;
+                }
+            }
+        }
+
+        if (col < PPU_OUTPUT_WIDTH)
+        {
+            mBgLinePixels[col] = bgPixel;
+            mSpriteLinePixels[col] = spritePixel;
+        }
+    }
+
+    // Pixels out of the picture are not drawn
+    s32 colStart = std::max(firstCol, 0);
+    s32 colEnd = std::min(firstCol + 8, (s32)PPU_OUTPUT_WIDTH);
+    if (!mIsCompositionDeferred && isPictureRenderedByEmulation() && colStart < colEnd)
+        composeLinePixels(row, (u16)colStart, (u16)colEnd);
 }
 
-u16 PPU::getColorAddressFromBGData(u8 xIdx, u16 pixelX)
+void PPU::composeLinePixels(u16 row, u16 colStart, u16 colEnd)
+{
+    if (mPictureFormat == PictureFormat::INDEXED)
+    {
+        // Palette & emphasis are applied by the GPU
+        mPixelCompositor.composeIndexedPixels(&mBgLinePixels[colStart], 
+                                              &mSpriteLinePixels[colStart], 
+                                              colEnd - colStart, 
+                                              mPaletteColorCodes, 
+                                              getEmphasisBits(mPpuMask), 
+                                              &mIndexedPicture[row][colStart]);
+        return;
+    }
+
+    mPixelCompositor.composePixels(&mBgLinePixels[colStart], 
+                                   &mSpriteLinePixels[colStart], 
+                                   colEnd - colStart, 
+                                   mPaletteRgb, 
+                                   mPicture[row][colStart].data());
+}
+
+void PPU::updatePaletteTables()
+{
+    computePaletteTables(mPaletteRam, mPpuMask, mPaletteRgb, mPaletteColorCodes);
+}
+
+void PPU::computePaletteTables(const paletteRam_t& paletteRam, u8 mask, paletteRgb_t& paletteRgb, paletteColorCodes_t& colorCodes)
+{
+    // Grayscale keeps the gray column of the palette
+    u8 colorCodeMask = ((mask & 0b0000'0001) != 0) ? 0x30 : 0x3F;
+    for (u16 paletteAddress = 0; paletteAddress < PALETTE_ENTRIES; paletteAddress++)
+    {
+        // Backdrop mirrors ($3F10/$3F14/$3F18/$3F1C)
+        u16 paletteRamAddress = paletteAddress & (((paletteAddress & 0x0003) == 0) ? 0x000F : 0x001F);
+        u8 colorCode = paletteRam[paletteRamAddress] & 0x3F;
+        paletteRgb[0][paletteAddress] = LUT[colorCode][0];
+        paletteRgb[1][paletteAddress] = LUT[colorCode][1];
+        paletteRgb[2][paletteAddress] = LUT[colorCode][2];
+        colorCodes[paletteAddress] = colorCode & colorCodeMask;
+    }
+}
+
+u8 PPU::getBgPixel(u64 tileRow, u8 at, u16 v, u8 mask, u8 xIdx, u16 pixelX)
 {
     // Return EXT input if leftmost 8 pixels and PPUMASK.1 == 0
-    if ((pixelX < 8) && ((mPpuMask & 0b0000'0010) == 0))
-        return 0x3F00;
+    if ((pixelX < 8) && ((mask & 0b0000'0010) == 0))
+        return 0x00;
+
+    // BG Rendering disabled
+    if ((mask & 0b0000'1000) == 0)
+        return 0x00;
 
     // Get 2 bits color index using pattern table byte
-    u8 colorIdx = getColorIndexFromPattern(mBgData.ptLsb, mBgData.ptMsb, xIdx);
+    u8 colorIdx = getColorIndexFromPattern(tileRow, xIdx);
 
     // Calculate Palette number (which palette is used)
-    bool isRightTile  = (mV & 0b0000'0000'0000'0010) != 0;
-    bool isBottomTile = (mV & 0b0000'0000'0100'0000) != 0;
+    bool isRightTile  = (v & 0b0000'0000'0000'0010) != 0;
+    bool isBottomTile = (v & 0b0000'0000'0100'0000) != 0;
 
     u8 paletteNumber;
     if (!(isRightTile || isBottomTile))
-        paletteNumber = mBgData.at & 0b0000'0011;                
+        paletteNumber = at & 0b0000'0011;                
 
     else if (isRightTile && !isBottomTile)
-        paletteNumber = (mBgData.at & 0b0000'1100) >> 2;                
+        paletteNumber = (at & 0b0000'1100) >> 2;                
         
     else if (!isRightTile && isBottomTile)
-        paletteNumber = (mBgData.at & 0b0011'0000) >> 4;                
+        paletteNumber = (at & 0b0011'0000) >> 4;                
 
     else
-        paletteNumber = (mBgData.at & 0b1100'0000) >> 6;                
-
-    // Get color (in palette) address -> Get color code -> Set pixel color
-    u16 colorAddress = 0x3F00; 
-    if ((mPpuMask & 0b0000'1000) != 0)
-        // BG Rendering Enable
-        colorAddress |= (paletteNumber << 2) | colorIdx;
+        paletteNumber = (at & 0b1100'0000) >> 6;                
 
-    return colorAddress;
+    // Color (in palette) address: 0000'PPCC
+    return (paletteNumber << 2) | colorIdx;
 }
 
-u16 PPU::getColorAddressFromSecOam(u16 pixelXPos, u16 pixelYPos, bool& hasSpritePriority)
+u8 PPU::getSpritePixel(u8 pixelXPos, u8 pixelYPos)
 {
     // Return EXT input when no rendering
     if ((mPpuMask & 0b0001'0000) == 0)
-        return 0x3F00;
-        
-    oamData sprite;
-    u8 ptLsb;
-    u8 ptMsb;
-    for (u8 spriteIdx = 0; spriteIdx < 8; spriteIdx++)
-    {
-        sprite.yPos      = mSpriteRenderBuffer[spriteIdx * 4 + 0];
-        sprite.tileIdx   = mSpriteRenderBuffer[spriteIdx * 4 + 1];
-        sprite.attribute = mSpriteRenderBuffer[spriteIdx * 4 + 2];
-        sprite.xPos      = mSpriteRenderBuffer[spriteIdx * 4 + 3];
-        ptLsb = mSpritePatternBuffer[spriteIdx * 2];
-        ptMsb = mSpritePatternBuffer[spriteIdx * 2 + 1];
-
-        u16 colorAddress = getColorAddressFromSprite(sprite, ptLsb, ptMsb, pixelXPos, pixelYPos, hasSpritePriority);
-        if (colorAddress == SPRITE_NOT_IN_RANGE)
-            continue;
+        return 0;
 
-        if ((colorAddress & 0x0003) == 0)
-            // Sprite pixel is transparent
-            continue;
-        
-        return colorAddress;
-    }
+    // Return EXT input if leftmost 8 pixels and PPUMASK.2 == 0
+    if ((pixelXPos < 8) && ((mPpuMask & 0b0000'0100) == 0))
+        return 0;
+
+    // Rebuild if another row is rendered or the sprite height changed since the fetches
+    u8 spriteHeight = getSpriteHeight(mPpuCtrl);
+    if (pixelYPos != mSpriteLineBufferRow || spriteHeight != mSpriteLineBufferHeight)
+        buildSpriteLineBuffer(pixelYPos);
 
-    return 0x3F00;
+    return mSpriteLineBuffer[pixelXPos];
 }
 
-u16 PPU::getColorAddressFromSprite(oamData sprite, u8 ptLsb, u8 ptMsb, u16 pixelXPos, u16 pixelYPos, bool &hasSpritePriority)
+void PPU::buildSpriteLineBuffer(u8 pixelYPos)
 {
-    // Return EXT input if leftmost 8 pixels and PPUMASK.2 == 0
-    if ((pixelXPos < 8) && ((mPpuMask & 0b0000'0100) == 0))
-        return 0x3F00;
-
-    u8 spriteHeight = ((mPpuCtrl & 0b0010'0000) == 0) ? 8 : 16;
-    u16 yPos = sprite.yPos + 1;
-    if (!(yPos <= pixelYPos && pixelYPos < yPos + spriteHeight))
-        return SPRITE_NOT_IN_RANGE;
+    u8 spriteHeight = getSpriteHeight(mPpuCtrl);
+    buildSpriteLineBuffer(mSpriteLineBuffer, mSpriteRenderBuffer, mSpritePatternBuffer, spriteHeight, pixelYPos);
 
-    // Sprite is rendered on this scanline
-    u8 spriteXPos = sprite.xPos;
+    mSpriteLineBufferRow = pixelYPos;
+    mSpriteLineBufferHeight = spriteHeight;
+}
 
-    if (!(spriteXPos <= pixelXPos && pixelXPos < spriteXPos + 8))
-        return SPRITE_NOT_IN_RANGE;
+void PPU::buildSpriteLineBuffer(spriteLineBuffer_t& lineBuffer, 
+                                const spriteRenderBuffer_t& renderBuffer, 
+                                const spritePatternBuffer_t& patternBuffer, 
+                                u8 spriteHeight, 
+                                u8 pixelYPos)
+{
+    lineBuffer.fill(0);
     
-    // Sprite is render on this pixel
-    u8 attribute  = sprite.attribute;
+    for (u8 spriteIdx = 0; spriteIdx < 8; spriteIdx++)
+    {
+        u8 yPos      = renderBuffer[spriteIdx * 4 + 0];
+        u8 attribute = renderBuffer[spriteIdx * 4 + 2];
+        u8 xPos      = renderBuffer[spriteIdx * 4 + 3];
 
-    // Get sprite priority
-    hasSpritePriority = (attribute & 0b0010'0000) == 0;
+        // Sprite is rendered on this scanline
+        u16 spriteYPos = yPos + 1;
+        if (!(spriteYPos <= pixelYPos && pixelYPos < spriteYPos + spriteHeight))
+            continue;
 
-    u8 xIdx = (u8)(pixelXPos - spriteXPos);
+        // Palette & priority
+        u8 spritePixel = 0x10 | ((attribute & 0b0000'0011) << 2);
+        if ((attribute & 0b0010'0000) != 0)
+            spritePixel |= SPRITE_PIXEL_BEHIND_BG;
+        if (spriteIdx == 0)
+            spritePixel |= SPRITE_PIXEL_SPRITE_0;
 
-    // Horizontal flip
-    if ((attribute & 0b0100'0000) != 0)
-        xIdx = 7 - xIdx;
+        // First opaque sprite (lowest index) wins the pixel
+        u64 tileRow = patternBuffer[spriteIdx];
+        for (u16 xIdx = 0; xIdx < 8 && (xPos + xIdx) < PPU_OUTPUT_WIDTH; xIdx++)
+        {
+            u8 colorIdx = getColorIndexFromPattern(tileRow, (u8)xIdx);
+            u8& linePixel = lineBuffer[xPos + xIdx];
+            if (colorIdx != 0 && linePixel == 0)
+                linePixel = spritePixel | colorIdx;
+        }
+    }
+}
 
-    u8 colorIdx = getColorIndexFromPattern(ptLsb, ptMsb, xIdx);
+void PPU::startFrameLog()
+{
+    // Thread count changed: new workers (the in-flight frame is dropped)
+    u32 threadCount = mBandRenderer ? mBandRenderer->getThreadCount() : 0;
+    if (threadCount != mBandRenderingThreadCount)
+    {
+        mBandRenderer.reset();
+        if (mBandRenderingThreadCount > 0)
+            mBandRenderer = std::make_unique<PPUBandRenderer>(mBandRenderingThreadCount, mPicture, mIndexedPicture);
+
+        mDisplayedPicture = &mPicture;
+        mDisplayedIndexedPicture = &mIndexedPicture;
+    }
 
-    // Palette 
-    u8 paletteNumber = attribute & 0b0000'0011;
+    // Skipped frames are not rendered at all
+    mIsFrameRenderingDeferred = mBandRenderer && !mIsFrameRenderingSkipped;
+    if (!mIsFrameRenderingDeferred)
+    {
+        mFrameLog = nullptr;
+        if (!mIsFrameRenderingSkipped)
+        {
+            mDisplayedPicture = &mPicture;
+            mDisplayedIndexedPicture = &mIndexedPicture;
+        }
+        return;
+    }
 
-    return 0x3F10 | (paletteNumber << 2) | colorIdx; 
+    mFrameLog = &mBandRenderer->getRecordingLog();
+    mFrameLog->pictureFormat = mPictureFormat;
+    mFrameLog->tiles.clear();
+    mFrameLog->sprites.clear();
+    mFrameLog->palettes.clear();
+    mFrameLog->palettes.push_back({ 0, mPaletteRam });
+    mFrameLogNextRow = 0;
+    mIsSpriteRecordOutdated = true;
 }
 
-u8 PPU::getColorIndexFromPattern(u8 ptLsb, u8 ptMsb, u8 xIdx)
+void PPU::recordTile(u16 row, s32 firstCol)
 {
-    u8 colorIdx;
-    if (xIdx != 7)
-        colorIdx = (ptMsb & (1 << (7 - xIdx))) >> (7 - xIdx - 1) | (ptLsb & (1 << (7 - xIdx))) >> (7 - xIdx);
-    else
-        colorIdx = (ptMsb & 1) << 1 | (ptLsb & 1);
+    // First tile of the rows
+    u32 tileIdx = (u32)mFrameLog->tiles.size();
+    for (; mFrameLogNextRow <= row; mFrameLogNextRow++)
+        mFrameLog->rowFirstTileIdx[mFrameLogNextRow] = tileIdx;
 
-    return colorIdx;
+    // Sprites changed since the last tile
+    if (mIsSpriteRecordOutdated)
+    {
+        mFrameLog->sprites.push_back({ mSpriteRenderBuffer, mSpritePatternBuffer });
+        mIsSpriteRecordOutdated = false;
+    }
+
+    PPUTileRecord tile;
+    tile.tileRow = mBgData.tileRow;
+    tile.v = mV;
+    tile.firstCol = (s16)firstCol;
+    tile.spriteRecordIdx = (u16)(mFrameLog->sprites.size() - 1);
+    tile.at = mBgData.at;
+    tile.x = mX;
+    tile.mask = mPpuMask;
+    tile.ctrl = mPpuCtrl;
+    tile.row = (u8)row;
+    mFrameLog->tiles.push_back(tile);
 }
 
-bool PPU::isSprite0OnPixel(u8 pixelXPos, u8 pixelYPos, u16 &colorAddress)
+void PPU::submitFrameLog()
 {
-    // Sprite 0 is not in sprite rendering buffer
-    if (!mIsSprite0InRenderBuffer)
-        return false;
+    // Rows without tiles (rendering disabled)
+    u32 tileCount = (u32)mFrameLog->tiles.size();
+    for (; mFrameLogNextRow <= PPU_OUTPUT_HEIGHT; mFrameLogNextRow++)
+        mFrameLog->rowFirstTileIdx[mFrameLogNextRow] = tileCount;
+    mFrameLog = nullptr;
+
+    mBandRenderer->submitRecordingLog();
+    mDisplayedPicture = &mBandRenderer->getPicture();
+    mDisplayedIndexedPicture = &mBandRenderer->getIndexedPicture();
+}
 
-    bool dummyFlag;
-    oamData sprite;
-    u8 ptLsb = mSpritePatternBuffer[0];
-    u8 ptMsb = mSpritePatternBuffer[1];
-    sprite.yPos      = mSpriteRenderBuffer[0];
-    sprite.tileIdx   = mSpriteRenderBuffer[1];
-    sprite.attribute = mSpriteRenderBuffer[2];
-    sprite.xPos      = mSpriteRenderBuffer[3];
-    colorAddress = getColorAddressFromSprite(sprite, ptLsb, ptMsb, pixelXPos, pixelYPos, dummyFlag);
-    if (colorAddress == SPRITE_NOT_IN_RANGE)
-        return false;
-    
-    if ((colorAddress & 0x0003) == 0)
-        // Sprite pixel is transparent
-        return false;
-    
-    return true;
+u64 PPU::flipTileRow(u64 tileRow)
+{
+    // Reverse the pixels (bytes) order
+    tileRow = ((tileRow & 0x00FF'00FF'00FF'00FF) << 8)  | ((tileRow >> 8)  & 0x00FF'00FF'00FF'00FF);
+    tileRow = ((tileRow & 0x0000'FFFF'0000'FFFF) << 16) | ((tileRow >> 16) & 0x0000'FFFF'0000'FFFF);
+    return (tileRow << 32) | (tileRow >> 32);
 }
 
 void PPU::incrementCoarseX()
@@ -0,0 +1,221 @@
+#include "NES/PPUBandRenderer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+PPUBandRenderer::PPUBandRenderer(u32 threadCount, const picture_t& initialPicture, const indexedPicture_t& initialIndexedPicture)
+{
+	mRecordingLog = std::make_unique<PPUFrameLog>();
+	mRenderingLog = std::make_unique<PPUFrameLog>();
+
+	// Worst case: 34 tiles per scanline (pre-render included)
+	constexpr u32 MAX_TILES_PER_FRAME = 34 * (PPU_OUTPUT_HEIGHT + 1);
+	mRecordingLog->tiles.reserve(MAX_TILES_PER_FRAME);
+	mRenderingLog->tiles.reserve(MAX_TILES_PER_FRAME);
+
+	// The first rendered frame is drawn over the current picture
+	mPictures = std::make_unique<picture_t[]>(2);
+	mIndexedPictures = std::make_unique<indexedPicture_t[]>(2);
+	mPictures[0] = initialPicture;
+	mIndexedPictures[0] = initialIndexedPicture;
+	mDisplayedIdx = 0;
+	mRenderingIdx = 1;
+
+	mNextBandIdx = BAND_COUNT;
+	mRemainingBandCount = 0;
+	mFrameIdx = 0;
+	mIsExiting = false;
+
+	for (u32 i = 0; i < threadCount; i++)
+		mWorkers.emplace_back(&PPUBandRenderer::runWorker, this);
+}
+
+PPUBandRenderer::~PPUBandRenderer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsExiting = true;
+	}
+	mWorkCondition.notify_all();
+
+	for (std::thread& worker : mWorkers)
+		worker.join();
+}
+
+void PPUBandRenderer::submitRecordingLog()
+{
+	waitForFrame();
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		// Previous frame is complete -> displayed
+		std::swap(mRecordingLog, mRenderingLog);
+		std::swap(mDisplayedIdx, mRenderingIdx);
+
+		mRemainingBandCount = BAND_COUNT;
+		mNextBandIdx = 0;
+		mFrameIdx++;
+	}
+	mWorkCondition.notify_all();
+}
+
+void PPUBandRenderer::waitForFrame()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDoneCondition.wait(lock, [this]() { return mRemainingBandCount == 0; });
+}
+
+void PPUBandRenderer::runWorker()
+{
+	u64 lastFrameIdx = 0;
+	while (true)
+	{
+		// Wait for a new frame
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWorkCondition.wait(lock, [&]() { return mIsExiting || mFrameIdx != lastFrameIdx; });
+			if (mIsExiting)
+				return;
+
+			lastFrameIdx = mFrameIdx;
+		}
+
+		// Render bands until there are none left
+		u32 renderedBandCount = 0;
+		for (u32 bandIdx = mNextBandIdx++; bandIdx < BAND_COUNT; bandIdx = mNextBandIdx++)
+		{
+			renderBand(bandIdx);
+			renderedBandCount++;
+		}
+
+		if (renderedBandCount > 0)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mRemainingBandCount -= renderedBandCount;
+			if (mRemainingBandCount == 0)
+				mDoneCondition.notify_all();
+		}
+	}
+}
+
+void PPUBandRenderer::renderBand(u32 bandIdx)
+{
+	const PPUFrameLog& log = *mRenderingLog;
+	bool isIndexed = log.pictureFormat == PictureFormat::INDEXED;
+	picture_t& picture = mPictures[mRenderingIdx];
+	indexedPicture_t& indexedPicture = mIndexedPictures[mRenderingIdx];
+
+	u16 firstRow = (u16)(bandIdx * BAND_HEIGHT);
+	u16 endRow = std::min((u16)(firstRow + BAND_HEIGHT), PPU_OUTPUT_HEIGHT);
+
+	// Pixels that are not rendered keep the previous picture (as the PPU does)
+	for (u16 row = firstRow; row < endRow; row++)
+	{
+		if (isIndexed)
+			indexedPicture[row] = mIndexedPictures[mDisplayedIdx][row];
+		else
+			picture[row] = mPictures[mDisplayedIdx][row];
+	}
+
+	u32 firstTileIdx = log.rowFirstTileIdx[firstRow];
+	u32 endTileIdx = log.rowFirstTileIdx[endRow];
+	if (firstTileIdx == endTileIdx)
+		return;
+
+	// Palette at the first tile of the band
+	u32 paletteIdx = 0;
+	while (paletteIdx + 1 < log.palettes.size() && log.palettes[paletteIdx + 1].firstTileIdx <= firstTileIdx)
+		paletteIdx++;
+
+	paletteRgb_t paletteRgb;
+	paletteColorCodes_t colorCodes;
+	u8 paletteMask = log.tiles[firstTileIdx].mask;
+	PPU::computePaletteTables(log.palettes[paletteIdx].paletteRam, paletteMask, paletteRgb, colorCodes);
+
+	// Same work as PPU::renderTilePixels (sprite 0 hit aside), the pixels are composited by runs of tiles
+	std::array<u8, PPU_OUTPUT_WIDTH> bgLinePixels;
+	std::array<u8, PPU_OUTPUT_WIDTH> spriteLinePixels;
+	spriteLineBuffer_t spriteLineBuffer;
+	u32 spriteLineBufferKey = UINT32_MAX;
+	u16 runRow = 0;
+	u8 runMask = paletteMask;
+	s32 runColStart = 0;
+	s32 runColEnd = 0;
+
+	auto composeRun = [&]()
+	{
+		if (runColStart >= runColEnd)
+			return;
+
+		if (isIndexed)
+		{
+			mPixelCompositor.composeIndexedPixels(&bgLinePixels[runColStart],
+			                                      &spriteLinePixels[runColStart],
+			                                      runColEnd - runColStart,
+			                                      colorCodes,
+			                                      PPU::getEmphasisBits(runMask),
+			                                      &indexedPicture[runRow][runColStart]);
+		}
+		else
+		{
+			mPixelCompositor.composePixels(&bgLinePixels[runColStart],
+			                               &spriteLinePixels[runColStart],
+			                               runColEnd - runColStart,
+			                               paletteRgb,
+			                               picture[runRow][runColStart].data());
+		}
+		runColStart = runColEnd;
+	};
+
+	for (u32 tileIdx = firstTileIdx; tileIdx < endTileIdx; tileIdx++)
+	{
+		const PPUTileRecord& tile = log.tiles[tileIdx];
+		s32 colStart = std::max((s32)tile.firstCol, 0);
+		s32 colEnd = std::min((s32)tile.firstCol + 8, (s32)PPU_OUTPUT_WIDTH);
+
+		// Palette or mask changed
+		bool isPaletteChanged = paletteIdx + 1 < log.palettes.size() && log.palettes[paletteIdx + 1].firstTileIdx <= tileIdx;
+		if (isPaletteChanged || tile.mask != runMask)
+		{
+			composeRun();
+			while (paletteIdx + 1 < log.palettes.size() && log.palettes[paletteIdx + 1].firstTileIdx <= tileIdx)
+				paletteIdx++;
+			PPU::computePaletteTables(log.palettes[paletteIdx].paletteRam, tile.mask, paletteRgb, colorCodes);
+			runMask = tile.mask;
+		}
+
+		// Another row, or pixels not next to the run (fine X written mid-scanline)
+		if (tile.row != runRow || colStart != runColEnd)
+		{
+			composeRun();
+			runRow = tile.row;
+			runColStart = colStart;
+		}
+		runColEnd = std::max(colEnd, colStart);
+
+		// Sprites: the line buffer is rebuilt when the sprites, the row or the height change
+		u8 spriteHeight = PPU::getSpriteHeight(tile.ctrl);
+		u32 key = ((u32)tile.spriteRecordIdx << 16) | ((u32)tile.row << 8) | spriteHeight;
+		if ((tile.mask & 0b0001'0000) != 0 && key != spriteLineBufferKey)
+		{
+			const PPUSpriteRecord& sprites = log.sprites[tile.spriteRecordIdx];
+			PPU::buildSpriteLineBuffer(spriteLineBuffer, sprites.renderBuffer, sprites.patternBuffer, spriteHeight, tile.row);
+			spriteLineBufferKey = key;
+		}
+
+		for (u8 i = 0; i < 8; i++)
+		{
+			u16 col = (u16)(tile.firstCol + i);
+			if (col >= PPU_OUTPUT_WIDTH)
+				continue;
+
+			bgLinePixels[col] = PPU::getBgPixel(tile.tileRow, tile.at, tile.v, tile.mask, i, col);
+
+			bool isSpriteRendered = ((tile.mask & 0b0001'0000) != 0) &&
+			                        ((col >= 8) || ((tile.mask & 0b0000'0100) != 0));
+			spriteLinePixels[col] = isSpriteRendered ? spriteLineBuffer[col] : 0;
+		}
+	}
+	composeRun();
+}
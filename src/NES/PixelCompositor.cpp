@@ -0,0 +1,347 @@
+#include "NES/PixelCompositor.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PIXEL_COMPOSITOR_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Kernels are built for their instruction set, whatever the compiler flags are
+// (MSVC allows intrinsics anywhere)
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+static constexpr u8 COLOR_IDX_MASK = 0b0000'0011;
+static constexpr u8 SPRITE_BEHIND_BG = 0b0010'0000;
+static constexpr u8 SPRITE_COLOR_ADDRESS_MASK = 0b0001'1111;
+
+static inline u8 muxPaletteAddress(u8 bgPixel, u8 spritePixel)
+{
+	bool isBgOpaque = (bgPixel & COLOR_IDX_MASK) != 0;
+	bool isSpriteOpaque = (spritePixel & COLOR_IDX_MASK) != 0;
+	bool isSpriteInFront = (spritePixel & SPRITE_BEHIND_BG) == 0;
+
+	// Sprite if opaque & (no BG or sprite priority), else BG if opaque, else backdrop
+	u8 paletteAddress = 0x00;
+	if (isSpriteOpaque && (!isBgOpaque || isSpriteInFront))
+		paletteAddress = spritePixel & SPRITE_COLOR_ADDRESS_MASK;
+	else if (isBgOpaque)
+		paletteAddress = bgPixel;
+
+	return paletteAddress;
+}
+
+static inline void writeRgb(u8 paletteAddress, const paletteRgb_t& paletteRgb, u8* rgbOutput)
+{
+	rgbOutput[0] = paletteRgb[0][paletteAddress];
+	rgbOutput[1] = paletteRgb[1][paletteAddress];
+	rgbOutput[2] = paletteRgb[2][paletteAddress];
+}
+
+PixelCompositor::PixelCompositor()
+{
+	if (!setImplementation(Implementation::AVX2) &&
+	    !setImplementation(Implementation::SSE2))
+		setImplementation(Implementation::SCALAR);
+}
+
+bool PixelCompositor::isImplementationSupported(Implementation implementation)
+{
+#if defined(PIXEL_COMPOSITOR_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+	// CPUID.1:EDX.SSE2, CPUID.1:ECX.OSXSAVE & AVX, XCR0 (XMM & YMM states), CPUID.7:EBX.AVX2
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+	bool isSse2Supported = (cpuInfo[3] & (1 << 26)) != 0;
+	bool isAvxSupported = ((cpuInfo[2] & (1 << 27)) != 0) &&
+	                      ((cpuInfo[2] & (1 << 28)) != 0) &&
+	                      ((_xgetbv(0) & 0x06) == 0x06);
+	__cpuidex(cpuInfo, 7, 0);
+	bool isAvx2Supported = isAvxSupported && ((cpuInfo[1] & (1 << 5)) != 0);
+#else
+	__builtin_cpu_init();
+	bool isSse2Supported = __builtin_cpu_supports("sse2");
+	bool isAvx2Supported = __builtin_cpu_supports("avx2");
+#endif
+#else
+	bool isSse2Supported = false;
+	bool isAvx2Supported = false;
+#endif
+
+	switch (implementation)
+	{
+		case Implementation::SCALAR: return true;
+		case Implementation::SSE2:   return isSse2Supported;
+		case Implementation::AVX2:   return isAvx2Supported;
+		default:                     return false;
+	}
+}
+
+bool PixelCompositor::setImplementation(Implementation implementation)
+{
+	if (!isImplementationSupported(implementation))
+		return false;
+
+	mImplementation = implementation;
+	switch (implementation)
+	{
+		case Implementation::SSE2: 
+			mComposePixelsFunction = composePixelsSse2;
+			mComposeIndexedPixelsFunction = composeIndexedPixelsSse2;
+			break;
+
+		case Implementation::AVX2: 
+			mComposePixelsFunction = composePixelsAvx2;
+			mComposeIndexedPixelsFunction = composeIndexedPixelsAvx2;
+			break;
+
+		default:
+			mComposePixelsFunction = composePixelsScalar;
+			mComposeIndexedPixelsFunction = composeIndexedPixelsScalar;
+			break;
+	}
+
+	return true;
+}
+
+void PixelCompositor::composePixelsScalar(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteRgb_t& paletteRgb, u8* rgbOutput)
+{
+	for (u32 pixelIdx = 0; pixelIdx < pixelCount; pixelIdx++)
+	{
+		u8 paletteAddress = muxPaletteAddress(bgPixels[pixelIdx], spritePixels[pixelIdx]);
+		writeRgb(paletteAddress, paletteRgb, &rgbOutput[pixelIdx * 3]);
+	}
+}
+
+void PixelCompositor::composeIndexedPixelsScalar(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput)
+{
+	for (u32 pixelIdx = 0; pixelIdx < pixelCount; pixelIdx++)
+	{
+		u8 paletteAddress = muxPaletteAddress(bgPixels[pixelIdx], spritePixels[pixelIdx]);
+		indexedOutput[pixelIdx] = colorCodes[paletteAddress] | emphasisBits;
+	}
+}
+
+#if defined(PIXEL_COMPOSITOR_X86)
+
+// ******** SSE2: priority mux of 16 pixels, palette lookup pixel by pixel ******** //
+TARGET_SSE2 static inline __m128i muxPaletteAddressesSse2(__m128i bgPixels, __m128i spritePixels)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i colorIdxMask = _mm_set1_epi8(COLOR_IDX_MASK);
+
+	__m128i isBgTransparent = _mm_cmpeq_epi8(_mm_and_si128(bgPixels, colorIdxMask), zero);
+	__m128i isSpriteTransparent = _mm_cmpeq_epi8(_mm_and_si128(spritePixels, colorIdxMask), zero);
+	__m128i isSpriteInFront = _mm_cmpeq_epi8(_mm_and_si128(spritePixels, _mm_set1_epi8(SPRITE_BEHIND_BG)), zero);
+	__m128i isSpriteShown = _mm_andnot_si128(isSpriteTransparent, _mm_or_si128(isBgTransparent, isSpriteInFront));
+
+	__m128i bgAddresses = _mm_andnot_si128(isBgTransparent, bgPixels);
+	__m128i spriteAddresses = _mm_and_si128(spritePixels, _mm_set1_epi8(SPRITE_COLOR_ADDRESS_MASK));
+	return _mm_or_si128(_mm_and_si128(isSpriteShown, spriteAddresses), _mm_andnot_si128(isSpriteShown, bgAddresses));
+}
+
+TARGET_SSE2 static inline __m128i loadPixelsSse2(const u8* pixels, u32 chunkSize)
+{
+	if (chunkSize == 16)
+		return _mm_loadu_si128((const __m128i*)pixels);
+
+	// Last pixels: padded with transparent pixels
+	alignas(16) u8 paddedPixels[16] = {};
+	std::memcpy(paddedPixels, pixels, chunkSize);
+	return _mm_load_si128((const __m128i*)paddedPixels);
+}
+
+TARGET_SSE2 void PixelCompositor::composePixelsSse2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteRgb_t& paletteRgb, u8* rgbOutput)
+{
+	alignas(16) u8 paletteAddresses[16];
+	for (u32 pixelIdx = 0; pixelIdx < pixelCount; pixelIdx += 16)
+	{
+		u32 chunkSize = (pixelCount - pixelIdx) < 16 ? (pixelCount - pixelIdx) : 16;
+		__m128i bgChunk = loadPixelsSse2(&bgPixels[pixelIdx], chunkSize);
+		__m128i spriteChunk = loadPixelsSse2(&spritePixels[pixelIdx], chunkSize);
+
+		_mm_store_si128((__m128i*)paletteAddresses, muxPaletteAddressesSse2(bgChunk, spriteChunk));
+		for (u32 chunkIdx = 0; chunkIdx < chunkSize; chunkIdx++)
+			writeRgb(paletteAddresses[chunkIdx], paletteRgb, &rgbOutput[(pixelIdx + chunkIdx) * 3]);
+	}
+}
+
+TARGET_SSE2 void PixelCompositor::composeIndexedPixelsSse2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput)
+{
+	alignas(16) u8 paletteAddresses[16];
+	for (u32 pixelIdx = 0; pixelIdx < pixelCount; pixelIdx += 16)
+	{
+		u32 chunkSize = (pixelCount - pixelIdx) < 16 ? (pixelCount - pixelIdx) : 16;
+		__m128i bgChunk = loadPixelsSse2(&bgPixels[pixelIdx], chunkSize);
+		__m128i spriteChunk = loadPixelsSse2(&spritePixels[pixelIdx], chunkSize);
+
+		_mm_store_si128((__m128i*)paletteAddresses, muxPaletteAddressesSse2(bgChunk, spriteChunk));
+		for (u32 chunkIdx = 0; chunkIdx < chunkSize; chunkIdx++)
+			indexedOutput[pixelIdx + chunkIdx] = colorCodes[paletteAddresses[chunkIdx]] | emphasisBits;
+	}
+}
+
+// ******** AVX2: priority mux of 32 pixels, palette lookup & RGB interleave by byte shuffles ******** //
+static constexpr std::array<std::array<u8, 16>, 9> makeRgbInterleaveMasks()
+{
+	// For each 16 bytes of the 48 bytes output: shuffle mask of R, G & B (0x80: zero)
+	std::array<std::array<u8, 16>, 9> masks = {};
+	for (u32 block = 0; block < 3; block++)
+		for (u32 channel = 0; channel < 3; channel++)
+			for (u32 byteIdx = 0; byteIdx < 16; byteIdx++)
+			{
+				u32 outputIdx = block * 16 + byteIdx;
+				masks[block * 3 + channel][byteIdx] = ((outputIdx % 3) == channel) ? (u8)(outputIdx / 3) : 0x80;
+			}
+
+	return masks;
+}
+
+alignas(16) static constexpr std::array<std::array<u8, 16>, 9> RGB_INTERLEAVE_MASKS = makeRgbInterleaveMasks();
+
+TARGET_AVX2 static inline __m256i muxPaletteAddressesAvx2(__m256i bgPixels, __m256i spritePixels)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i colorIdxMask = _mm256_set1_epi8(COLOR_IDX_MASK);
+
+	__m256i isBgTransparent = _mm256_cmpeq_epi8(_mm256_and_si256(bgPixels, colorIdxMask), zero);
+	__m256i isSpriteTransparent = _mm256_cmpeq_epi8(_mm256_and_si256(spritePixels, colorIdxMask), zero);
+	__m256i isSpriteInFront = _mm256_cmpeq_epi8(_mm256_and_si256(spritePixels, _mm256_set1_epi8(SPRITE_BEHIND_BG)), zero);
+	__m256i isSpriteShown = _mm256_andnot_si256(isSpriteTransparent, _mm256_or_si256(isBgTransparent, isSpriteInFront));
+
+	__m256i bgAddresses = _mm256_andnot_si256(isBgTransparent, bgPixels);
+	__m256i spriteAddresses = _mm256_and_si256(spritePixels, _mm256_set1_epi8(SPRITE_COLOR_ADDRESS_MASK));
+	return _mm256_or_si256(_mm256_and_si256(isSpriteShown, spriteAddresses), _mm256_andnot_si256(isSpriteShown, bgAddresses));
+}
+
+TARGET_AVX2 static inline __m128i lookupPaletteTable(__m128i paletteAddresses, const u8* paletteTable)
+{
+	// 32 entries table: low & high halves selected by the address bit 4
+	__m128i tableLow = _mm_loadu_si128((const __m128i*)&paletteTable[0]);
+	__m128i tableHigh = _mm_loadu_si128((const __m128i*)&paletteTable[16]);
+	__m128i isHighHalf = _mm_cmpgt_epi8(paletteAddresses, _mm_set1_epi8(0x0F));
+	return _mm_blendv_epi8(_mm_shuffle_epi8(tableLow, paletteAddresses), _mm_shuffle_epi8(tableHigh, paletteAddresses), isHighHalf);
+}
+
+TARGET_AVX2 static inline void writeRgb16(__m128i paletteAddresses, const paletteRgb_t& paletteRgb, u8* rgbOutput)
+{
+	__m128i red = lookupPaletteTable(paletteAddresses, paletteRgb[0].data());
+	__m128i green = lookupPaletteTable(paletteAddresses, paletteRgb[1].data());
+	__m128i blue = lookupPaletteTable(paletteAddresses, paletteRgb[2].data());
+
+	for (u32 block = 0; block < 3; block++)
+	{
+		__m128i redBytes = _mm_shuffle_epi8(red, _mm_load_si128((const __m128i*)RGB_INTERLEAVE_MASKS[block * 3 + 0].data()));
+		__m128i greenBytes = _mm_shuffle_epi8(green, _mm_load_si128((const __m128i*)RGB_INTERLEAVE_MASKS[block * 3 + 1].data()));
+		__m128i blueBytes = _mm_shuffle_epi8(blue, _mm_load_si128((const __m128i*)RGB_INTERLEAVE_MASKS[block * 3 + 2].data()));
+		_mm_storeu_si128((__m128i*)&rgbOutput[block * 16], _mm_or_si128(_mm_or_si128(redBytes, greenBytes), blueBytes));
+	}
+}
+
+TARGET_AVX2 void PixelCompositor::composePixelsAvx2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteRgb_t& paletteRgb, u8* rgbOutput)
+{
+	u32 pixelIdx = 0;
+	for (; pixelIdx + 32 <= pixelCount; pixelIdx += 32)
+	{
+		__m256i bgChunk = _mm256_loadu_si256((const __m256i*)&bgPixels[pixelIdx]);
+		__m256i spriteChunk = _mm256_loadu_si256((const __m256i*)&spritePixels[pixelIdx]);
+		__m256i paletteAddresses = muxPaletteAddressesAvx2(bgChunk, spriteChunk);
+		writeRgb16(_mm256_castsi256_si128(paletteAddresses), paletteRgb, &rgbOutput[pixelIdx * 3]);
+		writeRgb16(_mm256_extracti128_si256(paletteAddresses, 1), paletteRgb, &rgbOutput[(pixelIdx + 16) * 3]);
+	}
+
+	for (; pixelIdx < pixelCount; pixelIdx += 16)
+	{
+		u32 chunkSize = (pixelCount - pixelIdx) < 16 ? (pixelCount - pixelIdx) : 16;
+		__m128i bgChunk = loadPixelsSse2(&bgPixels[pixelIdx], chunkSize);
+		__m128i spriteChunk = loadPixelsSse2(&spritePixels[pixelIdx], chunkSize);
+		__m128i paletteAddresses = muxPaletteAddressesSse2(bgChunk, spriteChunk);
+		if (chunkSize == 16)
+		{
+			writeRgb16(paletteAddresses, paletteRgb, &rgbOutput[pixelIdx * 3]);
+		}
+		else
+		{
+			// Last pixels: only the valid RGB bytes are copied
+			u8 rgbPadded[48];
+			writeRgb16(paletteAddresses, paletteRgb, rgbPadded);
+			std::memcpy(&rgbOutput[pixelIdx * 3], rgbPadded, chunkSize * 3);
+		}
+	}
+}
+
+TARGET_AVX2 static inline void writeIndexed16(__m128i paletteAddresses, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput)
+{
+	// Color codes widened to 16 bits, with the emphasis bits
+	__m128i codes = lookupPaletteTable(paletteAddresses, colorCodes.data());
+	__m128i emphasis = _mm_set1_epi16((short)emphasisBits);
+	__m128i zero = _mm_setzero_si128();
+	_mm_storeu_si128((__m128i*)&indexedOutput[0], _mm_or_si128(_mm_unpacklo_epi8(codes, zero), emphasis));
+	_mm_storeu_si128((__m128i*)&indexedOutput[8], _mm_or_si128(_mm_unpackhi_epi8(codes, zero), emphasis));
+}
+
+TARGET_AVX2 void PixelCompositor::composeIndexedPixelsAvx2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput)
+{
+	u32 pixelIdx = 0;
+	for (; pixelIdx + 32 <= pixelCount; pixelIdx += 32)
+	{
+		__m256i bgChunk = _mm256_loadu_si256((const __m256i*)&bgPixels[pixelIdx]);
+		__m256i spriteChunk = _mm256_loadu_si256((const __m256i*)&spritePixels[pixelIdx]);
+		__m256i paletteAddresses = muxPaletteAddressesAvx2(bgChunk, spriteChunk);
+		writeIndexed16(_mm256_castsi256_si128(paletteAddresses), colorCodes, emphasisBits, &indexedOutput[pixelIdx]);
+		writeIndexed16(_mm256_extracti128_si256(paletteAddresses, 1), colorCodes, emphasisBits, &indexedOutput[pixelIdx + 16]);
+	}
+
+	for (; pixelIdx < pixelCount; pixelIdx += 16)
+	{
+		u32 chunkSize = (pixelCount - pixelIdx) < 16 ? (pixelCount - pixelIdx) : 16;
+		__m128i bgChunk = loadPixelsSse2(&bgPixels[pixelIdx], chunkSize);
+		__m128i spriteChunk = loadPixelsSse2(&spritePixels[pixelIdx], chunkSize);
+		__m128i paletteAddresses = muxPaletteAddressesSse2(bgChunk, spriteChunk);
+		if (chunkSize == 16)
+		{
+			writeIndexed16(paletteAddresses, colorCodes, emphasisBits, &indexedOutput[pixelIdx]);
+		}
+		else
+		{
+			// Last pixels: only the valid ones are copied
+			u16 indexedPadded[16];
+			writeIndexed16(paletteAddresses, colorCodes, emphasisBits, indexedPadded);
+			std::memcpy(&indexedOutput[pixelIdx], indexedPadded, chunkSize * sizeof(u16));
+		}
+	}
+}
+
+#else
+
+// Never selected without x86 SIMD
+void PixelCompositor::composePixelsSse2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteRgb_t& paletteRgb, u8* rgbOutput)
+{
+	composePixelsScalar(bgPixels, spritePixels, pixelCount, paletteRgb, rgbOutput);
+}
+
+void PixelCompositor::composePixelsAvx2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteRgb_t& paletteRgb, u8* rgbOutput)
+{
+	composePixelsScalar(bgPixels, spritePixels, pixelCount, paletteRgb, rgbOutput);
+}
+
+void PixelCompositor::composeIndexedPixelsSse2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput)
+{
+	composeIndexedPixelsScalar(bgPixels, spritePixels, pixelCount, colorCodes, emphasisBits, indexedOutput);
+}
+
+void PixelCompositor::composeIndexedPixelsAvx2(const u8* bgPixels, const u8* spritePixels, u32 pixelCount, const paletteColorCodes_t& colorCodes, u16 emphasisBits, u16* indexedOutput)
+{
+	composeIndexedPixelsScalar(bgPixels, spritePixels, pixelCount, colorCodes, emphasisBits, indexedOutput);
+}
+
+#endif
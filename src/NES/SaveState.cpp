@@ -0,0 +1,566 @@
+#include "NES/SaveState.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <variant>
+
+#include "NES/Cartridge.hpp"
+
+// Appends the fields to the buffer (its capacity is kept from a save to the next)
+class StateWriter
+{
+public:
+	explicit StateWriter(std::vector<u8>& buffer) : mBuffer(buffer) { mBuffer.clear(); }
+
+	template <typename T>
+	void write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Fields are written as they are in memory");
+		writeBytes(&value, sizeof(T));
+	}
+
+	// Field of the chip field lists (shared with the reader, which checks the values)
+	template <typename T>
+	inline void field(const T& value) { write(value); }
+	inline void check(bool isValid) { (void)isValid; }
+	static constexpr bool IS_READER = false;
+
+	template <typename T>
+	void writeVector(const std::vector<T>& values)
+	{
+		write((u32)values.size());
+		writeBytes(values.data(), values.size() * sizeof(T));
+	}
+
+	void writeBytes(const void* data, size_t size)
+	{
+		const u8* bytes = (const u8*)data;
+		mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+	}
+
+private:
+	std::vector<u8>& mBuffer;
+};
+
+// Reads the fields back, fails (and stays failed) when the buffer is too short
+class StateReader
+{
+public:
+	explicit StateReader(const std::vector<u8>& buffer) : mBuffer(buffer), mIdx(0), mIsValid(true) {}
+
+	template <typename T>
+	bool read(T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Fields are read as they are in memory");
+		return readBytes(&value, sizeof(T));
+	}
+
+	// Fails on another value than 0 or 1 (which is not a valid bool)
+	bool readBool(bool& value)
+	{
+		u8 byte = 0;
+		mIsValid = read(byte) && byte <= 1;
+		value = byte != 0;
+		return mIsValid;
+	}
+
+	// Field of the chip field lists: booleans must be 0 or 1
+	template <typename T>
+	inline void field(T& value)
+	{
+		if constexpr (std::is_same_v<T, bool>)
+			readBool(value);
+		else
+			read(value);
+	}
+	// Fails on an out-of-range value (an index into a table, a dot of the frame...)
+	inline void check(bool isValid) { mIsValid = mIsValid && isValid; }
+	static constexpr bool IS_READER = true;
+
+	// Fails when the size is not the one of the console
+	template <typename T>
+	bool readVector(std::vector<T>& values, u32 expectedSize)
+	{
+		// Same ROM -> same sizes: the vectors are only allocated by the first load
+		u32 size = 0;
+		mIsValid = read(size) && size == expectedSize;
+		if (!mIsValid)
+			return false;
+		values.resize(size);
+		return readBytes(values.data(), size * sizeof(T));
+	}
+
+	bool readBytes(void* data, size_t size)
+	{
+		mIsValid = mIsValid && (size <= mBuffer.size() - mIdx);
+		if (!mIsValid)
+			return false;
+
+		// (empty vectors have no data)
+		if (size > 0)
+			std::memcpy(data, &mBuffer[mIdx], size);
+		mIdx += size;
+		return true;
+	}
+
+	inline bool isValid() const { return mIsValid; }
+	inline bool isAtEnd() const { return mIdx == mBuffer.size(); }
+
+private:
+	const std::vector<u8>& mBuffer;
+	size_t mIdx;
+	bool mIsValid;
+};
+
+static constexpr char SAVE_STATE_MAGIC[4] = { 'N', 'S', 'S', 'T' };
+
+// Field lists of the chips, shared by the writer & the reader (the chips are const when written).
+// The reader checks the values used as table indices, shifts or loop bounds.
+// Not saved (taken from the console the state is loaded into): the ROM shape, the channel identities
+// and the tables.
+class SaveStateSerializer
+{
+public:
+	template <typename Archive, typename CpuType>
+	static void cpu(Archive& archive, CpuType& cpu)
+	{
+		archive.field(cpu.mPc);
+		archive.field(cpu.mSp);
+		archive.field(cpu.mA);
+		archive.field(cpu.mX);
+		archive.field(cpu.mY);
+
+		// Status flags (bit fields): P layout, then the delayed I
+		u8 processorStatus = cpu.getProcessorStatus();
+		bool previousI = cpu.mPreviousI;
+		archive.field(processorStatus);
+		archive.field(previousI);
+		if constexpr (Archive::IS_READER)
+		{
+			cpu.setProcessorStatus(processorStatus);
+			cpu.mB = (processorStatus >> 4) & 0x01;
+			cpu.mU = (processorStatus >> 5) & 0x01;
+			cpu.mPreviousI = previousI;
+		}
+		archive.field(cpu.mIsIDelayed);
+
+		archive.field(cpu.mPredecodedInstruction.isValid);
+		archive.field(cpu.mPredecodedInstruction.pc);
+		archive.field(cpu.mPredecodedInstruction.opcode);
+	}
+
+	template <typename Archive, typename ApuType>
+	static void apu(Archive& archive, ApuType& apu)
+	{
+		archive.field(apu.mPulse1Reg);
+		archive.field(apu.mPulse2Reg);
+		archive.field(apu.mTriangleReg);
+		archive.field(apu.mNoiseReg);
+		archive.field(apu.mDmcReg);
+		archive.field(apu.mStatus);
+		archive.field(apu.mFrameCounterReg);
+
+		frameCounter(archive, apu.mFrameCounter);
+		pulse(archive, apu.mPulse1Channel);
+		pulse(archive, apu.mPulse2Channel);
+		triangle(archive, apu.mTriangleChannel);
+		noise(archive, apu.mNoiseChannel);
+		dmc(archive, apu.mDmcChannel);
+	}
+
+	template <typename Archive, typename PpuStateType>
+	static void ppu(Archive& archive, PpuStateType& ppu)
+	{
+		// Timing: the dot actions are looked up with the scanline & the dot
+		archive.field(ppu.scanlineCount);
+		archive.field(ppu.cycleCount);
+		archive.check(ppu.scanlineCount < PPU_SCANLINES_PER_FRAME && ppu.cycleCount < PPU_DOTS_PER_SCANLINE);
+		archive.field(ppu.isFirstPrerenderPassed);
+		archive.field(ppu.isFrameRenderingSkipped);
+		archive.field(ppu.isImageReady);
+
+		// Registers
+		archive.field(ppu.ppuCtrl);
+		archive.field(ppu.ppuMask);
+		archive.field(ppu.ppuStatus);
+		archive.field(ppu.oamAddr);
+		archive.field(ppu.oamData);
+		archive.field(ppu.ppuScrollX);
+		archive.field(ppu.ppuScrollY);
+		archive.field(ppu.ppuAddr);
+		archive.field(ppu.ppuData);
+		archive.field(ppu.v);
+		archive.field(ppu.t);
+		archive.field(ppu.x);
+		archive.field(ppu.w);
+		archive.check(ppu.x < 8);
+
+		// Background fetches & scanline pixels
+		archive.field(ppu.bgNt);
+		archive.field(ppu.bgAt);
+		archive.field(ppu.bgTileRow);
+		archive.field(ppu.bgLinePixels);
+		archive.field(ppu.spriteLinePixels);
+
+		// OAM: the sprite evaluation indices stop at the end of the OAMs
+		archive.field(ppu.oam);
+		archive.field(ppu.oamSecondary);
+		archive.field(ppu.spriteRenderBuffer);
+		archive.field(ppu.spritePatternBuffer);
+		archive.field(ppu.oamTransfertBuffer);
+		archive.field(ppu.oamSpriteIdx);
+		archive.field(ppu.oamByteIdx);
+		archive.field(ppu.secOamIdx);
+		archive.check(ppu.oamSpriteIdx <= 64 && ppu.oamByteIdx < 4 && ppu.secOamIdx <= ppu.oamSecondary.size());
+		archive.field(ppu.isStoringOamSprite);
+		archive.field(ppu.isNextLineSprite0InRenderBuffer);
+		archive.field(ppu.isSprite0InRenderBuffer);
+
+		archive.field(ppu.paletteRam);
+
+		// NMI
+		archive.field(ppu.vBlankNMISignal);
+		archive.field(ppu.nmiCanOccur);
+	}
+
+	// Registers of the mapper (its type is checked before)
+	template <typename Archive, typename MapperType>
+	static void mapper(Archive& archive, MapperType& mapper)
+	{
+		using ConcreteMapper = std::remove_const_t<MapperType>;
+		if constexpr (!std::is_same_v<ConcreteMapper, std::monostate>)
+			mapperBase(archive, static_cast<std::conditional_t<std::is_const_v<MapperType>, const Mapper, Mapper>&>(mapper));
+
+		if constexpr (std::is_same_v<ConcreteMapper, Mapper001>)
+		{
+			archive.field(mapper.mCpuShiftRegister);
+			archive.field(mapper.mCpuShiftCount);
+			archive.field(mapper.mPrgBankMode);
+			archive.field(mapper.mChrBankMode);
+			archive.field(mapper.mChrBank0Idx);
+			archive.field(mapper.mChrBank1Idx);
+			archive.field(mapper.mPrgBankIdx);
+			archive.check(mapper.mCpuShiftCount < Mapper001::SHIFT_REGISTER_SIZE && mapper.mPrgBankMode < 4 && mapper.mChrBankMode < 2);
+		}
+		else if constexpr (std::is_same_v<ConcreteMapper, Mapper002>)
+		{
+			archive.field(mapper.mPrgBankIdx);
+		}
+		else if constexpr (std::is_same_v<ConcreteMapper, Mapper003>)
+		{
+			archive.field(mapper.mChrBankIdx);
+		}
+		else if constexpr (std::is_same_v<ConcreteMapper, Mapper004>)
+		{
+			archive.field(mapper.mBankSelected);
+			archive.field(mapper.mPrgBankMode);
+			archive.field(mapper.mChrBankMode);
+			archive.check(mapper.mBankSelected < Mapper004::NUM_BANK_REGISTERS && mapper.mPrgBankMode < 2 && mapper.mChrBankMode < 2);
+			archive.field(mapper.mBankRegisters);
+			divider(archive, mapper.mIrqCounter);
+			archive.field(mapper.mPreviousCounter);
+			archive.field(mapper.mPreviousA12);
+			archive.field(mapper.mPpuCycleElapsed);
+			archive.field(mapper.mPreviousPpuCycle);
+			archive.field(mapper.mM2CycleOffset);
+			archive.field(mapper.mIsIrqReloadSet);
+		}
+	}
+
+private:
+	template <typename Archive, typename DividerType>
+	static void divider(Archive& archive, DividerType& divider)
+	{
+		archive.field(divider.mPeriod);
+		archive.field(divider.mCounter);
+	}
+
+	template <typename Archive, typename EnvelopeType>
+	static void envelope(Archive& archive, EnvelopeType& envelope)
+	{
+		divider(archive, envelope.mDivider);
+		archive.field(envelope.mDecayCounter);
+		archive.field(envelope.mVolume);
+		archive.field(envelope.mIsStartFlagClear);
+		archive.field(envelope.mIsLoopFlagSet);
+		archive.field(envelope.mIsConstantVolume);
+	}
+
+	template <typename Archive, typename LengthCounterType>
+	static void lengthCounter(Archive& archive, LengthCounterType& lengthCounter)
+	{
+		archive.field(lengthCounter.mCounter);
+		archive.field(lengthCounter.mIsHaltSet);
+		archive.field(lengthCounter.mIsEnabled);
+	}
+
+	template <typename Archive, typename SweepType>
+	static void sweep(Archive& archive, SweepType& sweep)
+	{
+		divider(archive, sweep.mDivider);
+		archive.field(sweep.mShiftCount);
+		archive.check(sweep.mShiftCount < 8);
+		archive.field(sweep.mIsEnabled);
+		archive.field(sweep.mIsNegating);
+		archive.field(sweep.mIsReloadFlagSet);
+	}
+
+	template <typename Archive, typename FrameCounterType>
+	static void frameCounter(Archive& archive, FrameCounterType& frameCounter)
+	{
+		divider(archive, frameCounter.mApuClockDivider);
+		archive.field(frameCounter.mCycleCount);
+		archive.field(frameCounter.mIs5StepsMode);
+		archive.field(frameCounter.mIsRegBit7Set);
+		archive.field(frameCounter.mIsInterruptInhibited);
+		archive.field(frameCounter.mIsIRQSignalSet);
+		archive.field(frameCounter.mIsEvenCycle);
+		archive.field(frameCounter.mIsEndReached);
+	}
+
+	template <typename Archive, typename PulseType>
+	static void pulse(Archive& archive, PulseType& pulse)
+	{
+		envelope(archive, pulse.mEnvelope);
+		divider(archive, pulse.mTimer);
+		lengthCounter(archive, pulse.mLengthCounter);
+		sweep(archive, pulse.mSweep);
+		archive.field(pulse.mOutput);
+		archive.field(pulse.mDutyCycle);
+		archive.field(pulse.mSequenceIndex);
+		archive.check(pulse.mDutyCycle < APUPulse::SEQUENCER_LUT.size() && pulse.mSequenceIndex < APUPulse::SEQUENCER_LUT[0].size());
+	}
+
+	template <typename Archive, typename TriangleType>
+	static void triangle(Archive& archive, TriangleType& triangle)
+	{
+		divider(archive, triangle.mTimer);
+		lengthCounter(archive, triangle.mLengthCounter);
+		archive.field(triangle.mIsControlFlagSet);
+		archive.field(triangle.mIsCounterReloadFlagSet);
+		archive.field(triangle.mLinCounterReloadValue);
+		archive.field(triangle.mLinearCounterValue);
+		archive.field(triangle.mOutput);
+		archive.field(triangle.mSequenceIndex);
+		archive.check(triangle.mSequenceIndex < APUTriangle::SEQUENCER_LUT.size());
+	}
+
+	template <typename Archive, typename NoiseType>
+	static void noise(Archive& archive, NoiseType& noise)
+	{
+		envelope(archive, noise.mEnvelope);
+		divider(archive, noise.mTimer);
+		lengthCounter(archive, noise.mLengthCounter);
+		archive.field(noise.mShiftRegister);
+		archive.field(noise.mOutput);
+		archive.field(noise.mIsModeFlagSet);
+	}
+
+	template <typename Archive, typename DmcType>
+	static void dmc(Archive& archive, DmcType& dmc)
+	{
+		// Timer & registers
+		divider(archive, dmc.mTimer);
+		archive.field(dmc.mIsIRQSet);
+		archive.field(dmc.mIsIRQSignalSet);
+		archive.field(dmc.mIsLooping);
+		archive.field(dmc.mRateIndex);
+		archive.check(dmc.mRateIndex < dmc.RATE_LUT_NTSC.size());
+		archive.field(dmc.mSampleAddress);
+		archive.field(dmc.mSampleLength);
+
+		// Memory reader
+		archive.field(dmc.mMemReaderAddress);
+		archive.field(dmc.mMemReaderCount);
+
+		// Sample buffer
+		archive.field(dmc.mSampleBuffer);
+		archive.field(dmc.mIsBufferFull);
+
+		// Output unit
+		archive.field(dmc.mShiftRegister);
+		archive.field(dmc.mShifterBitsRemaining);
+		archive.field(dmc.mOutput);
+		archive.field(dmc.mIsSilenced);
+	}
+
+	template <typename Archive, typename MapperType>
+	static void mapperBase(Archive& archive, MapperType& mapper)
+	{
+		// Mirroring: any arrangement fits in the VRAM (four-screen included), a one-screen bank too
+		u8 ntArrangement = (u8)mapper.mNtArrangement;
+		archive.field(ntArrangement);
+		archive.check(ntArrangement <= NametableArrangement::FOUR_SCREEN);
+		if constexpr (Archive::IS_READER)
+			mapper.mNtArrangement = (NametableArrangement)ntArrangement;
+		archive.field(mapper.mVramBankAddressOffset);
+		archive.check(mapper.mVramBankAddressOffset <= PPU_VRAM_SIZE - 0x0400); // 1 kB nametable
+
+		archive.field(mapper.mIsMappingChanged);
+		archive.field(mapper.mIsIrqEnabled);
+		archive.field(mapper.mIsIrqSignalSet);
+	}
+};
+
+// Cycles of an instruction up to the ones to the next event (at most a frame: 29781 CPU cycles)
+static inline bool isSchedulerCycleCount(s32 cpuCycles)
+{
+	return 0 <= cpuCycles && cpuCycles <= 0x10000;
+}
+
+void serializeNesState(const nesState_t& state, u64 romHash, std::vector<u8>& buffer)
+{
+	StateWriter writer(buffer);
+
+	// Header
+	writer.write(SAVE_STATE_MAGIC);
+	writer.write(SAVE_STATE_VERSION);
+	writer.write(romHash);
+
+	// Chips
+	SaveStateSerializer::cpu(writer, state.cpu);
+	SaveStateSerializer::apu(writer, state.apu);
+	SaveStateSerializer::ppu(writer, state.ppu);
+
+	// Memory
+	const memoryState_t& memory = state.memory;
+	writer.write(memory.cpuRam);
+	writer.write(memory.ppuVram);
+	writer.write(memory.oamDma);
+	writer.write(memory.oamDmaBuffer);
+	writer.write(memory.oamDmaIdx);
+	writer.write(memory.isOamDmaStarted);
+	writer.write(memory.isCpuHalt);
+	writer.write(memory.previousIsGetCycle);
+	writer.write(memory.controller1);
+	writer.write(memory.controller2);
+	writer.writeVector(memory.cartridge.prgRam);
+	writer.writeVector(memory.cartridge.chrRam);
+	writer.write((u32)memory.cartridge.mapper.index());
+	std::visit([&](const auto& mapper) { SaveStateSerializer::mapper(writer, mapper); }, memory.cartridge.mapper);
+
+	// Scheduler
+	writer.write(state.cpuCyclesPredicted);
+	writer.write(state.cpuCyclesElapsed);
+	writer.write(state.pendingCpuCycles);
+	writer.write(state.cpuCyclesToNextEvent);
+	writer.write(state.isDmaGetCycle);
+	writer.write(state.isNmiSet);
+	writer.write(state.isIrqSet);
+
+	// Sound: only the deltas up to the last step are written (the rest of the buffer is 0)
+	const blipBufferState_t& blipBuffer = state.blipBuffer;
+	auto lastDelta = std::find_if(blipBuffer.deltas.rbegin(), blipBuffer.deltas.rend(), [](float delta) { return delta != 0.0f; });
+	u32 deltaCount = (u32)(blipBuffer.deltas.rend() - lastDelta);
+	writer.write(blipBuffer.samplesPerClock);
+	writer.write(blipBuffer.nextSamplesPerClock);
+	writer.write(blipBuffer.offset);
+	writer.write(blipBuffer.samplesAvailable);
+	writer.write((u32)blipBuffer.deltas.size());
+	writer.write(deltaCount);
+	writer.writeBytes(blipBuffer.deltas.data(), deltaCount * sizeof(float));
+	writer.write(blipBuffer.integrator);
+	writer.write(blipBuffer.highPass1PreviousInput);
+	writer.write(blipBuffer.highPass1PreviousOutput);
+	writer.write(blipBuffer.highPass2PreviousInput);
+	writer.write(blipBuffer.highPass2PreviousOutput);
+	writer.write(blipBuffer.lowPassPreviousOutput);
+	writer.write(state.blipClock);
+	writer.write(state.apuOutput);
+	writer.write(state.apuSampleClock);
+}
+
+bool deserializeNesState(const std::vector<u8>& buffer, const saveStateShape_t& shape, nesState_t& state)
+{
+	StateReader reader(buffer);
+
+	// Header: same format, same game (so the same mapper & RAM sizes)
+	char magic[4];
+	u32 version;
+	u64 stateRomHash;
+	if (!reader.read(magic) || !reader.read(version) || !reader.read(stateRomHash))
+		return false;
+	if (std::memcmp(magic, SAVE_STATE_MAGIC, sizeof(magic)) != 0 ||
+	    version != SAVE_STATE_VERSION ||
+	    stateRomHash != shape.romHash)
+		return false;
+
+	// Chips
+	SaveStateSerializer::cpu(reader, state.cpu);
+	SaveStateSerializer::apu(reader, state.apu);
+	SaveStateSerializer::ppu(reader, state.ppu);
+
+	// Memory
+	memoryState_t& memory = state.memory;
+	reader.read(memory.cpuRam);
+	reader.read(memory.ppuVram);
+	reader.read(memory.oamDma);
+	reader.read(memory.oamDmaBuffer);
+	reader.read(memory.oamDmaIdx);
+	reader.check(memory.oamDmaIdx <= 256);
+	reader.readBool(memory.isOamDmaStarted);
+	reader.readBool(memory.isCpuHalt);
+	reader.readBool(memory.previousIsGetCycle);
+	reader.read(memory.controller1.shiftRegister);
+	reader.readBool(memory.controller1.isUpdatingState);
+	reader.read(memory.controller2.shiftRegister);
+	reader.readBool(memory.controller2.isUpdatingState);
+	reader.readVector(memory.cartridge.prgRam, shape.prgRamSize);
+	reader.readVector(memory.cartridge.chrRam, shape.chrRamSize);
+	u32 mapperIdx = 0;
+	reader.read(mapperIdx);
+	if (!reader.isValid() || mapperIdx != shape.mapperIdx || mapperIdx != memory.cartridge.mapper.index())
+		return false;
+	std::visit([&](auto& mapper) { SaveStateSerializer::mapper(reader, mapper); }, memory.cartridge.mapper);
+	if (!reader.isValid())
+		return false;
+
+	// Scheduler
+	reader.read(state.cpuCyclesPredicted);
+	reader.read(state.cpuCyclesElapsed);
+	reader.read(state.pendingCpuCycles);
+	reader.read(state.cpuCyclesToNextEvent);
+	reader.readBool(state.isDmaGetCycle);
+	reader.readBool(state.isNmiSet);
+	reader.readBool(state.isIrqSet);
+	reader.check(isSchedulerCycleCount(state.cpuCyclesPredicted) &&
+	             isSchedulerCycleCount(state.cpuCyclesElapsed) &&
+	             isSchedulerCycleCount(state.pendingCpuCycles) &&
+	             isSchedulerCycleCount(state.cpuCyclesToNextEvent));
+
+	// Sound
+	blipBufferState_t& blipBuffer = state.blipBuffer;
+	u32 deltasSize = 0;
+	u32 deltaCount = 0;
+	reader.read(blipBuffer.samplesPerClock);
+	reader.read(blipBuffer.nextSamplesPerClock);
+	reader.read(blipBuffer.offset);
+	reader.read(blipBuffer.samplesAvailable);
+	reader.read(deltasSize);
+	reader.read(deltaCount);
+	if (!reader.isValid() ||
+	    deltasSize != shape.blipDeltasSize ||
+	    deltaCount > deltasSize ||
+	    blipBuffer.samplesAvailable > shape.blipSampleCapacity)
+		return false;
+	blipBuffer.deltas.resize(deltasSize);
+	reader.readBytes(blipBuffer.deltas.data(), deltaCount * sizeof(float));
+	std::fill(blipBuffer.deltas.begin() + deltaCount, blipBuffer.deltas.end(), 0.0f);
+	reader.read(blipBuffer.integrator);
+	reader.read(blipBuffer.highPass1PreviousInput);
+	reader.read(blipBuffer.highPass1PreviousOutput);
+	reader.read(blipBuffer.highPass2PreviousInput);
+	reader.read(blipBuffer.highPass2PreviousOutput);
+	reader.read(blipBuffer.lowPassPreviousOutput);
+	reader.read(state.blipClock);
+	reader.read(state.apuOutput);
+	reader.read(state.apuSampleClock);
+
+	if (!reader.isValid() || !reader.isAtEnd())
+		return false;
+
+	// Derived data
+	Cartridge::decodeTileRows(memory.cartridge.chrRam, memory.cartridge.chrRamTileRows);
+	return true;
+}
@@ -0,0 +1,243 @@
+#include "RewindBuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+template <typename T>
+static void appendValue(std::vector<u8>& buffer, T value)
+{
+	const u8* bytes = (const u8*)&value;
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static T readValue(const std::vector<u8>& buffer, size_t& idx)
+{
+	T value;
+	std::memcpy(&value, &buffer[idx], sizeof(T));
+	idx += sizeof(T);
+	return value;
+}
+
+RewindBuffer::RewindBuffer()
+{
+	mSnapshotWriteIdx.store(0, std::memory_order_relaxed);
+	mSnapshotReadIdx.store(0, std::memory_order_relaxed);
+	mDeltaBytes = 0;
+	mMemoryBudget.store(0, std::memory_order_relaxed);
+	updateStats();
+
+	mIsWorkerRunning.store(true, std::memory_order_relaxed);
+	mWorker = std::thread(&RewindBuffer::runWorker, this);
+}
+
+RewindBuffer::~RewindBuffer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mQueueMutex);
+		mIsWorkerRunning.store(false, std::memory_order_relaxed);
+	}
+	mQueueCondition.notify_one();
+	mWorker.join();
+}
+
+void RewindBuffer::saveFrame(NES& nes)
+{
+	u32 writeIdx = mSnapshotWriteIdx.load(std::memory_order_relaxed);
+	if (writeIdx - mSnapshotReadIdx.load(std::memory_order_acquire) == SNAPSHOT_QUEUE_SIZE)
+		return;
+
+	nes.serializeState(mSnapshots[writeIdx % SNAPSHOT_QUEUE_SIZE]);
+
+	// Published under the queue lock: the worker cannot miss it between its check and its wait
+	{
+		std::lock_guard<std::mutex> lock(mQueueMutex);
+		mSnapshotWriteIdx.store(writeIdx + 1, std::memory_order_release);
+	}
+	mQueueCondition.notify_one();
+}
+
+bool RewindBuffer::loadPreviousFrame(NES& nes)
+{
+	waitForQueuedSnapshots();
+
+	std::lock_guard<std::mutex> lock(mHistoryMutex);
+	if (mDeltas.empty())
+		return false;
+
+	decodeDelta(mDeltas.back(), mLatestSnapshot);
+	mDeltaBytes -= mDeltas.back().size();
+	recycleDelta(mDeltas.back());
+	mDeltas.pop_back();
+	updateStats();
+
+	return nes.deserializeState(mLatestSnapshot);
+}
+
+void RewindBuffer::clear()
+{
+	// A snapshot compressed after the clear would be the base of the next history
+	waitForQueuedSnapshots();
+
+	std::lock_guard<std::mutex> lock(mHistoryMutex);
+	mLatestSnapshot.clear();
+	for (std::vector<u8>& delta : mDeltas)
+		recycleDelta(delta);
+	mDeltas.clear();
+	mDeltaBytes = 0;
+	updateStats();
+}
+
+rewindStats_t RewindBuffer::getStats() const
+{
+	rewindStats_t stats;
+	u32 frameCount = mStoredFrameCount.load(std::memory_order_relaxed);
+	u64 storedBytes = mStoredBytes.load(std::memory_order_relaxed);
+	u64 snapshotSize = mLatestSnapshotSize.load(std::memory_order_relaxed);
+	stats.durationS = frameCount * FRAME_PERIOD_NTSC;
+	stats.storedBytes = storedBytes;
+	stats.compressionRatio = storedBytes > 0 ? (double)((frameCount + 1) * snapshotSize) / storedBytes : 0.0;
+	return stats;
+}
+
+void RewindBuffer::runWorker()
+{
+	while (true)
+	{
+		// Asleep until a snapshot is queued (or the buffer is destroyed)
+		u32 readIdx = mSnapshotReadIdx.load(std::memory_order_relaxed);
+		{
+			std::unique_lock<std::mutex> lock(mQueueMutex);
+			mQueueCondition.wait(lock, [&]()
+			{
+				return !mIsWorkerRunning.load(std::memory_order_relaxed) ||
+				       readIdx != mSnapshotWriteIdx.load(std::memory_order_acquire);
+			});
+		}
+		if (!mIsWorkerRunning.load(std::memory_order_relaxed))
+			return;
+
+		compressSnapshot(mSnapshots[readIdx % SNAPSHOT_QUEUE_SIZE]);
+		mSnapshotReadIdx.store(readIdx + 1, std::memory_order_release);
+	}
+}
+
+void RewindBuffer::waitForQueuedSnapshots()
+{
+	// A few snapshots at most, compressed in tens of microseconds each
+	while (mSnapshotReadIdx.load(std::memory_order_acquire) != mSnapshotWriteIdx.load(std::memory_order_relaxed))
+		std::this_thread::sleep_for(DRAIN_POLL_PERIOD);
+}
+
+void RewindBuffer::compressSnapshot(const std::vector<u8>& snapshot)
+{
+	std::lock_guard<std::mutex> lock(mHistoryMutex);
+
+	// First snapshot: nothing to compress against
+	if (!mLatestSnapshot.empty())
+	{
+		std::vector<u8> delta;
+		if (!mFreeDeltas.empty())
+		{
+			delta = std::move(mFreeDeltas.back());
+			mFreeDeltas.pop_back();
+		}
+
+		encodeDelta(mLatestSnapshot, snapshot, delta);
+		mDeltaBytes += delta.size();
+		mDeltas.push_back(std::move(delta));
+	}
+	mLatestSnapshot = snapshot;
+
+	evictOldestDeltas();
+	updateStats();
+}
+
+void RewindBuffer::evictOldestDeltas()
+{
+	u64 memoryBudget = mMemoryBudget.load(std::memory_order_relaxed);
+	while (!mDeltas.empty() && mDeltaBytes + mLatestSnapshot.size() > memoryBudget)
+	{
+		mDeltaBytes -= mDeltas.front().size();
+		recycleDelta(mDeltas.front());
+		mDeltas.pop_front();
+	}
+}
+
+void RewindBuffer::recycleDelta(std::vector<u8>& delta)
+{
+	if (mFreeDeltas.size() < MAX_FREE_DELTAS)
+		mFreeDeltas.push_back(std::move(delta));
+}
+
+void RewindBuffer::updateStats()
+{
+	mStoredFrameCount.store((u32)mDeltas.size(), std::memory_order_relaxed);
+	mStoredBytes.store(mDeltaBytes + mLatestSnapshot.size(), std::memory_order_relaxed);
+	mLatestSnapshotSize.store(mLatestSnapshot.size(), std::memory_order_relaxed);
+}
+
+void RewindBuffer::encodeDelta(const std::vector<u8>& previous, const std::vector<u8>& current, std::vector<u8>& delta)
+{
+	// The sizes only differ by the sound deltas: the bytes past the end of a snapshot are 0
+	size_t size = std::max(previous.size(), current.size());
+	auto getDiff = [&](size_t idx) -> u8
+	{
+		u8 previousByte = idx < previous.size() ? previous[idx] : 0;
+		u8 currentByte = idx < current.size() ? current[idx] : 0;
+		return previousByte ^ currentByte;
+	};
+	auto isZeroRun = [&](size_t idx)
+	{
+		size_t endIdx = std::min(idx + MIN_ZERO_RUN_LENGTH, size);
+		for (size_t i = idx; i < endIdx; i++)
+			if (getDiff(i) != 0)
+				return false;
+		return true;
+	};
+
+	delta.clear();
+	appendValue(delta, (u32)previous.size());
+
+	size_t idx = 0;
+	while (idx < size)
+	{
+		u16 zeroCount = 0;
+		while (idx < size && zeroCount < MAX_RUN_LENGTH && getDiff(idx) == 0)
+		{
+			zeroCount++;
+			idx++;
+		}
+
+		size_t literalIdx = idx;
+		u16 literalCount = 0;
+		while (idx < size && literalCount < MAX_RUN_LENGTH && !isZeroRun(idx))
+		{
+			literalCount++;
+			idx++;
+		}
+
+		appendValue(delta, zeroCount);
+		appendValue(delta, literalCount);
+		for (size_t i = literalIdx; i < idx; i++)
+			delta.push_back(getDiff(i));
+	}
+}
+
+void RewindBuffer::decodeDelta(const std::vector<u8>& delta, std::vector<u8>& state)
+{
+	size_t deltaIdx = 0;
+	u32 previousSize = readValue<u32>(delta, deltaIdx);
+	state.resize(std::max((size_t)previousSize, state.size()), 0);
+
+	size_t idx = 0;
+	while (deltaIdx < delta.size())
+	{
+		idx += readValue<u16>(delta, deltaIdx);
+		u16 literalCount = readValue<u16>(delta, deltaIdx);
+		for (u16 i = 0; i < literalCount; i++)
+			state[idx++] ^= delta[deltaIdx++];
+	}
+
+	state.resize(previousSize);
+}
@@ -56,4 +56,42 @@ TEST_F(CPUTests, cpuCanExecuteMoreCyclesThanRequested)
 	EXPECT_FALSE(cpu.getN());
 
 	EXPECT_EQ(elapsedCycles, targetCycles);
-}
\ No newline at end of file
+}
+
+TEST_F(CPUTests, cpuPredictsInstructionCyclesWithoutSideEffects)
+{
+	// Target values
+	constexpr u8 targetvalue = 0x42;
+	constexpr s32 targetCycles = LDA_IMM.cycles;
+
+	// Predict
+	memory[TEST_MAIN_ADDRESS] = LDA_IMM.opcode;
+	memory[TEST_MAIN_ADDRESS + 1] = targetvalue;
+	s32 predictedCycles = cpu.predictCyclesToRun(memory, false, false, false);
+
+	// Verify
+	EXPECT_EQ(predictedCycles, targetCycles);
+	EXPECT_EQ(cpu.getPc(), TEST_MAIN_ADDRESS);
+	EXPECT_EQ(cpu.getA(), 0);
+}
+
+TEST_F(CPUTests, cpuExecutesPredecodedInstruction)
+{
+	// Target values
+	constexpr u8 targetvalue = 0x42;
+	constexpr s32 targetCycles = LDA_IMM.cycles;
+
+	// Predict then execute
+	memory[TEST_MAIN_ADDRESS] = LDA_IMM.opcode;
+	memory[TEST_MAIN_ADDRESS + 1] = targetvalue;
+	s32 predictedCycles = cpu.predictCyclesToRun(memory, false, false, false);
+	s32 elapsedCycles = cpu.execute(predictedCycles, memory);
+
+	// Verify
+	EXPECT_EQ(cpu.getPc(), TEST_MAIN_ADDRESS + 2);
+	EXPECT_EQ(cpu.getA(), targetvalue);
+	EXPECT_FALSE(cpu.getZ());
+	EXPECT_FALSE(cpu.getN());
+
+	EXPECT_EQ(elapsedCycles, targetCycles);
+}